@@ -1,13 +1,16 @@
 #pragma once
 
+#include "common/guid_generator.hpp"
+#include "common/hash.hpp"
+
 #include <array>
 #include <cassert>
-#include <charconv>
-#include <chrono>
+#include <cstring>
+#include <functional>
+#include <optional>
 #include <string>
-#include <random>
-#include <limits>
-#include <sstream>
+#include <string_view>
+#include <vector>
 
 namespace floofy
 {
@@ -17,109 +20,281 @@ namespace floofy
 
     using GuidT = std::array<uint8_t, 16>;
 
-    Guid()
+    // Random (v4) GUID from the calling thread's generator, see guid_generator.hpp.
+    Guid() : m_value(GuidGenerator::local().v4())
+    {
+    }
+
+    static Guid generate(GuidVersion version = GuidVersion::V4)
+    {
+      return Guid(GuidGenerator::local().generate(version));
+    }
+
+    static void generate(Guid *guids, size_t count, GuidVersion version = GuidVersion::V4)
     {
-      unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-      std::default_random_engine generator(seed);
-      std::uniform_int_distribution<uint32_t> dist(std::numeric_limits<uint32_t>::min(), std::numeric_limits<uint32_t>::max());
-      for(int i=0; i<16; i+=4) // Doing four entries each iteration due to generating 32bit values;
+      auto &generator = GuidGenerator::local();
+      for (size_t i = 0; i < count; ++i)
       {
-        auto randVal = dist(generator);
-        m_value[i] = static_cast<uint8_t>(randVal);
-        m_value[i+1] = static_cast<uint8_t>(randVal >> 8);
-        m_value[i+2] = static_cast<uint8_t>(randVal >> 16);
-        m_value[i+3] = static_cast<uint8_t>(randVal >> 24);
+        guids[i].m_value = generator.generate(version);
       }
     }
 
-    Guid(GuidT val) : m_value(val)
+    static std::vector<Guid> generate(size_t count, GuidVersion version = GuidVersion::V4)
+    {
+      std::vector<Guid> guids(count, Guid(GuidT{}));
+      generate(guids.data(), count, version);
+      return guids;
+    }
+
+    constexpr Guid(GuidT val) : m_value(val)
     {
 
     }
 
-    Guid(const Guid& guid) : m_value(guid.m_value)
+    // Parses like fromString, a malformed string leaves the invalid (zero) GUID.
+    explicit Guid(std::string_view string) : m_value{}
     {
+      parse(string, *this);
+    }
+
+    // Text form is 8-4-4-4-12 hex digits, upper case when formatted, either
+    // case when parsed.
+    static constexpr size_t STRING_LENGTH = 8 + 1 + 4 + 1 + 4 + 1 + 4 + 1 + 12;
+
+    // Decodes the 32 digits eight at a time and checks them all before looking
+    // at the result, there is no branch per digit. On failure guid is left
+    // untouched and false is returned.
+    static bool parse(std::string_view string, Guid &guid)
+    {
+      if (string.size() != STRING_LENGTH)
+      {
+        return false;
+      }
 
+      const char *str = string.data();
+      uint64_t invalid = 0;
+      const uint32_t words[4] = {
+          decodeHex(load<uint64_t>(str), invalid),
+          decodeHex(load<uint32_t>(str + 9) | uint64_t(load<uint32_t>(str + 14)) << 32, invalid),
+          decodeHex(load<uint32_t>(str + 19) | uint64_t(load<uint32_t>(str + 24)) << 32, invalid),
+          decodeHex(load<uint64_t>(str + 28), invalid)};
+      invalid |= (str[8] ^ '-') | (str[13] ^ '-') | (str[18] ^ '-') | (str[23] ^ '-');
+      if (invalid)
+      {
+        return false;
+      }
+
+      std::memcpy(guid.m_value.data(), words, sizeof(words));
+      return true;
     }
 
-    Guid(const std::string& string)
+    static std::optional<Guid> fromString(std::string_view string)
     {
-      if(string.size() != (8 + 1 + 4 + 1 + 4 + 1 + 4 + 1 + 12))
+      Guid guid{GuidT{}};
+      if (!parse(string, guid))
       {
-        assert(false);
-        return; 
-      } 
-      const char* strData = string.data();
-
-      #define parseValue(strOffset, valOffset) \
-      {\
-        std::from_chars_result result = std::from_chars(strData + (strOffset), strData + (strOffset + 2), m_value[valOffset], 16);\
-        if(result.ec == std::errc::invalid_argument || result.ec == std::errc::result_out_of_range)\
-        {\
-          assert(false);\
-          m_value.fill(0);\
-          return;\
-        }\
-      };
-
-      parseValue(0, 0);
-      parseValue(2, 1);
-      parseValue(4, 2);
-      parseValue(6, 3);
-      // -
-      parseValue(9, 4);
-      parseValue(11, 5);
-      // -
-      parseValue(14, 6);
-      parseValue(16, 7);
-      // - 
-      parseValue(19, 8);
-      parseValue(21, 9);
-      // -
-      parseValue(24, 10);
-      parseValue(26, 11);
-      parseValue(28, 12);
-      parseValue(30, 13);
-      parseValue(32, 14);
-      parseValue(34, 15);
+        return std::nullopt;
+      }
+      return guid;
+    }
+
+    // Writes exactly STRING_LENGTH characters, no terminator, and returns the
+    // end of the written range.
+    char *format(char *out) const
+    {
+      const uint8_t *bytes = m_value.data();
+      const uint64_t words[4] = {
+          encodeHex(load<uint32_t>(bytes)),
+          encodeHex(load<uint32_t>(bytes + 4)),
+          encodeHex(load<uint32_t>(bytes + 8)),
+          encodeHex(load<uint32_t>(bytes + 12))};
+      store(out, words[0]);
+      store(out + 9, static_cast<uint32_t>(words[1]));
+      store(out + 14, static_cast<uint32_t>(words[1] >> 32));
+      store(out + 19, static_cast<uint32_t>(words[2]));
+      store(out + 24, static_cast<uint32_t>(words[2] >> 32));
+      store(out + 28, words[3]);
+      out[8] = out[13] = out[18] = out[23] = '-';
+      return out + STRING_LENGTH;
+    }
+
+    // Compile time counterpart of parse behind the _guid literal. Malformed
+    // text fails to compile when evaluated as a constant, at runtime it gives
+    // the invalid GUID.
+    static constexpr Guid fromLiteral(const char *str, size_t size)
+    {
+      if (size != STRING_LENGTH || str[8] != '-' || str[13] != '-' || str[18] != '-' || str[23] != '-')
+      {
+        return malformedLiteral();
+      }
+
+      GuidT value{};
+      for (size_t i = 0; i < value.size(); ++i)
+      {
+        const size_t offset = 2 * i + (i >= 4) + (i >= 6) + (i >= 8) + (i >= 10);
+        const int hi = literalDigit(str[offset]);
+        const int lo = literalDigit(str[offset + 1]);
+        if (hi < 0 || lo < 0)
+        {
+          return malformedLiteral();
+        }
+        value[i] = static_cast<uint8_t>(hi << 4 | lo);
+      }
+      return Guid(value);
     }
 
     ~Guid() = default;
 
-    GuidT value() const
+    constexpr GuidT value() const
     {
       return m_value;
     }
 
     std::string toString() const
     {
-      static std::string templateVal{"%.2X%.2X%.2X%.2X-%.2X%.2X-%.2X%.2X-%.2X%.2X-%.2X%.2X%.2X%.2X%.2X%.2X"};
-      std::string val; 
-      val.resize(8 + 1 + 4 + 1 + 4 + 1 + 4 + 1 + 12);
-      sprintf(&val[0], templateVal.c_str(), 
-              m_value[0], m_value[1], m_value[2], m_value[3],
-              m_value[4], m_value[5], m_value[6], m_value[7],
-              m_value[8], m_value[9], m_value[10], m_value[11],
-              m_value[12], m_value[13], m_value[14], m_value[15]);
+      std::string val(STRING_LENGTH, '\0');
+      format(&val[0]);
       return val;
     }
 
-    bool operator==(const floofy::Guid& rhs) const
+    // No early exit, so compilers can compare all 16 bytes at once.
+    constexpr bool operator==(const floofy::Guid& rhs) const
     {
-      return m_value == rhs.m_value;
+      uint8_t diff = 0;
+      for (size_t i = 0; i < m_value.size(); ++i)
+      {
+        diff |= m_value[i] ^ rhs.m_value[i];
+      }
+      return diff == 0;
     }
 
-    bool operator!=(const floofy::Guid& rhs) const
+    constexpr bool operator!=(const floofy::Guid& rhs) const
     {
       return !(*this == rhs);
     }
 
-    bool isValid() const
+    // Byte wise, which for v7 GUIDs is creation order.
+    constexpr bool operator<(const floofy::Guid& rhs) const
+    {
+      for (size_t i = 0; i < m_value.size(); ++i)
+      {
+        if (m_value[i] != rhs.m_value[i])
+        {
+          return m_value[i] < rhs.m_value[i];
+        }
+      }
+      return false;
+    }
+
+    constexpr bool operator>(const floofy::Guid& rhs) const { return rhs < *this; }
+    constexpr bool operator<=(const floofy::Guid& rhs) const { return !(rhs < *this); }
+    constexpr bool operator>=(const floofy::Guid& rhs) const { return !(*this < rhs); }
+
+    // RFC 4122 version nibble, 4 for random and 7 for time ordered GUIDs.
+    constexpr int version() const
+    {
+      return m_value[6] >> 4;
+    }
+
+    constexpr bool isValid() const
+    {
+      return *this != Guid(GuidT{});
+    }
+
+    size_t hash() const noexcept
     {
-      return m_value != GuidT{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+      return static_cast<size_t>(hashCombine(hashMix(load<uint64_t>(m_value.data())), load<uint64_t>(m_value.data() + 8)));
     }
 
   private:
+    // The hex codecs work on eight characters packed into an integer, first
+    // character in the lowest byte, so every step handles all of them at once.
+    static constexpr uint64_t ONES = 0x0101010101010101ull;
+    static constexpr uint64_t HIGH_BITS = 0x8080808080808080ull;
+    static constexpr uint64_t EVEN_NIBBLES = 0x000F000F000F000Full;
+
+    // Little-endian host assumed, like the binary dialogue format.
+    template <typename T>
+    static T load(const void *src)
+    {
+      T value;
+      std::memcpy(&value, src, sizeof(T));
+      return value;
+    }
+
+    template <typename T>
+    static void store(void *dst, T value)
+    {
+      std::memcpy(dst, &value, sizeof(T));
+    }
+
+    // High bit of every byte of chars that lies within [lo, hi], chars must
+    // be ASCII so the additions never carry into the next byte.
+    static uint64_t inRange(uint64_t chars, uint8_t lo, uint8_t hi)
+    {
+      const uint64_t atLeastLo = chars + ONES * (0x80 - lo);
+      const uint64_t aboveHi = chars + ONES * (0x7F - hi);
+      return atLeastLo & ~aboveHi & HIGH_BITS;
+    }
+
+    // Eight hex digits to four bytes, first byte in the lowest bits. Bytes
+    // of chars that are not [0-9A-Fa-f] are flagged in invalid.
+    static uint32_t decodeHex(uint64_t chars, uint64_t &invalid)
+    {
+      const uint64_t ascii = chars & ~HIGH_BITS;
+      const uint64_t digit = inRange(ascii, '0', '9');
+      const uint64_t letter = inRange(ascii | (ONES * 0x20), 'a', 'f');
+      invalid |= (chars & HIGH_BITS) | (~(digit | letter) & HIGH_BITS);
+
+      // '0' to '9' end in their value, 'A' to 'F' and 'a' to 'f' in value - 9.
+      const uint64_t nibbles = (chars & (ONES * 0x0F)) + (letter >> 7) * 9;
+      uint64_t bytes = ((nibbles & EVEN_NIBBLES) << 4) | ((nibbles >> 8) & EVEN_NIBBLES);
+      bytes = (bytes | (bytes >> 8)) & 0x0000FFFF0000FFFFull;
+      return static_cast<uint32_t>(bytes | (bytes >> 16));
+    }
+
+    // Four bytes, first byte in the lowest bits, to eight upper case hex digits.
+    static uint64_t encodeHex(uint32_t bytes)
+    {
+      uint64_t spread = (uint64_t(bytes) | (uint64_t(bytes) << 16)) & 0x0000FFFF0000FFFFull;
+      spread = (spread | (spread << 8)) & 0x00FF00FF00FF00FFull;
+      const uint64_t nibbles = ((spread >> 4) & EVEN_NIBBLES) | ((spread & EVEN_NIBBLES) << 8);
+      const uint64_t letters = ((nibbles + ONES * 0x06) >> 4) & ONES;
+      return nibbles + ONES * '0' + letters * ('A' - '9' - 1);
+    }
+
+    static constexpr int literalDigit(char c)
+    {
+      return c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+    }
+
+    static Guid malformedLiteral()
+    {
+      assert(false && "malformed GUID literal");
+      return Guid(GuidT{});
+    }
+
     GuidT m_value;
   };
+
+  namespace literals
+  {
+    // "F964FB23-022B-48CD-99C4-52EAC595B9B0"_guid
+    constexpr Guid operator""_guid(const char *str, size_t size)
+    {
+      return Guid::fromLiteral(str, size);
+    }
+  }
+}
+
+namespace std
+{
+  template <>
+  struct hash<floofy::Guid>
+  {
+    size_t operator()(const floofy::Guid &guid) const noexcept
+    {
+      return guid.hash();
+    }
+  };
 }
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <thread>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //GuidGenerator
+  // Per thread random GUID source. Every thread owns a xoshiro256** state
+  // seeded once from std::random_device, mixed with the thread id and the
+  // clock so a deterministic random_device still gives distinct streams.
+  // Generating a GUID is then two calls into the engine, with no locking and
+  // no reseeding.
+  //
+  // v4 GUIDs are 122 random bits. v7 GUIDs start with the unix time in
+  // milliseconds followed by a 12 bit counter, so GUIDs from one thread sort
+  // in creation order, and end in 62 random bits (RFC 9562, method 1).
+  enum class GuidVersion
+  {
+    V4,
+    V7
+  };
+
+  class GuidGenerator
+  {
+  public:
+    using Bytes = std::array<uint8_t, 16>;
+
+    static GuidGenerator &local()
+    {
+      thread_local GuidGenerator generator;
+      return generator;
+    }
+
+    Bytes generate(GuidVersion version)
+    {
+      return version == GuidVersion::V7 ? v7() : v4();
+    }
+
+    Bytes v4()
+    {
+      Bytes bytes;
+      store(bytes, 0, next());
+      store(bytes, 8, next());
+      return setVersion(bytes, 4);
+    }
+
+    Bytes v7()
+    {
+      const uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                     std::chrono::system_clock::now().time_since_epoch())
+                                                     .count());
+      if (now > _lastMs)
+      {
+        _lastMs = now;
+        // Start low in the counter range to leave room for GUIDs created in
+        // the same millisecond.
+        _counter = static_cast<uint16_t>(next() & 0x3FF);
+      }
+      else if (++_counter > 0xFFF)
+      {
+        // Counter exhausted, borrow the next millisecond to stay ordered.
+        ++_lastMs;
+        _counter = 0;
+      }
+
+      Bytes bytes;
+      store(bytes, 0, (_lastMs << 16) | _counter);
+      store(bytes, 8, next());
+      return setVersion(bytes, 7);
+    }
+
+  private:
+    GuidGenerator()
+    {
+      std::random_device device;
+      uint64_t seed = (uint64_t(device()) << 32) ^ device();
+      seed ^= std::hash<std::thread::id>{}(std::this_thread::get_id());
+      seed ^= static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count()) * 0x9E3779B97F4A7C15ull;
+      for (auto &word : _state)
+      {
+        word = splitMix(seed);
+      }
+    }
+
+    static uint64_t splitMix(uint64_t &seed)
+    {
+      uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+    }
+
+    static uint64_t rotl(uint64_t x, int k)
+    {
+      return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t next()
+    {
+      const uint64_t result = rotl(_state[1] * 5, 7) * 9;
+      const uint64_t t = _state[1] << 17;
+      _state[2] ^= _state[0];
+      _state[3] ^= _state[1];
+      _state[1] ^= _state[2];
+      _state[0] ^= _state[3];
+      _state[2] ^= t;
+      _state[3] = rotl(_state[3], 45);
+      return result;
+    }
+
+    // Big-endian, so the v7 timestamp is the most significant part of the GUID.
+    static void store(Bytes &bytes, size_t offset, uint64_t value)
+    {
+      for (size_t i = 0; i < 8; ++i)
+      {
+        bytes[offset + i] = static_cast<uint8_t>(value >> (56 - 8 * i));
+      }
+    }
+
+    static Bytes &setVersion(Bytes &bytes, uint8_t version)
+    {
+      bytes[6] = static_cast<uint8_t>((bytes[6] & 0x0F) | (version << 4));
+      bytes[8] = static_cast<uint8_t>((bytes[8] & 0x3F) | 0x80);
+      return bytes;
+    }
+
+    uint64_t _state[4];
+    uint64_t _lastMs = 0;
+    uint16_t _counter = 0;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //Hashing
+  // Finalizer of splitmix64. Every input bit affects every output bit, so
+  // keys that differ in a few bits, like v7 GUIDs sharing a timestamp prefix,
+  // still spread over all buckets.
+  constexpr uint64_t hashMix(uint64_t value)
+  {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+  }
+
+  constexpr uint64_t hashCombine(uint64_t seed, uint64_t value)
+  {
+    return hashMix(seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2)));
+  }
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,337 @@
+#pragma once
+
+#include "common/hash.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //InternedString
+  // Immutable, reference counted string shared by every InternedString with
+  // the same contents. Equal strings are stored once, so comparing or hashing
+  // two InternedStrings only looks at their storage address. Storage is freed
+  // when the last reference goes away.
+  //
+  // Pooled strings live in one process wide table split into mutex guarded
+  // shards, so strings can be created from several threads and objects
+  // holding them can move freely between owners. Only creating a string and
+  // dropping its last reference touch the table. A string is a single
+  // allocation holding the count, the cached hash and the null terminated
+  // characters. The empty string needs no storage at all.
+  //
+  // Strings longer than MAX_POOLED_SIZE, long entry lines which are nearly
+  // always unique, skip the table: looking them up costs more than it saves.
+  // Copies of one still share its storage, but two equal long strings created
+  // separately do not, and compare and hash by contents.
+  class InternedString
+  {
+  public:
+    static constexpr size_t MAX_POOLED_SIZE = 32;
+
+    InternedString() = default;
+    explicit InternedString(std::string_view str) : _node(intern(str)) {}
+    explicit InternedString(const char *str) : InternedString(std::string_view(str)) {}
+
+    InternedString(const InternedString &other) noexcept : _node(other._node)
+    {
+      if (_node)
+      {
+        _node->refs.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    InternedString(InternedString &&other) noexcept : _node(std::exchange(other._node, nullptr)) {}
+    InternedString &operator=(InternedString other) noexcept
+    {
+      std::swap(_node, other._node);
+      return *this;
+    }
+    ~InternedString() { release(_node); }
+
+    // The string if it is interned already, without adding it otherwise.
+    // Long strings are never pooled and always returned.
+    static std::optional<InternedString> find(std::string_view str)
+    {
+      if (str.empty() || str.size() > MAX_POOLED_SIZE)
+      {
+        return InternedString(str);
+      }
+
+      const auto hash = hashOf(str);
+      auto &shard = shardFor(hash);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto node = shard.find(str, hash);
+      if (!node)
+      {
+        return std::nullopt;
+      }
+      node->refs.fetch_add(1, std::memory_order_relaxed);
+      return InternedString(node);
+    }
+
+    // Number of distinct strings currently pooled.
+    static size_t numInterned()
+    {
+      size_t count = 0;
+      for (auto &shard : shards())
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.size;
+      }
+      return count;
+    }
+
+    std::string_view view() const { return _node ? std::string_view(_node->chars(), _node->size) : std::string_view{}; }
+    const char *c_str() const { return _node ? _node->chars() : ""; }
+    size_t size() const { return _node ? _node->size : 0; }
+    bool empty() const { return _node == nullptr; }
+
+    size_t hash() const noexcept
+    {
+      return size() > MAX_POOLED_SIZE ? std::hash<std::string_view>{}(view()) : std::hash<const void *>{}(_node);
+    }
+
+    friend bool operator==(const InternedString &lhs, const InternedString &rhs)
+    {
+      return lhs._node == rhs._node || (lhs.size() > MAX_POOLED_SIZE && lhs.view() == rhs.view());
+    }
+    friend bool operator!=(const InternedString &lhs, const InternedString &rhs) { return !(lhs == rhs); }
+    friend bool operator==(const InternedString &lhs, std::string_view rhs) { return lhs.view() == rhs; }
+    friend bool operator!=(const InternedString &lhs, std::string_view rhs) { return lhs.view() != rhs; }
+    friend bool operator==(std::string_view lhs, const InternedString &rhs) { return lhs == rhs.view(); }
+    friend bool operator!=(std::string_view lhs, const InternedString &rhs) { return lhs != rhs.view(); }
+
+  private:
+    // Followed by the characters and a null terminator. The hash is only set
+    // for pooled strings.
+    struct Node
+    {
+      std::atomic<uint32_t> refs;
+      uint32_t size;
+      uint64_t hash;
+
+      const char *chars() const { return reinterpret_cast<const char *>(this + 1); }
+
+      static Node *create(std::string_view str, uint64_t hash)
+      {
+        auto node = new (::operator new(sizeof(Node) + str.size() + 1)) Node{{1}, static_cast<uint32_t>(str.size()), hash};
+        auto chars = reinterpret_cast<char *>(node + 1);
+        std::memcpy(chars, str.data(), str.size());
+        chars[str.size()] = '\0';
+        return node;
+      }
+
+      static void destroy(Node *node)
+      {
+        node->~Node();
+        ::operator delete(node);
+      }
+    };
+
+    // Open addressing with linear probing. Slots keep the hash next to the
+    // node so probing only touches nodes whose hash matches.
+    struct Shard
+    {
+      struct Slot
+      {
+        uint64_t hash = 0;
+        Node *node = nullptr;
+      };
+
+      Node *find(std::string_view str, uint64_t hash) const
+      {
+        if (slots.empty())
+        {
+          return nullptr;
+        }
+
+        const size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+          const auto &slot = slots[i];
+          if (!slot.node)
+          {
+            return nullptr;
+          }
+          if (slot.hash == hash && std::string_view(slot.node->chars(), slot.node->size) == str)
+          {
+            return slot.node;
+          }
+        }
+      }
+
+      void insert(Node *node)
+      {
+        // Kept at most half full.
+        if ((size + 1) * 2 > slots.size())
+        {
+          std::vector<Slot> old(std::max<size_t>(64, slots.size() * 2));
+          old.swap(slots);
+          for (const auto &slot : old)
+          {
+            if (slot.node)
+            {
+              place(slot);
+            }
+          }
+        }
+        place({node->hash, node});
+        ++size;
+      }
+
+      // Backward shift deletion, later slots of the probe run move up so no
+      // tombstones are needed.
+      void erase(Node *node)
+      {
+        const size_t mask = slots.size() - 1;
+        size_t hole = node->hash & mask;
+        while (slots[hole].node != node)
+        {
+          hole = (hole + 1) & mask;
+        }
+
+        for (size_t i = (hole + 1) & mask; slots[i].node; i = (i + 1) & mask)
+        {
+          const size_t home = slots[i].hash & mask;
+          if (((i - home) & mask) >= ((i - hole) & mask))
+          {
+            slots[hole] = slots[i];
+            hole = i;
+          }
+        }
+        slots[hole] = Slot{};
+        --size;
+      }
+
+      void place(const Slot &slot)
+      {
+        const size_t mask = slots.size() - 1;
+        size_t i = slot.hash & mask;
+        while (slots[i].node)
+        {
+          i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+      }
+
+      std::mutex mutex;
+      std::vector<Slot> slots;
+      size_t size = 0;
+    };
+
+    static constexpr size_t NUM_SHARDS = 16;
+
+    explicit InternedString(Node *node) : _node(node) {}
+
+    static std::array<Shard, NUM_SHARDS> &shards()
+    {
+      // Never destroyed, strings held by other statics may outlive it.
+      static auto *shards = new std::array<Shard, NUM_SHARDS>();
+      return *shards;
+    }
+
+    // Mixed to 64 bits, std::hash is only 32 bits wide on 32-bit targets
+    // and would leave the top bits that pick the shard at zero.
+    static uint64_t hashOf(std::string_view str)
+    {
+      return hashMix(std::hash<std::string_view>{}(str));
+    }
+
+    // Low bits pick the slot, the shard comes from the top bits.
+    static Shard &shardFor(uint64_t hash)
+    {
+      return shards()[hash >> 60];
+    }
+    static_assert(NUM_SHARDS == 16, "shardFor uses the top 4 hash bits");
+
+    static Node *intern(std::string_view str)
+    {
+      if (str.empty())
+      {
+        return nullptr;
+      }
+      if (str.size() > MAX_POOLED_SIZE)
+      {
+        return Node::create(str, 0);
+      }
+
+      const auto hash = hashOf(str);
+      auto &shard = shardFor(hash);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (auto node = shard.find(str, hash))
+      {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+        return node;
+      }
+
+      auto node = Node::create(str, hash);
+      shard.insert(node);
+      return node;
+    }
+
+    // Only the last reference of a pooled string takes the shard lock.
+    // Dropping to zero happens under the lock, so a concurrent intern either
+    // finds the node before that and keeps it alive or no longer finds it.
+    static void release(Node *node)
+    {
+      if (!node)
+      {
+        return;
+      }
+
+      if (node->size > MAX_POOLED_SIZE)
+      {
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+          Node::destroy(node);
+        }
+        return;
+      }
+
+      auto refs = node->refs.load(std::memory_order_relaxed);
+      while (refs > 1)
+      {
+        if (node->refs.compare_exchange_weak(refs, refs - 1, std::memory_order_release, std::memory_order_relaxed))
+        {
+          return;
+        }
+      }
+
+      auto &shard = shardFor(node->hash);
+      std::unique_lock<std::mutex> lock(shard.mutex);
+      if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        shard.erase(node);
+        lock.unlock();
+        Node::destroy(node);
+      }
+    }
+
+    Node *_node = nullptr;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
+
+namespace std
+{
+  template <>
+  struct hash<floofy::InternedString>
+  {
+    size_t operator()(const floofy::InternedString &str) const noexcept
+    {
+      return str.hash();
+    }
+  };
+} // namespace std
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //ObjectPool
+  // Typed monotonic pool, objects are constructed in place inside blocks of
+  // contiguous storage and are only destroyed when the pool is cleared or
+  // destroyed. Object addresses are stable for the lifetime of the pool.
+  // Blocks grow geometrically from MinBlockSize, reserve() makes room for
+  // count more objects in a single block when the number is known up front.
+  template <typename T, size_t MinBlockSize = 64>
+  class ObjectPool
+  {
+  public:
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+    ~ObjectPool() { clear(); }
+
+    template <typename... Args>
+    T *create(Args &&... args)
+    {
+      if (_blocks.empty() || _blocks.back().used == _blocks.back().capacity)
+      {
+        addBlock(_blocks.empty() ? MinBlockSize : _blocks.back().capacity * 2);
+      }
+
+      auto &block = _blocks.back();
+      T *object = new (block.objects + block.used) T(std::forward<Args>(args)...);
+      ++block.used;
+      ++_size;
+      return object;
+    }
+
+    void reserve(size_t count)
+    {
+      const size_t available = _blocks.empty() ? 0 : _blocks.back().capacity - _blocks.back().used;
+      if (count > available)
+      {
+        addBlock(std::max(count, MinBlockSize));
+      }
+    }
+
+    void clear()
+    {
+      for (auto &block : _blocks)
+      {
+        std::destroy_n(block.objects, block.used);
+        freeBlock(block);
+      }
+      _blocks.clear();
+      _size = 0;
+    }
+
+    size_t size() const { return _size; }
+
+  private:
+    // Blocks are raw storage so the pool can be declared while T is still
+    // incomplete, T only has to be complete where the pool is used.
+    struct Block
+    {
+      T *objects = nullptr;
+      size_t capacity = 0;
+      size_t used = 0;
+    };
+
+    void addBlock(size_t capacity)
+    {
+      // A partially used block is kept where it is, objects are never moved.
+      if (!_blocks.empty() && _blocks.back().used == 0)
+      {
+        freeBlock(_blocks.back());
+        _blocks.pop_back();
+      }
+
+      _blocks.reserve(_blocks.size() + 1);
+      void *storage = ::operator new(capacity * sizeof(T), std::align_val_t(alignof(T)));
+      _blocks.push_back(Block{static_cast<T *>(storage), capacity, 0});
+    }
+
+    static void freeBlock(Block &block)
+    {
+      ::operator delete(block.objects, std::align_val_t(alignof(T)));
+    }
+
+    std::vector<Block> _blocks;
+    size_t _size = 0;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //parallelFor
+  // Calls fn(i) for every i in [0, count) spread over up to maxThreads threads,
+  // the calling thread included, and returns once all calls are done. Work is
+  // handed out one index at a time, so uneven items still balance. maxThreads
+  // of 0 uses one thread per hardware thread. If fn throws, the remaining
+  // indexes may be skipped and the first exception is rethrown once every
+  // thread has finished.
+  inline size_t hardwareThreads()
+  {
+    const auto threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+  }
+
+  template <typename Fn>
+  void parallelFor(size_t count, Fn &&fn, size_t maxThreads = 0)
+  {
+    const size_t numThreads = std::min(count, maxThreads == 0 ? hardwareThreads() : maxThreads);
+    if (numThreads <= 1)
+    {
+      for (size_t i = 0; i < count; ++i)
+      {
+        fn(i);
+      }
+      return;
+    }
+
+    // The first exception thrown by fn stops handing out work and is
+    // rethrown on the calling thread once every thread has been joined.
+    std::atomic<size_t> next{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    const auto worker = [&next, &fn, &errorMutex, &error, count]() {
+      try
+      {
+        for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+        {
+          fn(i);
+        }
+      }
+      catch (...)
+      {
+        next.store(count, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+      }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    for (size_t t = 1; t < numThreads; ++t)
+    {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads)
+    {
+      thread.join();
+    }
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
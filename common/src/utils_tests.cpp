@@ -1,7 +1,21 @@
 #include "common/guid.hpp"
+#include "common/id.hpp"
+#include "common/interned_string.hpp"
+#include "common/object_pool.hpp"
+#include "common/parallel.hpp"
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 /////////////////////////////////////////////////////////////////////////////
 // Guid Tests
 
@@ -46,4 +60,309 @@ TEST_F(GuidTest, CopyConstructorCreatesEqualGuids)
   EXPECT_EQ(newGuid.toString(), copyGuid.toString());
 }
 
-/////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+TEST_F(GuidTest, ParseAcceptsLowerCaseDigits)
+{
+  auto lower = floofy::Guid::fromString("47d655c2-5a0b-4830-ad70-6e22e9a2a820");
+  ASSERT_TRUE(lower.has_value());
+  EXPECT_EQ(*lower, floofy::Guid{validGuidString});
+  EXPECT_EQ(lower->toString(), validGuidString);
+}
+
+TEST_F(GuidTest, ParseRejectsMalformedStrings)
+{
+  const char *malformed[] = {
+      "",
+      "47D655C2-5A0B-4830-AD70-6E22E9A2A82",
+      "47D655C2-5A0B-4830-AD70-6E22E9A2A8200",
+      "47D655C2_5A0B-4830-AD70-6E22E9A2A820",
+      "47D655C2-5A0B-4830-AD70-6E22E9A2A8G0",
+      "47D655C2-5A0B-4830-AD7-06E22E9A2A820",
+      " 7D655C2-5A0B-4830-AD70-6E22E9A2A820"};
+
+  for (auto string : malformed)
+  {
+    floofy::Guid guid = floofy::Guid::generate();
+    const floofy::Guid before = guid;
+    EXPECT_FALSE(floofy::Guid::parse(string, guid)) << string;
+    EXPECT_EQ(guid, before);
+    EXPECT_FALSE(floofy::Guid::fromString(string).has_value()) << string;
+    EXPECT_FALSE(floofy::Guid{std::string_view{string}}.isValid()) << string;
+  }
+}
+
+TEST_F(GuidTest, FormatRoundTripsGeneratedGuids)
+{
+  char text[floofy::Guid::STRING_LENGTH];
+  for (auto &guid : floofy::Guid::generate(1000))
+  {
+    EXPECT_EQ(guid.format(text), text + sizeof(text));
+    EXPECT_EQ(floofy::Guid::fromString(std::string_view(text, sizeof(text))), guid);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+TEST_F(GuidTest, GeneratedGuidsHaveVersionAndVariantBits)
+{
+  for (auto version : {floofy::GuidVersion::V4, floofy::GuidVersion::V7})
+  {
+    auto guid = floofy::Guid::generate(version);
+    EXPECT_EQ(guid.version(), version == floofy::GuidVersion::V4 ? 4 : 7);
+    EXPECT_EQ(guid.value()[8] & 0xC0, 0x80);
+  }
+  EXPECT_EQ(floofy::Guid{}.version(), 4);
+}
+
+TEST_F(GuidTest, TimeOrderedGuidsSortInCreationOrder)
+{
+  auto guids = floofy::Guid::generate(10000, floofy::GuidVersion::V7);
+  for (size_t i = 1; i < guids.size(); ++i)
+  {
+    EXPECT_LT(guids[i - 1].value(), guids[i].value());
+  }
+}
+
+TEST_F(GuidTest, GuidsGeneratedAcrossThreadsAreUnique)
+{
+  constexpr size_t numThreads = 4;
+  constexpr size_t perThread = 20000;
+  std::vector<std::vector<floofy::Guid>> results(numThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    threads.emplace_back([&results, t]() { results[t] = floofy::Guid::generate(perThread); });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  std::set<floofy::Guid::GuidT> unique;
+  for (const auto &guids : results)
+  {
+    for (const auto &guid : guids)
+    {
+      unique.insert(guid.value());
+    }
+  }
+  EXPECT_EQ(unique.size(), numThreads * perThread);
+}
+
+TEST_F(GuidTest, LiteralIsParsedAtCompileTime)
+{
+  using namespace floofy::literals;
+  constexpr floofy::Guid literal = "47d655c2-5A0B-4830-AD70-6E22E9A2A820"_guid;
+  static_assert(literal.isValid(), "literal must parse");
+  static_assert(literal.version() == 4, "literal must keep its version");
+  static_assert(std::is_trivially_copyable<floofy::Guid>::value, "Guid must be trivially copyable");
+  EXPECT_EQ(literal, floofy::Guid{validGuidString});
+}
+
+TEST_F(GuidTest, OrderingIsByteWise)
+{
+  using namespace floofy::literals;
+  constexpr auto low = "00000000-0000-4000-8000-0000000000FF"_guid;
+  constexpr auto high = "00000000-0000-4000-8000-000000000100"_guid;
+  static_assert(low < high && high > low && low <= high && high >= low && low != high, "ordering");
+
+  auto guids = floofy::Guid::generate(1000);
+  std::sort(guids.begin(), guids.end());
+  for (size_t i = 1; i < guids.size(); ++i)
+  {
+    EXPECT_LT(guids[i - 1].value(), guids[i].value());
+  }
+}
+
+TEST_F(GuidTest, GuidsAndIdsAreUsableAsHashKeys)
+{
+  std::unordered_map<floofy::Guid, size_t> byGuid;
+  std::unordered_set<floofy::ID> ids;
+  const auto guids = floofy::Guid::generate(1000, floofy::GuidVersion::V7);
+  for (size_t i = 0; i < guids.size(); ++i)
+  {
+    byGuid.emplace(guids[i], i);
+    ids.insert(floofy::ID{i});
+  }
+
+  ASSERT_EQ(byGuid.size(), guids.size());
+  for (size_t i = 0; i < guids.size(); ++i)
+  {
+    EXPECT_EQ(byGuid.at(guids[i]), i);
+    EXPECT_EQ(ids.count(floofy::ID{i}), 1u);
+  }
+
+  static_assert(floofy::ID{1} != floofy::ID{2} && floofy::ID{1} < floofy::ID{2}, "ID is constexpr");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// InternedString Tests
+
+TEST(InternedStringTest, EqualStringsShareStorage)
+{
+  floofy::InternedString first{"Tell me more."};
+  floofy::InternedString second{std::string("Tell me more.")};
+  floofy::InternedString other{"Goodbye."};
+
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(first.c_str(), second.c_str());
+  EXPECT_EQ(first.hash(), second.hash());
+  EXPECT_NE(first, other);
+  EXPECT_EQ(first, "Tell me more.");
+  EXPECT_EQ(std::string("Goodbye."), other);
+  EXPECT_EQ(other.size(), 8u);
+
+  floofy::InternedString empty{""};
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(empty, floofy::InternedString{});
+  EXPECT_EQ(empty.view(), "");
+  EXPECT_STREQ(empty.c_str(), "");
+}
+
+TEST(InternedStringTest, StorageIsFreedWithTheLastReference)
+{
+  const std::string text = "Only referenced by this test";
+  EXPECT_FALSE(floofy::InternedString::find(text).has_value());
+  const auto before = floofy::InternedString::numInterned();
+  {
+    floofy::InternedString str{text};
+    auto copy = str;
+    EXPECT_EQ(floofy::InternedString::numInterned(), before + 1);
+
+    auto found = floofy::InternedString::find(text);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(*found, str);
+
+    str = floofy::InternedString{};
+    EXPECT_EQ(floofy::InternedString::numInterned(), before + 1);
+  }
+  EXPECT_EQ(floofy::InternedString::numInterned(), before);
+  EXPECT_FALSE(floofy::InternedString::find(text).has_value());
+}
+
+TEST(InternedStringTest, InterningAcrossThreadsSharesStorage)
+{
+  constexpr size_t numThreads = 4;
+  constexpr size_t numStrings = 64;
+  std::vector<std::vector<floofy::InternedString>> results(numThreads);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    threads.emplace_back([&results, t]() {
+      for (size_t round = 0; round < 100; ++round)
+      {
+        results[t].clear();
+        for (size_t i = 0; i < numStrings; ++i)
+        {
+          results[t].emplace_back("Shared " + std::to_string(i));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < numStrings; ++i)
+  {
+    for (size_t t = 1; t < numThreads; ++t)
+    {
+      EXPECT_EQ(results[t][i].c_str(), results[0][i].c_str());
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// parallelFor Tests
+
+TEST(ParallelForTest, CallsEveryIndexOnce)
+{
+  for (size_t threads : {1, 3, 0})
+  {
+    std::vector<std::atomic<int>> calls(1000);
+    floofy::parallelFor(calls.size(), [&calls](size_t i) { ++calls[i]; }, threads);
+    for (const auto &count : calls)
+    {
+      EXPECT_EQ(count.load(), 1);
+    }
+  }
+
+  bool called = false;
+  floofy::parallelFor(0, [&called](size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+TEST(ParallelForTest, RethrowsTheFirstExceptionAfterJoining)
+{
+  // Whichever thread is handed index 0 throws, the calling one included.
+  for (size_t threads : {1, 3})
+  {
+    std::atomic<int> calls{0};
+    EXPECT_THROW(floofy::parallelFor(
+                     100,
+                     [&calls](size_t i) {
+                       ++calls;
+                       if (i == 0)
+                       {
+                         throw std::runtime_error("failed");
+                       }
+                     },
+                     threads),
+                 std::runtime_error);
+    EXPECT_GE(calls.load(), 1);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ObjectPool Tests
+
+namespace
+{
+  struct Counted
+  {
+    Counted(int value, int &live) : value(value), live(live) { ++live; }
+    ~Counted() { --live; }
+
+    int value;
+    int &live;
+  };
+}
+
+TEST(ObjectPoolTest, CreatedObjectsKeepTheirAddressesAcrossBlocks)
+{
+  int live = 0;
+  floofy::ObjectPool<Counted, 4> pool;
+  std::vector<Counted *> objects;
+  for (int i = 0; i < 100; ++i)
+  {
+    objects.push_back(pool.create(i, live));
+  }
+
+  EXPECT_EQ(pool.size(), 100);
+  EXPECT_EQ(live, 100);
+  for (int i = 0; i < 100; ++i)
+  {
+    EXPECT_EQ(objects[i]->value, i);
+  }
+}
+
+TEST(ObjectPoolTest, ClearAndDestructionDestroyAllObjects)
+{
+  int live = 0;
+  {
+    floofy::ObjectPool<Counted, 4> pool;
+    pool.reserve(10);
+    for (int i = 0; i < 10; ++i)
+    {
+      pool.create(i, live);
+    }
+    pool.clear();
+    EXPECT_EQ(live, 0);
+    EXPECT_EQ(pool.size(), 0);
+
+    pool.create(1, live);
+    EXPECT_EQ(live, 1);
+  }
+  EXPECT_EQ(live, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
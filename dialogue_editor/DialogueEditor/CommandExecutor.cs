@@ -1,4 +1,7 @@
-﻿using System.Collections.Generic;
+﻿using floofy;
+using System;
+using System.Collections.Generic;
+using System.Linq;
 
 namespace DialogueEditor
 {
@@ -11,20 +14,84 @@ namespace DialogueEditor
         void Redo();
     }
 
+    // A command changing the dialogues. The native history records what it
+    // changes and undoes and redoes it, so the command is only executed once.
+    public interface IRecordedCommand
+    {
+        void Execute();
+    }
+
     public class CommandExecutor
     {
+        // The entry of a transaction of the native history.
+        private class RecordedTransaction : IUndoableCommand
+        {
+            private CommandExecutor _cmdExec;
+
+            public RecordedTransaction(CommandExecutor cmdExec)
+            {
+                _cmdExec = cmdExec;
+            }
+
+            public void Execute()
+            {
+            }
+
+            public void Undo()
+            {
+                if (_cmdExec._history.Undo())
+                {
+                    --_cmdExec._numRecorded;
+                    _cmdExec.HistoryApplied?.Invoke(_cmdExec, EventArgs.Empty);
+                }
+            }
+
+            public void Redo()
+            {
+                if (_cmdExec._history.Redo())
+                {
+                    ++_cmdExec._numRecorded;
+                    _cmdExec.HistoryApplied?.Invoke(_cmdExec, EventArgs.Empty);
+                }
+            }
+        }
+
         private Stack<IUndoableCommand> _undoStack;
         private Stack<IUndoableCommand> _redoStack;
+        private DialogueHistory _history = null;
+        // Undoable transactions of the history that have an entry.
+        private int _numRecorded = 0;
+        // Transactions the history had dropped at the last sync.
+        private int _numDropped = 0;
+        private int _depth = 0;
 
         public int UndoCount { get { return _undoStack.Count; } }
         public int RedoCount { get { return _redoStack.Count; } }
 
+        // Raised after undo or redo changed the dialogues, views built from
+        // them must be rebuilt.
+        public event EventHandler HistoryApplied;
+
         public CommandExecutor()
         {
             _undoStack = new Stack<IUndoableCommand>();
             _redoStack = new Stack<IUndoableCommand>();
         }
 
+        // Records the changes of recorded commands from now on, forgetting
+        // every command so far. Transactions the history drops to stay within
+        // its budget lose their entries, and so do the commands before them.
+        public void UseHistory(DialogueHistory history)
+        {
+            _history = history;
+            _undoStack.Clear();
+            _redoStack.Clear();
+            _numRecorded = history == null ? 0 : history.NumUndo;
+            _numDropped = history == null ? 0 : history.NumDropped;
+            _depth = 0;
+            HistoryApplied = null;
+        }
+
         public void ExecuteCommand(IUndoableCommand cmd)
         {
             if (cmd == null)
@@ -32,13 +99,59 @@ namespace DialogueEditor
                 return;
             }
 
+            SyncHistory();
             cmd.Execute();
             _undoStack.Push(cmd);
+            _redoStack.Clear();
+            SyncHistory();
+        }
+
+        public void ExecuteCommand(IRecordedCommand cmd)
+        {
+            if (cmd == null)
+            {
+                return;
+            }
+
+            BeginTransaction();
+            cmd.Execute();
+            CommitTransaction();
+        }
+
+        // Recorded commands executed until the matching commit are undone as
+        // one, transactions nest.
+        public void BeginTransaction()
+        {
+            if (_history == null)
+            {
+                return;
+            }
+
+            if (_depth++ == 0)
+            {
+                SyncHistory();
+            }
+            _history.Begin();
+        }
+
+        public void CommitTransaction()
+        {
+            if (_history == null || _depth == 0)
+            {
+                return;
+            }
+
+            _history.Commit();
+            if (--_depth == 0)
+            {
+                SyncHistory();
+            }
         }
 
         public void UndoLatest()
         {
-            if (_undoStack.Count == 0)
+            SyncHistory();
+            if (_undoStack.Count == 0 || _depth != 0)
             {
                 return;
             }
@@ -46,11 +159,13 @@ namespace DialogueEditor
             IUndoableCommand cmd = _undoStack.Pop();
             cmd.Undo();
             _redoStack.Push(cmd);
+            SyncHistory();
         }
 
         public void RedoLatest()
         {
-            if (_redoStack.Count == 0)
+            SyncHistory();
+            if (_redoStack.Count == 0 || _depth != 0)
             {
                 return;
             }
@@ -58,6 +173,76 @@ namespace DialogueEditor
             IUndoableCommand cmd = _redoStack.Pop();
             cmd.Redo();
             _undoStack.Push(cmd);
+            SyncHistory();
+        }
+
+        #region Private Methods
+
+        // Gives transactions recorded since the last call an entry, changes
+        // made outside of commands included, so that the stacks keep matching
+        // the history. The entries of transactions dropped over budget go
+        // first, the dropped count tells them apart from new ones even when
+        // the number of undoable transactions stays the same. Removing a
+        // dialogue clears the history, the entries of its transactions are
+        // dropped then.
+        private void SyncHistory()
+        {
+            if (_history == null || _depth != 0)
+            {
+                return;
+            }
+
+            var numDropped = _history.NumDropped;
+            if (numDropped != _numDropped)
+            {
+                // Transactions recorded since the last call have no entry and
+                // may have been dropped already.
+                var dropped = Math.Min(numDropped - _numDropped, _numRecorded);
+                _undoStack = WithoutOldestTransactions(_undoStack, dropped);
+                _numRecorded -= dropped;
+                _numDropped = numDropped;
+            }
+
+            var numUndo = _history.NumUndo;
+            if (numUndo < _numRecorded)
+            {
+                _undoStack = WithoutTransactions(_undoStack);
+                _redoStack = WithoutTransactions(_redoStack);
+                _numRecorded = 0;
+            }
+
+            if (numUndo > _numRecorded)
+            {
+                _redoStack.Clear();
+            }
+            for (; _numRecorded < numUndo; ++_numRecorded)
+            {
+                _undoStack.Push(new RecordedTransaction(this));
+            }
         }
+
+        private static Stack<IUndoableCommand> WithoutTransactions(Stack<IUndoableCommand> stack)
+        {
+            // A stack enumerates from the top, it is rebuilt from the bottom.
+            return new Stack<IUndoableCommand>(stack.Where(cmd => !(cmd is RecordedTransaction)).Reverse());
+        }
+
+        // Drops the entries of the oldest transactions along with the commands
+        // before them, undo stops where the history does.
+        private static Stack<IUndoableCommand> WithoutOldestTransactions(Stack<IUndoableCommand> stack, int count)
+        {
+            var commands = stack.Reverse().ToList();
+            var keepFrom = 0;
+            for (; keepFrom < commands.Count && count > 0; ++keepFrom)
+            {
+                if (commands[keepFrom] is RecordedTransaction)
+                {
+                    --count;
+                }
+            }
+            return new Stack<IUndoableCommand>(commands.Skip(keepFrom));
+        }
+
+        #endregion Private Methods
     }
 }
\ No newline at end of file
@@ -12,11 +12,10 @@ namespace DialogueEditor
     {
         #region Internal Data Members
 
-        private class SetChoiceDestUndoableCommand : IUndoableCommand
+        private class SetChoiceDestUndoableCommand : IRecordedCommand
         {
             private ConnectorViewModel _destConnector = null;
             private ConnectionViewModel _connection = null;
-            private ConnectorViewModel _prevConnector = null;
             private DialogueChoice _choice = null;
 
             public SetChoiceDestUndoableCommand(ConnectorViewModel destConnector, ConnectionViewModel connection, DialogueChoice choice)
@@ -35,7 +34,6 @@ namespace DialogueEditor
 
                 if (_connection.DestConnector != null)
                 {
-                    _prevConnector = _connection.DestConnector;
                     _connection.DestConnector.HotspotUpdated -= new EventHandler<EventArgs>(_connection.destConnector_HotspotUpdated);
                     _choice.DestinationEntry = null;
                 }
@@ -53,16 +51,6 @@ namespace DialogueEditor
 
                 _connection.OnPropertyChanged("DestConnector");
             }
-
-            public void Undo()
-            {
-                //TODO do it
-            }
-
-            public void Redo()
-            {
-                //Execute();
-            }
         }
 
         private ConnectorViewModel sourceConnector = null;
@@ -25,32 +25,21 @@ namespace DialogueEditor
 
         #endregion Internal Data Members
 
-        public class SetConnectorContentUndoableCommand : IUndoableCommand
+        public class SetConnectorContentUndoableCommand : IRecordedCommand
         {
-            private string _oldContent, _newContent;
+            private string _newContent;
             private ConnectorViewModel _connector;
 
             public SetConnectorContentUndoableCommand(string newContent, ConnectorViewModel connector)
             {
                 _newContent = newContent;
                 _connector = connector;
-                _oldContent = _connector.Content;
             }
 
             public void Execute()
             {
                 _connector._dialogueChoice.Content = _newContent;
             }
-
-            public void Redo()
-            {
-                Execute();
-            }
-
-            public void Undo()
-            {
-                _connector._dialogueChoice.Content = _oldContent;
-            }
         }
 
         public class GuidCommand : ICommand
@@ -1,4 +1,5 @@
 ﻿using floofy;
+using System;
 using System.Collections.ObjectModel;
 using System.Diagnostics;
 using System.Windows;
@@ -177,6 +178,9 @@ namespace DialogueEditor
             }
         }
 
+        // Bytes the undo history may hold, older edits are forgotten beyond it.
+        private const int HISTORY_BUDGET = 16 * 1024 * 1024;
+
         private NetworkViewModel _network = null;
         private DialogueManager _mgr = null;
         private CommandExecutor _cmdExec = null;
@@ -190,6 +194,8 @@ namespace DialogueEditor
         {
             _mgr = mgr;
             _cmdExec = cmdExec;
+            _cmdExec.UseHistory(DialogueHistory.Attach(_mgr, HISTORY_BUDGET));
+            _cmdExec.HistoryApplied += history_Applied;
             DlgItems = new ObservableCollection<DialogueViewModel>();
             PopulateDialogueList();
         }
@@ -224,17 +230,31 @@ namespace DialogueEditor
 
         public NodeViewModel CreateNode(string name, Point nodeLocation)
         {
+            _cmdExec.BeginTransaction();
             var node = new NodeViewModel(_cmdExec, _currentDlg.AddEntry(_currentDlg.Participant(0), name), _currentDlg, Network)
             {
                 X = nodeLocation.X,
                 Y = nodeLocation.Y
             };
+            _cmdExec.CommitTransaction();
 
             Network.Nodes.Add(node);
 
             return node;
         }
 
+        /// <summary>
+        /// Undo and redo change the dialogue behind the view's back, the
+        /// network is rebuilt from it.
+        /// </summary>
+        private void history_Applied(object sender, EventArgs e)
+        {
+            if (_currentDlg != null)
+            {
+                Network = new NetworkViewModel(_cmdExec, _currentDlg);
+            }
+        }
+
         private void PopulateDialogueList()
         {
             DlgItems.Clear();
@@ -67,6 +67,22 @@ namespace DialogueEditor
             this.ViewModel.ConnectionDragCompleted(newConnection, connectorDraggedOut, connectorDraggedOver);
         }
 
+        /// <summary>
+        /// Event raised when the user has started to drag nodes.
+        /// </summary>
+        private void networkControl_NodeDragStarted(object sender, NodeDragStartedEventArgs e)
+        {
+            this.ViewModel.NodeDragStarted();
+        }
+
+        /// <summary>
+        /// Event raised when the user has finished dragging nodes.
+        /// </summary>
+        private void networkControl_NodeDragCompleted(object sender, NodeDragCompletedEventArgs e)
+        {
+            this.ViewModel.NodeDragCompleted();
+        }
+
         /// <summary>
         /// Event raised to delete the selected node.
         /// </summary>
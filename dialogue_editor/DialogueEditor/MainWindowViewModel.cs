@@ -250,6 +250,11 @@ namespace DialogueEditor
         /// </summary>
         public ConnectionViewModel ConnectionDragStarted(ConnectorViewModel draggedOutConnector, Point curDragPoint)
         {
+            //
+            // Detaching the old connection and attaching the new one are undone as one.
+            //
+            _cmdExec.BeginTransaction();
+
             if (draggedOutConnector.AttachedConnections.Count > 0)
             {
                 Debug.Assert(draggedOutConnector.AttachedConnections.Count == 1);
@@ -309,6 +314,7 @@ namespace DialogueEditor
                 // Maybe the user dragged it out and dropped it in empty space.
                 //
                 DlgModel.Network.Connections.Remove(newConnection);
+                _cmdExec.CommitTransaction();
                 return;
             }
 
@@ -317,6 +323,24 @@ namespace DialogueEditor
             // that the user dropped the connection on.
             //
             newConnection.DestConnector = connectorDraggedOver;
+            _cmdExec.CommitTransaction();
+        }
+
+        /// <summary>
+        /// Called when the user has started to drag nodes.
+        /// </summary>
+        public void NodeDragStarted()
+        {
+            DlgModel.Network.NodeDragStarted();
+        }
+
+        /// <summary>
+        /// Called when the user has finished dragging nodes, they are moved
+        /// in the dialogue then.
+        /// </summary>
+        public void NodeDragCompleted()
+        {
+            DlgModel.Network.NodeDragCompleted();
         }
 
         /// <summary>
@@ -327,6 +351,7 @@ namespace DialogueEditor
             // Take a copy of the nodes list so we can delete nodes while iterating.
             var nodesCopy = DlgModel.Network.Nodes.ToArray();
 
+            _cmdExec.BeginTransaction();
             foreach (var node in nodesCopy)
             {
                 if (node.IsSelected)
@@ -334,6 +359,7 @@ namespace DialogueEditor
                     DeleteNode(node);
                 }
             }
+            _cmdExec.CommitTransaction();
         }
 
         /// <summary>
@@ -13,7 +13,7 @@ namespace DialogueEditor
     {
         #region Undoable Commands
 
-        public class AddParticipantUndoableCommand : IUndoableCommand
+        public class AddParticipantUndoableCommand : IRecordedCommand
         {
             private Dialogue _dialogue = null;
             private Participant _participant = null;
@@ -34,20 +34,22 @@ namespace DialogueEditor
                 _partViewModel = new ParticipantViewModel(_cmdExec, _participant, _dialogue);
                 _viewModel.participants.Add(_partViewModel);
             }
+        }
 
-            public void Undo()
+        public class MoveNodesUndoableCommand : IRecordedCommand
+        {
+            private Dialogue _dialogue = null;
+            private DialogueEntryMove[] _moves = null;
+
+            public MoveNodesUndoableCommand(Dialogue dialogue, DialogueEntryMove[] moves)
             {
-                if (_participant != null)
-                {
-                    _dialogue.RemoveParticipant(_participant.Name);
-                    _viewModel.participants.Remove(_partViewModel);
-                    _participant = null;
-                }
+                _dialogue = dialogue;
+                _moves = moves;
             }
 
-            public void Redo()
+            public void Execute()
             {
-                Execute();
+                _dialogue.MoveEntries(_moves);
             }
         }
 
@@ -61,6 +63,7 @@ namespace DialogueEditor
 
         private Dialogue _dialogue = null;
         private CommandExecutor _cmdExec = null;
+        private bool _draggingNodes = false;
 
         #endregion Internal Data Members
 
@@ -77,41 +80,35 @@ namespace DialogueEditor
 
             var entryToModel = new Dictionary<DialogueEntry, NodeViewModel>();
 
-            for (int i = 0; i < _dialogue.NumEntries; ++i)
+            foreach (DialogueEntryData entryData in _dialogue.EntriesData())
             {
-                DialogueEntry entry = _dialogue.Entry(i);
-                if (entry != null)
-                {
-                    var model = new NodeViewModel(cmdExe, entry, _dialogue, this);
-                    Nodes.Add(model);
+                var entry = new DialogueEntry(entryData.entry);
+                var model = new NodeViewModel(cmdExe, entry, _dialogue, this);
+                Nodes.Add(model);
 
-                    entryToModel.Add(entry, model);
-                }
+                entryToModel.Add(entry, model);
             }
 
-            for (int i = 0; i < _dialogue.NumChoices; ++i)
+            foreach (DialogueChoiceData choiceData in _dialogue.ChoicesData())
             {
-                DialogueChoice choice = _dialogue.Choice(i);
-                if (choice != null)
-                {
-                    var connection = new ConnectionViewModel(cmdExe, choice);
-                    Connections.Add(connection);
+                var choice = new DialogueChoice(choiceData.choice);
+                var connection = new ConnectionViewModel(cmdExe, choice);
+                Connections.Add(connection);
 
-                    if (choice.SourceEntry != null && choice.DestinationEntry != null)
+                if (choiceData.src != IntPtr.Zero && choiceData.dst != IntPtr.Zero)
+                {
+                    NodeViewModel srcNode = entryToModel[new DialogueEntry(choiceData.src)];
+                    foreach (ConnectorViewModel connector in srcNode.OutgoingConnectors)
                     {
-                        NodeViewModel srcNode = entryToModel[choice.SourceEntry];
-                        foreach (ConnectorViewModel connector in srcNode.OutgoingConnectors)
+                        if (connector.DialogueChoice.Equals(choice))
                         {
-                            if (connector.DialogueChoice.Equals(choice))
-                            {
-                                connection.SourceConnector = connector;
-                                break;
-                            }
+                            connection.SourceConnector = connector;
+                            break;
                         }
-
-                        NodeViewModel dstNode = entryToModel[choice.DestinationEntry];
-                        connection.DestConnector = dstNode.IncomingConnector;
                     }
+
+                    NodeViewModel dstNode = entryToModel[new DialogueEntry(choiceData.dst)];
+                    connection.DestConnector = dstNode.IncomingConnector;
                 }
             }
 
@@ -173,6 +170,59 @@ namespace DialogueEditor
             _cmdExec.ExecuteCommand(new AddParticipantUndoableCommand(_cmdExec, _dialogue, this));
         }
 
+        /// <summary>
+        /// Whether nodes are being dragged, their positions are then only
+        /// shown until the drag completes.
+        /// </summary>
+        public bool DraggingNodes
+        {
+            get
+            {
+                return _draggingNodes;
+            }
+        }
+
+        public void NodeDragStarted()
+        {
+            _draggingNodes = true;
+        }
+
+        /// <summary>
+        /// Moves the dragged nodes' entries in one batch, which is undone as
+        /// one and replaces a native call per node and frame.
+        /// </summary>
+        public void NodeDragCompleted()
+        {
+            _draggingNodes = false;
+
+            var moves = new List<DialogueEntryMove>();
+            Dictionary<IntPtr, int> ids = null;
+            foreach (NodeViewModel node in Nodes)
+            {
+                var position = node.TakeDragPosition();
+                if (!position.HasValue)
+                {
+                    continue;
+                }
+
+                if (ids == null)
+                {
+                    ids = new Dictionary<IntPtr, int>();
+                    foreach (DialogueEntryData entryData in _dialogue.EntriesData())
+                    {
+                        ids.Add(entryData.entry, entryData.id);
+                    }
+                }
+
+                moves.Add(new DialogueEntryMove { id = ids[node.DialogueEntry._ptr], positionX = position.Value.x, positionY = position.Value.y });
+            }
+
+            if (moves.Count != 0)
+            {
+                _cmdExec.ExecuteCommand(new MoveNodesUndoableCommand(_dialogue, moves.ToArray()));
+            }
+        }
+
         #region Private Methods
 
         private void connections_ItemsRemoved(object sender, CollectionItemsChangedEventArgs e)
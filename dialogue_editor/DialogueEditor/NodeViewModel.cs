@@ -38,7 +38,7 @@ namespace DialogueEditor
     {
         #region Undoable Commands
 
-        public class AddChoiceUndoableCommand : IUndoableCommand
+        public class AddChoiceUndoableCommand : IRecordedCommand
         {
             private ImpObservableCollection<ConnectorViewModel> _outgoingConnectors;
             private ConnectorViewModel _connector = null;
@@ -63,81 +63,45 @@ namespace DialogueEditor
                 _connector = new ConnectorViewModel(_cmdExec, _dialogue.AddChoice(_dialogueEntry, _content), _node);
                 _outgoingConnectors.Add(_connector);
             }
-
-            public void Undo()
-            {
-                _dialogue.RemoveChoice(_connector.DialogueChoice);
-                _outgoingConnectors.Remove(_connector);
-                _connector = null;
-            }
-
-            public void Redo()
-            {
-                Execute();
-            }
         }
 
-        public class SetNodeContentUndoableCommand : IUndoableCommand
+        public class SetNodeContentUndoableCommand : IRecordedCommand
         {
-            private string _oldContent, _newContent;
+            private string _newContent;
             private NodeViewModel _node;
 
             public SetNodeContentUndoableCommand(string newContent, NodeViewModel node)
             {
                 _newContent = newContent;
                 _node = node;
-                _oldContent = _node.Content;
             }
 
             public void Execute()
             {
                 _node._dialogueEntry.Content = _newContent;
             }
-
-            public void Redo()
-            {
-                Execute();
-            }
-
-            public void Undo()
-            {
-                _node._dialogueEntry.Content = _oldContent;
-            }
         }
 
-        public class SetNodePositionUndoableCommand : IUndoableCommand
+        public class SetNodePositionUndoableCommand : IRecordedCommand
         {
-            private Vector2 _oldPosition, _newPosition;
+            private Vector2 _newPosition;
             private NodeViewModel _node;
 
             public SetNodePositionUndoableCommand(Vector2 newPosition, NodeViewModel node)
             {
                 _newPosition = newPosition;
                 _node = node;
-                _oldPosition.x = node.X;
-                _oldPosition.y = node.Y;
             }
 
             public void Execute()
             {
                 _node._dialogueEntry.Pos = _newPosition;
             }
-
-            public void Redo()
-            {
-                Execute();
-            }
-
-            public void Undo()
-            {
-                _node._dialogueEntry.Pos = _oldPosition;
-            }
         }
 
-        public class SetNodeReactionsUndoableCommand : IUndoableCommand
+        public class SetNodeReactionsUndoableCommand : IRecordedCommand
         {
-            private Reaction _oldL, _newL;
-            private Reaction _oldR, _newR;
+            private Reaction _newL, _newR;
             private NodeViewModel _node;
 
             public SetNodeReactionsUndoableCommand(Reaction newL, Reaction newR, NodeViewModel node)
@@ -145,8 +109,6 @@ namespace DialogueEditor
                 _newL = newL;
                 _newR = newR;
                 _node = node;
-                _oldL = node.LeftReaction;
-                _oldR = node.RightReaction;
             }
 
             public void Execute()
@@ -154,17 +116,6 @@ namespace DialogueEditor
                 _node._dialogueEntry.LeftReaction = _newL;
                 _node._dialogueEntry.RightReaction = _newR;
             }
-
-            public void Redo()
-            {
-                Execute();
-            }
-
-            public void Undo()
-            {
-                _node._dialogueEntry.LeftReaction = _oldL;
-                _node._dialogueEntry.RightReaction = _oldR;
-            }
         }
 
         #endregion Undoable Commands
@@ -180,6 +131,9 @@ namespace DialogueEditor
         private DialogueEntry _dialogueEntry = null;
         private CommandExecutor _cmdExec = null;
         private NetworkViewModel _network = null;
+        // Where the node is shown while it is dragged, the dialogue is only
+        // changed once the drag completes.
+        private Vector2? _dragPosition = null;
 
         #endregion Internal Data Members
 
@@ -192,13 +146,9 @@ namespace DialogueEditor
 
             incomingConnector = new ConnectorViewModel(_cmdExec, null, this);
 
-            for (int i = 0; i < entry.NumChoices; ++i)
+            foreach (DialogueChoice choice in entry.Choices())
             {
-                DialogueChoice choice = entry.Choice(i);
-                if (choice != null)
-                {
-                    OutgoingConnectors.Add(new ConnectorViewModel(_cmdExec, choice, this));
-                }
+                OutgoingConnectors.Add(new ConnectorViewModel(_cmdExec, choice, this));
             }
         }
 
@@ -256,12 +206,19 @@ namespace DialogueEditor
         {
             get
             {
-                return _dialogueEntry.Pos.x;
+                return _dragPosition.HasValue ? _dragPosition.Value.x : _dialogueEntry.Pos.x;
             }
             set
             {
-                if (_dialogueEntry.Pos.x == value)
+                if (X == value)
+                {
+                    return;
+                }
+
+                if (_network != null && _network.DraggingNodes)
                 {
+                    _dragPosition = new Vector2 { x = value, y = Y };
+                    OnPropertyChanged("X");
                     return;
                 }
 
@@ -275,15 +232,22 @@ namespace DialogueEditor
         {
             get
             {
-                return _dialogueEntry.Pos.y;
+                return _dragPosition.HasValue ? _dragPosition.Value.y : _dialogueEntry.Pos.y;
             }
             set
             {
-                if (_dialogueEntry.Pos.y == value)
+                if (Y == value)
                 {
                     return;
                 }
 
+                if (_network != null && _network.DraggingNodes)
+                {
+                    _dragPosition = new Vector2 { x = X, y = value };
+                    OnPropertyChanged("Y");
+                    return;
+                }
+
                 _cmdExec.ExecuteCommand(new SetNodePositionUndoableCommand(new Vector2 { x = _dialogueEntry.Pos.x, y = value }, this));
 
                 OnPropertyChanged("Y");
@@ -406,6 +370,17 @@ namespace DialogueEditor
             }
         }
 
+        /// <summary>
+        /// The position the node was dragged to, if it was, which is no
+        /// longer kept once the dialogue has been changed.
+        /// </summary>
+        internal Vector2? TakeDragPosition()
+        {
+            var position = _dragPosition;
+            _dragPosition = null;
+            return position;
+        }
+
         #region Private Methods
 
         /// <summary>
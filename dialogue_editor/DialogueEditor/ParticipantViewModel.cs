@@ -6,34 +6,23 @@ namespace DialogueEditor
     {
         #region Undoable Commands
 
-        public class SetNameUndoableCommand : IUndoableCommand
+        public class SetNameUndoableCommand : IRecordedCommand
         {
             private Dialogue _dialogue = null;
             private Participant _participant = null;
-            private string _name, _oldName;
+            private string _name;
 
             public SetNameUndoableCommand(Dialogue dialogue, Participant participant, string name)
             {
                 _dialogue = dialogue;
                 _participant = participant;
                 _name = name;
-                _oldName = _participant.Name;
             }
 
             public void Execute()
             {
                 _participant.Name = _name;
             }
-
-            public void Undo()
-            {
-                _participant.Name = _oldName;
-            }
-
-            public void Redo()
-            {
-                Execute();
-            }
         }
 
         #endregion Undoable Commands
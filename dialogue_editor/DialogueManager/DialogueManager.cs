@@ -10,6 +10,128 @@ namespace floofy
         public double y;
     }
 
+    // Mirrors of the plain records in dialogue_manager_api.h, filled in bulk by
+    // Dialogue.ParticipantsData, EntriesData and ChoicesData.
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ParticipantData
+    {
+        public IntPtr participant;
+        public IntPtr name;
+        public int id;
+        public int nameLength;
+
+        public string Name { get { return Native.Utf8String(name, nameLength); } }
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DialogueEntryData
+    {
+        public IntPtr entry;
+        public IntPtr activeParticipant;
+        public IntPtr content;
+        public double positionX;
+        public double positionY;
+        public int id;
+        public int participantId;
+        public int contentLength;
+        public int numChoices;
+        public int lReaction;
+        public int rReaction;
+
+        public string Content { get { return Native.Utf8String(content, contentLength); } }
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DialogueChoiceData
+    {
+        public IntPtr choice;
+        public IntPtr src;
+        public IntPtr dst;
+        public IntPtr content;
+        public int id;
+        public int srcId;
+        public int dstId;
+        public int contentLength;
+        public int guidAssigned;
+
+        public string Content { get { return Native.Utf8String(content, contentLength); } }
+    }
+
+    // Mirrors of the records taken by the batch edits, Dialogue.MoveEntries,
+    // RelinkChoices, AddEntries and AddChoices. _size_t is 32 bits on
+    // Windows, so a move has 4 bytes of padding between its id and its
+    // position, which sequential layout reproduces by aligning the doubles.
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DialogueEntryMove
+    {
+        public int id;
+        public double positionX;
+        public double positionY;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DialogueChoiceRelink
+    {
+        // DIALOGUE_INVALID_INDEX, clears the destination.
+        public const int NoDestination = -1;
+
+        public int id;
+        public int dstId;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct DialogueEntryCreate
+    {
+        public IntPtr activeParticipant;
+        public IntPtr content;
+        public int contentLength;
+        public double positionX;
+        public double positionY;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct DialogueChoiceCreate
+    {
+        public IntPtr src;
+        public IntPtr dst;
+        public IntPtr content;
+        public int contentLength;
+    }
+
+    internal static class Native
+    {
+        public static string Utf8String(IntPtr ptr, int length)
+        {
+            if (ptr == IntPtr.Zero || length <= 0)
+            {
+                return string.Empty;
+            }
+
+            byte[] utf8 = new byte[length];
+            Marshal.Copy(ptr, utf8, 0, length);
+            return Encoding.UTF8.GetString(utf8);
+        }
+
+        // Encodes the strings one after another into a single buffer, string i
+        // ends at ends[i].
+        public static byte[] Utf8Strings(string[] strings, int[] ends)
+        {
+            int size = 0;
+            for (int i = 0; i < strings.Length; ++i)
+            {
+                size += Encoding.UTF8.GetByteCount(strings[i]);
+                ends[i] = size;
+            }
+
+            byte[] utf8 = new byte[size];
+            for (int i = 0, start = 0; i < strings.Length; start = ends[i++])
+            {
+                Encoding.UTF8.GetBytes(strings[i], 0, strings[i].Length, utf8, start);
+            }
+            return utf8;
+        }
+    }
+
     public class DialogueManager
     {
         #region PInvoke
@@ -47,6 +169,9 @@ namespace floofy
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern IntPtr dialogueFromIndex(IntPtr mgr, int index);
 
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern IntPtr choiceFromGuid(IntPtr mgr, IntPtr guid);
+
         #endregion PInvoke
 
         public DialogueManager()
@@ -142,6 +267,17 @@ namespace floofy
             }
         }
 
+        public DialogueChoice ChoiceFromGuid(Guid guid)
+        {
+            if (guid == null || guid._ptr == IntPtr.Zero)
+            {
+                return null;
+            }
+
+            var choice = choiceFromGuid(_ptr, guid._ptr);
+            return choice == IntPtr.Zero ? null : new DialogueChoice(choice);
+        }
+
         public void RemoveDialogue(string name)
         {
             Dialogue dlg = this.Dialogue(name);
@@ -159,6 +295,109 @@ namespace floofy
         public IntPtr _ptr;
     }
 
+    // Native undo log of a manager. Every change made to the manager's
+    // dialogues is recorded while it exists, changes between Begin and Commit
+    // are undone and redone as one.
+    public class DialogueHistory
+    {
+        #region PInvoke
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern IntPtr newDialogueHistory(IntPtr mgr, int budget);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern void freeDialogueHistory(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern void dialogueHistoryBegin(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern void dialogueHistoryCommit(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        private static extern bool dialogueHistoryUndo(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        [return: MarshalAs(UnmanagedType.I1)]
+        private static extern bool dialogueHistoryRedo(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int dialogueHistoryNumUndo(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int dialogueHistoryNumRedo(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int dialogueHistoryNumDropped(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int dialogueHistoryBytes(IntPtr history);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern void setDialogueHistoryBudget(IntPtr history, int budget);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern void clearDialogueHistory(IntPtr history);
+
+        #endregion PInvoke
+
+        // A budget of 0 keeps every transaction. Null when the manager already
+        // has a history.
+        public static DialogueHistory Attach(DialogueManager mgr, int budget)
+        {
+            var history = newDialogueHistory(mgr._ptr, budget);
+            return history == IntPtr.Zero ? null : new DialogueHistory { _ptr = history };
+        }
+
+        ~DialogueHistory()
+        {
+            if (_ptr != IntPtr.Zero)
+                freeDialogueHistory(_ptr);
+        }
+
+        public int NumUndo { get { return dialogueHistoryNumUndo(_ptr); } }
+        public int NumRedo { get { return dialogueHistoryNumRedo(_ptr); } }
+        // Transactions dropped to stay within the budget, it only grows.
+        public int NumDropped { get { return dialogueHistoryNumDropped(_ptr); } }
+        public int Bytes { get { return dialogueHistoryBytes(_ptr); } }
+
+        public int Budget
+        {
+            set
+            {
+                setDialogueHistoryBudget(_ptr, value);
+            }
+        }
+
+        public void Begin()
+        {
+            dialogueHistoryBegin(_ptr);
+        }
+
+        public void Commit()
+        {
+            dialogueHistoryCommit(_ptr);
+        }
+
+        public bool Undo()
+        {
+            return dialogueHistoryUndo(_ptr);
+        }
+
+        public bool Redo()
+        {
+            return dialogueHistoryRedo(_ptr);
+        }
+
+        public void Clear()
+        {
+            clearDialogueHistory(_ptr);
+        }
+
+        public IntPtr _ptr;
+    }
+
     public class Dialogue
     {
         #region PInvoke
@@ -221,9 +460,33 @@ namespace floofy
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern void setDialogueName(IntPtr dialogue, byte[] name, int bufferSize);
 
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern IntPtr dialogueNameView(IntPtr dialogue, out int length);
+
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern void freeDialogue(IntPtr dialogue);
 
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int dialogueParticipantsData(IntPtr dialogue, [Out] ParticipantData[] data, int capacity);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int dialogueEntriesData(IntPtr dialogue, [Out] DialogueEntryData[] data, int capacity);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int dialogueChoicesData(IntPtr dialogue, [Out] DialogueChoiceData[] data, int capacity);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int moveDialogueEntries(IntPtr dialogue, DialogueEntryMove[] moves, int count);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int relinkDialogueChoices(IntPtr dialogue, DialogueChoiceRelink[] relinks, int count);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern void addDialogueEntries(IntPtr dialogue, DialogueEntryCreate[] records, int count, [Out] IntPtr[] created);
+
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern void addDialogueChoices(IntPtr dialogue, DialogueChoiceCreate[] records, int count, [Out] IntPtr[] created);
+
         #endregion PInvoke
 
         public Dialogue(IntPtr ptr)
@@ -264,9 +527,9 @@ namespace floofy
         {
             get
             {
-                byte[] utf8 = new byte[1024];
-                dialogueName(_ptr, utf8, 1024);
-                return Encoding.UTF8.GetString(utf8).Trim('\0');
+                int length;
+                IntPtr utf8 = dialogueNameView(_ptr, out length);
+                return Native.Utf8String(utf8, length);
             }
 
             set
@@ -406,6 +669,108 @@ namespace floofy
             }
         }
 
+        public ParticipantData[] ParticipantsData()
+        {
+            var data = new ParticipantData[NumParticipants];
+            dialogueParticipantsData(_ptr, data, data.Length);
+            return data;
+        }
+
+        public DialogueEntryData[] EntriesData()
+        {
+            var data = new DialogueEntryData[NumEntries];
+            dialogueEntriesData(_ptr, data, data.Length);
+            return data;
+        }
+
+        public DialogueChoiceData[] ChoicesData()
+        {
+            var data = new DialogueChoiceData[NumChoices];
+            dialogueChoicesData(_ptr, data, data.Length);
+            return data;
+        }
+
+        // Batch edits, each is undone as one. Moves and relinks skip unknown
+        // ids and return how many were applied.
+        public int MoveEntries(DialogueEntryMove[] moves)
+        {
+            return moveDialogueEntries(_ptr, moves, moves.Length);
+        }
+
+        public int RelinkChoices(DialogueChoiceRelink[] relinks)
+        {
+            return relinkDialogueChoices(_ptr, relinks, relinks.Length);
+        }
+
+        public DialogueEntry[] AddEntries(Participant[] participants, string[] contents, Vector2[] positions)
+        {
+            var ends = new int[contents.Length];
+            byte[] utf8 = Native.Utf8Strings(contents, ends);
+            var records = new DialogueEntryCreate[contents.Length];
+            var created = new IntPtr[contents.Length];
+
+            GCHandle pin = GCHandle.Alloc(utf8, GCHandleType.Pinned);
+            try
+            {
+                IntPtr text = pin.AddrOfPinnedObject();
+                for (int i = 0, start = 0; i < records.Length; start = ends[i++])
+                {
+                    records[i].activeParticipant = participants[i] == null ? IntPtr.Zero : participants[i]._ptr;
+                    records[i].content = text + start;
+                    records[i].contentLength = ends[i] - start;
+                    records[i].positionX = positions[i].x;
+                    records[i].positionY = positions[i].y;
+                }
+                addDialogueEntries(_ptr, records, records.Length, created);
+            }
+            finally
+            {
+                pin.Free();
+            }
+
+            var entries = new DialogueEntry[created.Length];
+            for (int i = 0; i < created.Length; ++i)
+            {
+                entries[i] = created[i] == IntPtr.Zero ? null : new DialogueEntry(created[i]);
+            }
+            return entries;
+        }
+
+        // dsts may hold null for choices without a destination. Records whose
+        // entries are not in this dialogue create no choice and yield null.
+        public DialogueChoice[] AddChoices(DialogueEntry[] srcs, string[] contents, DialogueEntry[] dsts)
+        {
+            var ends = new int[contents.Length];
+            byte[] utf8 = Native.Utf8Strings(contents, ends);
+            var records = new DialogueChoiceCreate[contents.Length];
+            var created = new IntPtr[contents.Length];
+
+            GCHandle pin = GCHandle.Alloc(utf8, GCHandleType.Pinned);
+            try
+            {
+                IntPtr text = pin.AddrOfPinnedObject();
+                for (int i = 0, start = 0; i < records.Length; start = ends[i++])
+                {
+                    records[i].src = srcs[i] == null ? IntPtr.Zero : srcs[i]._ptr;
+                    records[i].dst = dsts[i] == null ? IntPtr.Zero : dsts[i]._ptr;
+                    records[i].content = text + start;
+                    records[i].contentLength = ends[i] - start;
+                }
+                addDialogueChoices(_ptr, records, records.Length, created);
+            }
+            finally
+            {
+                pin.Free();
+            }
+
+            var choices = new DialogueChoice[created.Length];
+            for (int i = 0; i < created.Length; ++i)
+            {
+                choices[i] = created[i] == IntPtr.Zero ? null : new DialogueChoice(created[i]);
+            }
+            return choices;
+        }
+
         public override bool Equals(object obj)
         {
             var dlg = obj as Dialogue;
@@ -436,6 +801,9 @@ namespace floofy
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern void setParticipantName(IntPtr participant, byte[] name, int bufferSize);
 
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern IntPtr participantNameView(IntPtr participant, out int length);
+
         #endregion PInvoke
 
         public Participant(IntPtr ptr)
@@ -447,9 +815,9 @@ namespace floofy
         {
             get
             {
-                byte[] utf8 = new byte[1024];
-                participantName(_ptr, utf8, 1024);
-                return Encoding.UTF8.GetString(utf8).Trim('\0');
+                int length;
+                IntPtr utf8 = participantNameView(_ptr, out length);
+                return Native.Utf8String(utf8, length);
             }
 
             set
@@ -498,6 +866,9 @@ namespace floofy
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern void setDialogueEntryContent(IntPtr entry, byte[] content, int bufferSize);
 
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern IntPtr dialogueEntryContentView(IntPtr entry, out int length);
+
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern int dialogueEntryNumDialogueChoices(IntPtr entry);
 
@@ -531,6 +902,9 @@ namespace floofy
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern void setDialogueEntryRReaction(IntPtr entry, int reaction);
 
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int dialogueEntryChoices(IntPtr entry, [Out] IntPtr[] choices, int capacity);
+
         #endregion PInvoke
 
         public DialogueEntry(IntPtr ptr)
@@ -550,9 +924,9 @@ namespace floofy
         {
             get
             {
-                byte[] utf8 = new byte[1024];
-                dialogueEntryContent(_ptr, utf8, 1024);
-                return Encoding.UTF8.GetString(utf8).Trim('\0');
+                int length;
+                IntPtr utf8 = dialogueEntryContentView(_ptr, out length);
+                return Native.Utf8String(utf8, length);
             }
 
             set
@@ -590,6 +964,19 @@ namespace floofy
             return new DialogueChoice(dialogueEntryDialogueChoiceFromIndex(_ptr, index));
         }
 
+        public DialogueChoice[] Choices()
+        {
+            var ptrs = new IntPtr[NumChoices];
+            dialogueEntryChoices(_ptr, ptrs, ptrs.Length);
+
+            var choices = new DialogueChoice[ptrs.Length];
+            for (int i = 0; i < ptrs.Length; ++i)
+            {
+                choices[i] = new DialogueChoice(ptrs[i]);
+            }
+            return choices;
+        }
+
         public Vector2 Pos
         {
             get
@@ -656,6 +1043,9 @@ namespace floofy
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern void setDialogueChoiceContent(IntPtr choice, byte[] content, int bufferSize);
 
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern IntPtr dialogueChoiceContentView(IntPtr choice, out int length);
+
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern IntPtr dialogueChoiceSrcEntry(IntPtr choice);
 
@@ -685,9 +1075,9 @@ namespace floofy
         {
             get
             {
-                byte[] utf8 = new byte[1024];
-                dialogueChoiceContent(_ptr, utf8, 1024);
-                return Encoding.UTF8.GetString(utf8).Trim('\0');
+                int length;
+                IntPtr utf8 = dialogueChoiceContentView(_ptr, out length);
+                return Native.Utf8String(utf8, length);
             }
 
             set
@@ -787,6 +1177,9 @@ namespace floofy
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern IntPtr guidFromString(byte[] content, int bufferSize);
 
+        [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern void freeGuid(IntPtr guid);
+
         [DllImport("DialogueManager.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern bool guidIsValid(IntPtr guid);
 
@@ -806,6 +1199,14 @@ namespace floofy
         {
             byte[] utf8 = Encoding.UTF8.GetBytes(guidStr);
             _ptr = guidFromString(utf8, utf8.Length);
+            _owned = true;
+        }
+
+        ~Guid()
+        {
+            // Guids wrapping a choice's guid belong to the choice.
+            if (_owned && _ptr != IntPtr.Zero)
+                freeGuid(_ptr);
         }
 
         public override bool Equals(object obj)
@@ -841,5 +1242,6 @@ namespace floofy
         }
 
         public IntPtr _ptr;
+        private bool _owned;
     }
 }
\ No newline at end of file
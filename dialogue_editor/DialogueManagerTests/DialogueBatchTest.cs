@@ -0,0 +1,187 @@
+﻿using floofy;
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+using System;
+
+namespace DialogueManagerTests
+{
+    // The bulk data and batch edits pass records by layout, a mismatch with
+    // the C structs would corrupt them silently, so each is read back through
+    // the single queries.
+    [TestClass]
+    public class DialogueBatchTest
+    {
+        private DialogueManager _mgr;
+        private Dialogue _dlg;
+        private Participant _part1;
+        private Participant _part2;
+        private DialogueEntry _entry1;
+        private DialogueEntry _entry2;
+        private DialogueEntry _entry3;
+        private DialogueChoice _choice1;
+        private DialogueChoice _choice2;
+
+        [TestInitialize()]
+        public void MyTestInitialize()
+        {
+            _mgr = new DialogueManager();
+            _dlg = _mgr.AddDialogue("A Dialogue");
+            _part1 = _dlg.AddParticipant("A Participant");
+            _part2 = _dlg.AddParticipant("Änother Participant");
+            _entry1 = _dlg.AddEntry(_part1, "Some content");
+            _entry2 = _dlg.AddEntry(_part2, "Some other content");
+            _entry3 = _dlg.AddEntry(_part1, "");
+            _entry2.Pos = new Vector2 { x = 4.0, y = -2.5 };
+            _entry2.LeftReaction = Reaction.Happy;
+            _entry2.RightReaction = Reaction.Sad;
+            _choice1 = _dlg.AddChoice(_entry1, "A Choice", _entry2);
+            _choice2 = _dlg.AddChoice(_entry1, "Another Choice");
+        }
+
+        [TestMethod]
+        public void ParticipantsDataMatchesSingleQueries()
+        {
+            var data = _dlg.ParticipantsData();
+            Assert.AreEqual(data.Length, _dlg.NumParticipants);
+            for (int i = 0; i < data.Length; ++i)
+            {
+                var part = _dlg.Participant(i);
+                Assert.AreEqual(data[i].participant, part._ptr);
+                Assert.AreEqual(data[i].Name, part.Name);
+            }
+            Assert.AreNotEqual(data[0].id, data[1].id);
+        }
+
+        [TestMethod]
+        public void EntriesDataMatchesSingleQueries()
+        {
+            var participants = _dlg.ParticipantsData();
+            var data = _dlg.EntriesData();
+            Assert.AreEqual(data.Length, _dlg.NumEntries);
+            for (int i = 0; i < data.Length; ++i)
+            {
+                var entry = _dlg.Entry(i);
+                Assert.AreEqual(data[i].entry, entry._ptr);
+                Assert.AreEqual(data[i].activeParticipant, entry.ActiveParticipant._ptr);
+                Assert.AreEqual(data[i].Content, entry.Content);
+                Assert.AreEqual(data[i].positionX, entry.Pos.x);
+                Assert.AreEqual(data[i].positionY, entry.Pos.y);
+                Assert.AreEqual(data[i].numChoices, entry.NumChoices);
+                Assert.AreEqual((Reaction)data[i].lReaction, entry.LeftReaction);
+                Assert.AreEqual((Reaction)data[i].rReaction, entry.RightReaction);
+            }
+            Assert.AreEqual(data[1].participantId, participants[1].id);
+        }
+
+        [TestMethod]
+        public void ChoicesDataMatchesSingleQueries()
+        {
+            var entries = _dlg.EntriesData();
+            var data = _dlg.ChoicesData();
+            Assert.AreEqual(data.Length, _dlg.NumChoices);
+            for (int i = 0; i < data.Length; ++i)
+            {
+                var choice = _dlg.Choice(i);
+                Assert.AreEqual(data[i].choice, choice._ptr);
+                Assert.AreEqual(data[i].src, choice.SourceEntry._ptr);
+                Assert.AreEqual(data[i].Content, choice.Content);
+                Assert.AreEqual(data[i].srcId, entries[0].id);
+            }
+            Assert.AreEqual(data[0].dst, _entry2._ptr);
+            Assert.AreEqual(data[0].dstId, entries[1].id);
+            Assert.AreEqual(data[1].dst, IntPtr.Zero);
+            Assert.AreEqual(data[1].dstId, DialogueChoiceRelink.NoDestination);
+        }
+
+        [TestMethod]
+        public void MoveEntriesSetsPositions()
+        {
+            var data = _dlg.EntriesData();
+            var moves = new[]
+            {
+                new DialogueEntryMove { id = data[0].id, positionX = 10.0, positionY = 20.0 },
+                new DialogueEntryMove { id = -2, positionX = 1.0, positionY = 1.0 },
+                new DialogueEntryMove { id = data[2].id, positionX = -30.5, positionY = 40.25 },
+            };
+            Assert.AreEqual(_dlg.MoveEntries(moves), 2);
+            Assert.AreEqual(_entry1.Pos.x, 10.0);
+            Assert.AreEqual(_entry1.Pos.y, 20.0);
+            Assert.AreEqual(_entry2.Pos.x, 4.0);
+            Assert.AreEqual(_entry2.Pos.y, -2.5);
+            Assert.AreEqual(_entry3.Pos.x, -30.5);
+            Assert.AreEqual(_entry3.Pos.y, 40.25);
+        }
+
+        [TestMethod]
+        public void RelinkChoicesSetsAndClearsDestinations()
+        {
+            var entries = _dlg.EntriesData();
+            var data = _dlg.ChoicesData();
+            var relinks = new[]
+            {
+                new DialogueChoiceRelink { id = data[0].id, dstId = DialogueChoiceRelink.NoDestination },
+                new DialogueChoiceRelink { id = data[1].id, dstId = entries[2].id },
+            };
+            Assert.AreEqual(_dlg.RelinkChoices(relinks), 2);
+            Assert.IsNull(_choice1.DestinationEntry);
+            Assert.AreEqual(_choice2.DestinationEntry, _entry3);
+        }
+
+        [TestMethod]
+        public void AddEntriesMatchesSingleQueries()
+        {
+            var other = _mgr.AddDialogue("Another Dialogue");
+            var otherPart = other.AddParticipant("A Participant");
+            var participants = new[] { _part2, _part1, null, otherPart };
+            var contents = new[] { "Pasted", "Päste with ünicode", "No participant", "Other dialogue's participant" };
+            var positions = new[]
+            {
+                new Vector2 { x = 1.5, y = 2.5 },
+                new Vector2 { x = -3.0, y = 4.0 },
+                new Vector2(),
+                new Vector2(),
+            };
+
+            var created = _dlg.AddEntries(participants, contents, positions);
+            Assert.AreEqual(created.Length, 4);
+            Assert.AreEqual(_dlg.NumEntries, 5);
+            for (int i = 0; i < 2; ++i)
+            {
+                var entry = _dlg.Entry(3 + i);
+                Assert.AreEqual(created[i], entry);
+                Assert.AreEqual(entry.ActiveParticipant, participants[i]);
+                Assert.AreEqual(entry.Content, contents[i]);
+                Assert.AreEqual(entry.Pos.x, positions[i].x);
+                Assert.AreEqual(entry.Pos.y, positions[i].y);
+            }
+            Assert.IsNull(created[2]);
+            Assert.IsNull(created[3]);
+        }
+
+        [TestMethod]
+        public void AddChoicesMatchesSingleQueries()
+        {
+            var other = _mgr.AddDialogue("Another Dialogue");
+            var otherEntry = other.AddEntry(other.AddParticipant("A Participant"), "Elsewhere");
+            var srcs = new[] { _entry2, _entry3, null, otherEntry };
+            var contents = new[] { "Go on", "Ünd then?", "No source", "From another dialogue" };
+            var dsts = new[] { _entry3, null, _entry1, _entry1 };
+
+            var created = _dlg.AddChoices(srcs, contents, dsts);
+            Assert.AreEqual(created.Length, 4);
+            Assert.AreEqual(_dlg.NumChoices, 4);
+            for (int i = 0; i < 2; ++i)
+            {
+                var choice = _dlg.Choice(2 + i);
+                Assert.AreEqual(created[i], choice);
+                Assert.AreEqual(choice.SourceEntry, srcs[i]);
+                Assert.AreEqual(choice.Content, contents[i]);
+                Assert.AreEqual(srcs[i].Choice(0), choice);
+            }
+            Assert.AreEqual(created[0].DestinationEntry, _entry3);
+            Assert.IsNull(created[1].DestinationEntry);
+            Assert.IsNull(created[2]);
+            Assert.IsNull(created[3]);
+            Assert.AreEqual(otherEntry.NumChoices, 0);
+        }
+    }
+}
\ No newline at end of file
@@ -8,6 +8,88 @@ struct HParticipant;
 struct HDialogueEntry;
 struct HDialogueChoice;
 struct HGuid;
+struct HDialogueImage;
+struct HDialogueLibrary;
+struct HDialogueStore;
+struct HDialogueRunner;
+struct HDialoguePublisher;
+struct HDialogueSnapshot;
+struct HDialogueFileWatcher;
+struct HDialogueHistory;
+struct HDialogueAnalysis;
+
+#define DIALOGUE_INVALID_INDEX ((_size_t)-1)
+
+// Plain records filled by the bulk functions below, one call returns a whole
+// dialogue's participants, entries or choices. Strings point at the library's
+// copy and stay valid until that string is changed or the node is freed.
+typedef struct ParticipantData
+{
+  HParticipant *participant;
+  const char *name;
+  _size_t id;
+  _size_t nameLength;
+} ParticipantData;
+
+typedef struct DialogueEntryData
+{
+  HDialogueEntry *entry;
+  HParticipant *activeParticipant;
+  const char *content;
+  double positionX;
+  double positionY;
+  _size_t id;
+  _size_t participantId;
+  _size_t contentLength;
+  _size_t numChoices;
+  int lReaction;
+  int rReaction;
+} DialogueEntryData;
+
+typedef struct DialogueChoiceData
+{
+  HDialogueChoice *choice;
+  HDialogueEntry *src;
+  HDialogueEntry *dst;
+  const char *content;
+  _size_t id;
+  _size_t srcId;
+  _size_t dstId; // DIALOGUE_INVALID_INDEX without a destination
+  _size_t contentLength;
+  int guidAssigned;
+} DialogueChoiceData;
+
+// Records taken by the batch functions below, one call applies a whole
+// selection's moves, relinks or pasted nodes.
+typedef struct DialogueEntryMove
+{
+  _size_t id;
+  double positionX;
+  double positionY;
+} DialogueEntryMove;
+
+typedef struct DialogueChoiceRelink
+{
+  _size_t id;
+  _size_t dstId; // DIALOGUE_INVALID_INDEX clears the destination
+} DialogueChoiceRelink;
+
+typedef struct DialogueEntryCreate
+{
+  HParticipant *activeParticipant;
+  const char *content;
+  _size_t contentLength;
+  double positionX;
+  double positionY;
+} DialogueEntryCreate;
+
+typedef struct DialogueChoiceCreate
+{
+  HDialogueEntry *src;
+  HDialogueEntry *dst;
+  const char *content;
+  _size_t contentLength;
+} DialogueChoiceCreate;
 
 #if __cplusplus
 extern "C"
@@ -17,8 +99,49 @@ extern "C"
   EXPORT HDialogueManager *newDialogueManager();
   EXPORT _result_t freeDialogueManager(HDialogueManager *mgr);
   EXPORT _result_t writeDialogues(HDialogueManager *mgr, const char *filePath, _size_t filePathSize);
+  EXPORT _result_t writeDialoguesCompact(HDialogueManager *mgr, const char *filePath, _size_t filePathSize);
   EXPORT HDialogueManager *readDialoguesFromFile(const char *filePath, _size_t filePathSize);
   EXPORT HDialogueManager *readDialoguesFromContents(const char *contents, _size_t contentsPathSize);
+  EXPORT _result_t writeDialoguesBinary(HDialogueManager *mgr, const char *filePath, _size_t filePathSize);
+  EXPORT HDialogueManager *readDialoguesBinaryFromFile(const char *filePath, _size_t filePathSize);
+  EXPORT HDialogueManager *readDialoguesBinaryFromContents(const char *contents, _size_t contentsSize);
+  EXPORT _result_t writeDialoguesSharded(HDialogueManager *mgr, const char *directory, _size_t directorySize);
+  EXPORT _result_t writeDialoguesShardedChanges(HDialogueManager *mgr, const char *directory, _size_t directorySize);
+  EXPORT HDialogueManager *readDialoguesSharded(const char *directory, _size_t directorySize);
+  EXPORT bool dialogueManagerModified(HDialogueManager *mgr);
+
+  // Hot-reload, the file is applied to the manager in place so handles to
+  // nodes that are still in it stay valid and unchanged dialogues are not
+  // marked modified. Handles to removed nodes stay readable until the
+  // manager is freed, or for dialogues dropped by a reload until they are
+  // released. The watcher is polled, it reports whether the file was
+  // written since the previous poll.
+  EXPORT _result_t reloadDialoguesFromFile(HDialogueManager *mgr, const char *filePath, _size_t filePathSize);
+  EXPORT _result_t reloadDialoguesFromContents(HDialogueManager *mgr, const char *contents, _size_t contentsSize);
+  EXPORT void releaseDialoguesRemovedByReload(HDialogueManager *mgr);
+  EXPORT HDialogueFileWatcher *newDialogueFileWatcher(const char *filePath, _size_t filePathSize);
+  EXPORT void freeDialogueFileWatcher(HDialogueFileWatcher *watcher);
+  EXPORT bool dialogueFileWatcherChanged(HDialogueFileWatcher *watcher);
+
+  // Native undo log of a manager, one per manager, null if it already has
+  // one. Every change made through the functions below is recorded while it
+  // exists. Changes between begin and commit form one transaction, other
+  // changes one each, and undo and redo apply a whole transaction. The
+  // budget bounds the bytes held, 0 for no bound, the oldest transactions
+  // are dropped first, numDropped counts them since the history was created.
+  // Removing a dialogue or reloading clears the history.
+  EXPORT HDialogueHistory *newDialogueHistory(HDialogueManager *mgr, _size_t budget);
+  EXPORT void freeDialogueHistory(HDialogueHistory *history);
+  EXPORT void dialogueHistoryBegin(HDialogueHistory *history);
+  EXPORT void dialogueHistoryCommit(HDialogueHistory *history);
+  EXPORT bool dialogueHistoryUndo(HDialogueHistory *history);
+  EXPORT bool dialogueHistoryRedo(HDialogueHistory *history);
+  EXPORT _size_t dialogueHistoryNumUndo(HDialogueHistory *history);
+  EXPORT _size_t dialogueHistoryNumRedo(HDialogueHistory *history);
+  EXPORT _size_t dialogueHistoryNumDropped(HDialogueHistory *history);
+  EXPORT _size_t dialogueHistoryBytes(HDialogueHistory *history);
+  EXPORT void setDialogueHistoryBudget(HDialogueHistory *history, _size_t budget);
+  EXPORT void clearDialogueHistory(HDialogueHistory *history);
 
   EXPORT HDialogue *addNewDialogue(HDialogueManager *mgr, const char *name, _size_t nameSize);
   EXPORT bool addExistingDialogue(HDialogueManager *mgr, HDialogue *dlg);
@@ -26,6 +149,7 @@ extern "C"
   EXPORT _size_t numDialogues(HDialogueManager *mgr);
   EXPORT HDialogue *dialogueFromName(HDialogueManager *mgr, const char *name, _size_t size);
   EXPORT HDialogue *dialogueFromIndex(HDialogueManager *mgr, _size_t index);
+  EXPORT HDialogueChoice *choiceFromGuid(HDialogueManager *mgr, HGuid *guid);
   EXPORT void freeDialogue(HDialogue *dlg);
 
   EXPORT HParticipant *addParticipant(HDialogue *dialogue, const char *name, _size_t nameSize);
@@ -55,14 +179,41 @@ extern "C"
   EXPORT HDialogueChoice *dialogueChoiceFromIndex(HDialogue *dialogue, _size_t index);
   EXPORT void removeDialogueChoice(HDialogue *dialogue, HDialogueChoice *choice);
 
+  // Bulk queries, each returns the total count and fills at most capacity records.
+  EXPORT _size_t dialogueParticipantsData(HDialogue *dialogue, ParticipantData *data, _size_t capacity);
+  EXPORT _size_t dialogueEntriesData(HDialogue *dialogue, DialogueEntryData *data, _size_t capacity);
+  EXPORT _size_t dialogueChoicesData(HDialogue *dialogue, DialogueChoiceData *data, _size_t capacity);
+  EXPORT _size_t dialogueEntryChoices(HDialogueEntry *entry, HDialogueChoice **choices, _size_t capacity);
+
+  // Batch edits, each is one undo transaction. Moves and relinks skip
+  // records with unknown IDs and return how many were applied. Creation
+  // writes the new nodes to created if it is not null. An entry record
+  // without a participant of the dialogue, or a choice record without a
+  // source entry or with an entry of another dialogue, creates nothing and
+  // yields null.
+  EXPORT _size_t moveDialogueEntries(HDialogue *dialogue, const DialogueEntryMove *moves, _size_t count);
+  EXPORT _size_t relinkDialogueChoices(HDialogue *dialogue, const DialogueChoiceRelink *relinks, _size_t count);
+  EXPORT void addDialogueEntries(HDialogue *dialogue, const DialogueEntryCreate *records, _size_t count, HDialogueEntry **created);
+  EXPORT void addDialogueChoices(HDialogue *dialogue, const DialogueChoiceCreate *records, _size_t count, HDialogueChoice **created);
+
+  // String getters copy into the caller's buffer, *Length returns the size in
+  // bytes without the null terminator. *View returns the model's own UTF-8
+  // bytes, which are not null terminated and stay valid until the string is
+  // changed or the node is freed.
   EXPORT void dialogueName(HDialogue *dialogue, char *name, _size_t bufferSize);
   EXPORT void setDialogueName(HDialogue *dialogue, char *name, _size_t bufferSize);
+  EXPORT _size_t dialogueNameLength(HDialogue *dialogue);
+  EXPORT const char *dialogueNameView(HDialogue *dialogue, _size_t *length);
 
   EXPORT void participantName(HParticipant *participant, char *name, _size_t bufferSize);
   EXPORT void setParticipantName(HParticipant *participant, char *name, _size_t bufferSize);
+  EXPORT _size_t participantNameLength(HParticipant *participant);
+  EXPORT const char *participantNameView(HParticipant *participant, _size_t *length);
 
   EXPORT void dialogueEntryContent(HDialogueEntry *entry, char *content, _size_t bufferSize);
   EXPORT void setDialogueEntryContent(HDialogueEntry *entry, char *content, _size_t bufferSize);
+  EXPORT _size_t dialogueEntryContentLength(HDialogueEntry *entry);
+  EXPORT const char *dialogueEntryContentView(HDialogueEntry *entry, _size_t *length);
   EXPORT _size_t dialogueEntryNumDialogueChoices(HDialogueEntry *entry);
   EXPORT HDialogueChoice *dialogueEntryDialogueChoiceFromIndex(HDialogueEntry *entry, _size_t index);
   EXPORT HParticipant *dialogueEntryActiveParticipant(HDialogueEntry *entry);
@@ -77,6 +228,8 @@ extern "C"
 
   EXPORT void dialogueChoiceContent(HDialogueChoice *choice, char *content, _size_t bufferSize);
   EXPORT void setDialogueChoiceContent(HDialogueChoice *choice, char *content, _size_t bufferSize);
+  EXPORT _size_t dialogueChoiceContentLength(HDialogueChoice *choice);
+  EXPORT const char *dialogueChoiceContentView(HDialogueChoice *choice, _size_t *length);
   EXPORT HDialogueEntry *dialogueChoiceSrcEntry(HDialogueChoice *choice);
   EXPORT HDialogueEntry *dialogueChoiceDstEntry(HDialogueChoice *choice);
   EXPORT void setDialogueChoiceDstEntry(HDialogueChoice *choice, HDialogueEntry *entry);
@@ -87,8 +240,102 @@ extern "C"
   EXPORT bool guidsAreEqual(HGuid *lhs, HGuid *rhs);
   EXPORT void guidToString(HGuid *guid, char *content, _size_t bufferSize);
   EXPORT HGuid *guidFromString(const char *content, _size_t bufferSize);
+  EXPORT void freeGuid(HGuid *guid);
   EXPORT bool guidIsValid(HGuid *guid);
 
+  // Read-only, memory mapped binary dialogues. Strings are returned as pointers
+  // into the mapping and stay valid until the image is closed.
+  EXPORT HDialogueImage *openDialogueImage(const char *filePath, _size_t filePathSize);
+  EXPORT void closeDialogueImage(HDialogueImage *image);
+  EXPORT _size_t dialogueImageNumDialogues(HDialogueImage *image);
+  EXPORT _size_t dialogueImageDialogueFromName(HDialogueImage *image, const char *name, _size_t size);
+  EXPORT const char *dialogueImageDialogueName(HDialogueImage *image, _size_t dialogue, _size_t *length);
+  EXPORT _size_t dialogueImageNumParticipants(HDialogueImage *image, _size_t dialogue);
+  EXPORT const char *dialogueImageParticipantName(HDialogueImage *image, _size_t dialogue, _size_t participant, _size_t *length);
+  EXPORT _size_t dialogueImageNumDialogueEntries(HDialogueImage *image, _size_t dialogue);
+  EXPORT const char *dialogueImageEntryContent(HDialogueImage *image, _size_t dialogue, _size_t entry, _size_t *length);
+  EXPORT _size_t dialogueImageEntryActiveParticipant(HDialogueImage *image, _size_t dialogue, _size_t entry);
+  EXPORT int dialogueImageEntryLReaction(HDialogueImage *image, _size_t dialogue, _size_t entry);
+  EXPORT int dialogueImageEntryRReaction(HDialogueImage *image, _size_t dialogue, _size_t entry);
+  EXPORT _size_t dialogueImageEntryNumDialogueChoices(HDialogueImage *image, _size_t dialogue, _size_t entry);
+  EXPORT _size_t dialogueImageEntryDialogueChoiceFromIndex(HDialogueImage *image, _size_t dialogue, _size_t entry, _size_t index);
+  EXPORT _size_t dialogueImageNumDialogueChoices(HDialogueImage *image, _size_t dialogue);
+  EXPORT const char *dialogueImageChoiceContent(HDialogueImage *image, _size_t dialogue, _size_t choice, _size_t *length);
+  EXPORT _size_t dialogueImageChoiceDstEntry(HDialogueImage *image, _size_t dialogue, _size_t choice);
+
+  // Binary dialogues loaded on first access. Returned dialogues are regular
+  // dialogues without a manager, owned by the library and valid until evicted
+  // by the budget (the maximum number of loaded dialogues, 0 for no limit) or
+  // until the library is closed.
+  EXPORT HDialogueLibrary *openDialogueLibrary(const char *filePath, _size_t filePathSize, _size_t budget);
+  EXPORT void closeDialogueLibrary(HDialogueLibrary *library);
+  EXPORT _size_t dialogueLibraryNumDialogues(HDialogueLibrary *library);
+  EXPORT _size_t dialogueLibraryNumLoaded(HDialogueLibrary *library);
+  EXPORT HDialogue *dialogueLibraryDialogueFromName(HDialogueLibrary *library, const char *name, _size_t size);
+  EXPORT HDialogue *dialogueLibraryDialogueFromIndex(HDialogueLibrary *library, _size_t index);
+
+  // Index based snapshot of a dialogue for fast traversal. Entries, choices and
+  // participants are addressed by their index in the dialogue at the time the
+  // store was built, strings stay valid until the store is freed.
+  EXPORT HDialogueStore *buildDialogueStore(HDialogue *dialogue);
+  EXPORT void freeDialogueStore(HDialogueStore *store);
+  EXPORT _size_t dialogueStoreNumParticipants(HDialogueStore *store);
+  EXPORT const char *dialogueStoreParticipantName(HDialogueStore *store, _size_t participant, _size_t *length);
+  EXPORT _size_t dialogueStoreNumDialogueEntries(HDialogueStore *store);
+  EXPORT _size_t dialogueStoreEntryFromId(HDialogueStore *store, _size_t id);
+  EXPORT const char *dialogueStoreEntryContent(HDialogueStore *store, _size_t entry, _size_t *length);
+  EXPORT _size_t dialogueStoreEntryActiveParticipant(HDialogueStore *store, _size_t entry);
+  EXPORT _size_t dialogueStoreEntryNumDialogueChoices(HDialogueStore *store, _size_t entry);
+  EXPORT _size_t dialogueStoreEntryDialogueChoiceFromIndex(HDialogueStore *store, _size_t entry, _size_t index);
+  EXPORT _size_t dialogueStoreEntryNextEntries(HDialogueStore *store, _size_t entry, _size_t *entries, _size_t capacity);
+  EXPORT _size_t dialogueStoreNumDialogueChoices(HDialogueStore *store);
+  EXPORT const char *dialogueStoreChoiceContent(HDialogueStore *store, _size_t choice, _size_t *length);
+  EXPORT _size_t dialogueStoreChoiceDstEntry(HDialogueStore *store, _size_t choice);
+
+  // Immutable stores of all dialogues of a manager, shared with reader
+  // threads. A writer publishes a snapshot after editing or reloading the
+  // manager, readers acquire the latest one and use it without locking until
+  // they release it. Stores of a snapshot stay valid while it is held and
+  // must not be freed with freeDialogueStore.
+  EXPORT HDialoguePublisher *newDialoguePublisher();
+  EXPORT void freeDialoguePublisher(HDialoguePublisher *publisher);
+  EXPORT _size_t publishDialogueSnapshot(HDialoguePublisher *publisher, HDialogueManager *mgr);
+  EXPORT HDialogueSnapshot *acquireDialogueSnapshot(HDialoguePublisher *publisher);
+  EXPORT void releaseDialogueSnapshot(HDialogueSnapshot *snapshot);
+  EXPORT _size_t dialogueSnapshotNumDialogues(HDialogueSnapshot *snapshot);
+  EXPORT HDialogueStore *dialogueSnapshotStoreFromIndex(HDialogueSnapshot *snapshot, _size_t index);
+  EXPORT HDialogueStore *dialogueSnapshotStoreFromName(HDialogueSnapshot *snapshot, const char *name, _size_t size);
+
+  // Conversation cursor over a store, the store must outlive its runners.
+  EXPORT HDialogueRunner *newDialogueRunner(HDialogueStore *store, _size_t entry);
+  EXPORT void freeDialogueRunner(HDialogueRunner *runner);
+  EXPORT void dialogueRunnerReset(HDialogueRunner *runner, _size_t entry);
+  EXPORT bool dialogueRunnerFinished(HDialogueRunner *runner);
+  EXPORT _size_t dialogueRunnerCurrentEntry(HDialogueRunner *runner);
+  EXPORT _size_t dialogueRunnerNumChoices(HDialogueRunner *runner);
+  EXPORT _size_t dialogueRunnerChoiceFromIndex(HDialogueRunner *runner, _size_t index);
+  EXPORT bool dialogueRunnerSelect(HDialogueRunner *runner, _size_t index);
+
+  // Graph checks of a dialogue from the entry at index root. Entries, choices
+  // and components are addressed by index as of the analysis, the list
+  // getters return the total count and write at most capacity indexes.
+  // analyseDialogues analyses a manager's dialogues in parallel, dialogue i
+  // from the entry at roots[i]. Without roots each starts at its first entry,
+  // which removing entries or undoing their adds can replace with any other.
+  // It returns the number of dialogues and writes that many analyses, which
+  // must each be freed, or nothing when capacity is smaller.
+  EXPORT HDialogueAnalysis *analyseDialogue(HDialogue *dialogue, _size_t root);
+  EXPORT _size_t analyseDialogues(HDialogueManager *mgr, const _size_t *roots, HDialogueAnalysis **analyses, _size_t capacity);
+  EXPORT void freeDialogueAnalysis(HDialogueAnalysis *analysis);
+  EXPORT _size_t dialogueAnalysisUnreachableEntries(HDialogueAnalysis *analysis, _size_t *entries, _size_t capacity);
+  EXPORT _size_t dialogueAnalysisDanglingChoices(HDialogueAnalysis *analysis, _size_t *choices, _size_t capacity);
+  EXPORT _size_t dialogueAnalysisDeadEnds(HDialogueAnalysis *analysis, _size_t *entries, _size_t capacity);
+  EXPORT _size_t dialogueAnalysisNumComponents(HDialogueAnalysis *analysis);
+  EXPORT _size_t dialogueAnalysisEntryComponent(HDialogueAnalysis *analysis, _size_t entry);
+  EXPORT _size_t dialogueAnalysisCyclicComponents(HDialogueAnalysis *analysis, _size_t *components, _size_t capacity);
+  EXPORT _size_t dialogueAnalysisLongestPath(HDialogueAnalysis *analysis);
+  EXPORT _size_t dialogueAnalysisLongestPathEnd(HDialogueAnalysis *analysis);
+
 #if __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "dialogue_analysis.hpp"
+#include "common/parallel.hpp"
+
+#include <algorithm>
+
+namespace floofy
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueAnalysis
+
+    DialogueAnalysis::DialogueAnalysis(const Dialogue &dialogue, uint32_t root)
+        : _root(root < dialogue.entries.size() ? root : NO_INDEX)
+    {
+        const auto &entries = dialogue.entries;
+        const auto &choices = dialogue.choices;
+        const auto numEntries = entries.size();
+
+        //Adjacency
+        // Choices are counted per source entry first and then placed in the
+        // order of the dialogue's list. Entries of other dialogues have no
+        // place in the graph: a choice leading into one ends the conversation
+        // here, one leaving from one is left out.
+        const auto inDialogue = [&dialogue](DialogueEntryPtr entry) { return entry && entry->_dialogue == &dialogue; };
+        _firstEdge.assign(numEntries + 1, 0);
+        for (size_t i = 0; i < choices.size(); ++i)
+        {
+            const auto choice = choices[i];
+            if (!inDialogue(choice->src))
+            {
+                continue;
+            }
+            if (!inDialogue(choice->dst))
+            {
+                _dangling.push_back(static_cast<uint32_t>(i));
+                continue;
+            }
+            ++_firstEdge[choice->src->_index + 1];
+        }
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            _firstEdge[i + 1] += _firstEdge[i];
+        }
+        _edges.resize(_firstEdge[numEntries]);
+        std::vector<uint32_t> nextEdge(_firstEdge.begin(), _firstEdge.end() - 1);
+        for (const auto &choice : choices)
+        {
+            if (inDialogue(choice->src) && inDialogue(choice->dst))
+            {
+                _edges[nextEdge[choice->src->_index]++] = static_cast<uint32_t>(choice->dst->_index);
+            }
+        }
+
+        //Dead ends
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            if (entries[i]->choices.empty())
+            {
+                _deadEnds.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        //Reachability
+        std::vector<uint8_t> reached(numEntries, 0);
+        if (_root != NO_INDEX)
+        {
+            std::vector<uint32_t> pending{_root};
+            reached[_root] = 1;
+            while (!pending.empty())
+            {
+                const auto entry = pending.back();
+                pending.pop_back();
+                for (auto edge = _firstEdge[entry]; edge < _firstEdge[entry + 1]; ++edge)
+                {
+                    const auto dst = _edges[edge];
+                    if (!reached[dst])
+                    {
+                        reached[dst] = 1;
+                        pending.push_back(dst);
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            if (!reached[i])
+            {
+                _unreachable.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        findComponents();
+        findLongestPath();
+    }
+
+    std::vector<DialogueAnalysis> DialogueAnalysis::analyse(const DialogueManager &mgr, const uint32_t *roots, size_t maxThreads)
+    {
+        std::vector<DialogueAnalysis> analyses(mgr.numDialogues());
+        parallelFor(
+            analyses.size(),
+            [&analyses, &mgr, roots](size_t i) { analyses[i] = DialogueAnalysis(*mgr.dialogue(i), roots ? roots[i] : 0); },
+            maxThreads);
+        return analyses;
+    }
+
+    // Tarjan's algorithm with an explicit call stack. A component is complete
+    // once the walk returns to its first entry, so components are numbered
+    // after everything they lead to.
+    void DialogueAnalysis::findComponents()
+    {
+        struct Call
+        {
+            uint32_t entry;
+            uint32_t edge;
+        };
+
+        const auto numEntries = _firstEdge.size() - 1;
+        std::vector<uint32_t> order(numEntries, NO_INDEX);
+        std::vector<uint32_t> low(numEntries, 0);
+        std::vector<uint32_t> open;
+        std::vector<Call> calls;
+        uint32_t visited = 0;
+
+        _component.assign(numEntries, NO_INDEX);
+        const auto visit = [&](uint32_t entry) {
+            order[entry] = low[entry] = visited++;
+            open.push_back(entry);
+            calls.push_back({entry, _firstEdge[entry]});
+        };
+
+        for (uint32_t start = 0; start < numEntries; ++start)
+        {
+            if (order[start] != NO_INDEX)
+            {
+                continue;
+            }
+
+            visit(start);
+            while (!calls.empty())
+            {
+                const auto entry = calls.back().entry;
+                if (calls.back().edge < _firstEdge[entry + 1])
+                {
+                    const auto dst = _edges[calls.back().edge++];
+                    if (order[dst] == NO_INDEX)
+                    {
+                        visit(dst);
+                    }
+                    else if (_component[dst] == NO_INDEX)
+                    {
+                        // Still open, so part of the component being walked.
+                        low[entry] = std::min(low[entry], order[dst]);
+                    }
+                    continue;
+                }
+
+                calls.pop_back();
+                if (!calls.empty())
+                {
+                    const auto caller = calls.back().entry;
+                    low[caller] = std::min(low[caller], low[entry]);
+                }
+                if (low[entry] != order[entry])
+                {
+                    continue;
+                }
+
+                const auto component = static_cast<uint32_t>(_numComponents++);
+                size_t size = 0;
+                uint32_t member;
+                do
+                {
+                    member = open.back();
+                    open.pop_back();
+                    _component[member] = component;
+                    ++size;
+                } while (member != entry);
+
+                const auto first = _edges.begin() + _firstEdge[entry];
+                const auto last = _edges.begin() + _firstEdge[entry + 1];
+                if (size > 1 || std::find(first, last, entry) != last)
+                {
+                    _cyclic.push_back(component);
+                }
+            }
+        }
+    }
+
+    // Longest path over the components leading from the root's. A path only
+    // goes to lower numbers, so walking them downwards reaches a component
+    // after every one leading to it.
+    void DialogueAnalysis::findLongestPath()
+    {
+        if (_root == NO_INDEX)
+        {
+            return;
+        }
+
+        // Entries of component c are members[firstMember[c], firstMember[c + 1]).
+        std::vector<uint32_t> firstMember(_numComponents + 1, 0);
+        for (auto component : _component)
+        {
+            ++firstMember[component + 1];
+        }
+        for (size_t c = 0; c < _numComponents; ++c)
+        {
+            firstMember[c + 1] += firstMember[c];
+        }
+        std::vector<uint32_t> members(_component.size());
+        std::vector<uint32_t> nextMember(firstMember.begin(), firstMember.end() - 1);
+        for (uint32_t entry = 0; entry < _component.size(); ++entry)
+        {
+            members[nextMember[_component[entry]]++] = entry;
+        }
+
+        // Length of the longest path into each component and the entry it
+        // enters at, NO_INDEX for components the root does not lead to.
+        std::vector<uint32_t> length(_numComponents, NO_INDEX);
+        std::vector<uint32_t> enteredAt(_numComponents, NO_INDEX);
+        const auto rootComponent = _component[_root];
+        length[rootComponent] = 0;
+        enteredAt[rootComponent] = _root;
+        _longestPathEnd = _root;
+        for (size_t c = rootComponent + 1; c-- > 0;)
+        {
+            if (length[c] == NO_INDEX)
+            {
+                continue;
+            }
+            if (length[c] > _longestPath)
+            {
+                _longestPath = length[c];
+                _longestPathEnd = enteredAt[c];
+            }
+
+            for (auto member = firstMember[c]; member < firstMember[c + 1]; ++member)
+            {
+                const auto entry = members[member];
+                for (auto edge = _firstEdge[entry]; edge < _firstEdge[entry + 1]; ++edge)
+                {
+                    const auto dst = _edges[edge];
+                    const auto next = _component[dst];
+                    if (next != c && (length[next] == NO_INDEX || length[c] + 1 > length[next]))
+                    {
+                        length[next] = length[c] + 1;
+                        enteredAt[next] = dst;
+                    }
+                }
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
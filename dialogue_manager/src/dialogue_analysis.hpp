@@ -0,0 +1,86 @@
+#pragma once
+
+#include "dialogue_manager.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueAnalysis
+  // Content checks over a dialogue's graph, entries being the nodes and
+  // choices with a destination the edges. Entries and choices are addressed
+  // by their index in the dialogue at the time of the analysis, which does
+  // not follow later edits.
+  //
+  // The graph is flattened into an adjacency array first, every check is then
+  // a linear pass over it: reachability from the root, strongly connected
+  // components (Tarjan's, without recursion so long chains cannot overflow
+  // the stack) and the longest path over the components.
+  class DialogueAnalysis
+  {
+  public:
+    static constexpr uint32_t NO_INDEX = 0xFFFFFFFF;
+
+    DialogueAnalysis() = default;
+    // An invalid root leaves every entry unreachable.
+    DialogueAnalysis(const Dialogue &dialogue, uint32_t root);
+
+    // Analyses every dialogue of the manager, dialogue i from roots[i], the
+    // dialogues in parallel. Without roots each dialogue is analysed from its
+    // first entry, which need not stay its start: removing an entry moves the
+    // last one into its place, and undo can remove the first entry the same
+    // way. The manager must not change while this runs.
+    static std::vector<DialogueAnalysis> analyse(const DialogueManager &mgr, const uint32_t *roots = nullptr, size_t maxThreads = 0);
+
+    size_t numEntries() const { return _component.size(); }
+    uint32_t root() const { return _root; }
+
+    // Entries no sequence of choices leads to from the root.
+    const std::vector<uint32_t> &unreachableEntries() const { return _unreachable; }
+    // Choices without a destination, or leading into another dialogue, they
+    // end the conversation.
+    const std::vector<uint32_t> &danglingChoices() const { return _dangling; }
+    // Entries without any choice, a conversation reaching one can neither
+    // go on nor end.
+    const std::vector<uint32_t> &deadEnds() const { return _deadEnds; }
+
+    // Strongly connected components, numbered so that choices only lead to
+    // components with a lower or the same number.
+    size_t numComponents() const { return _numComponents; }
+    uint32_t component(uint32_t entry) const { return _component[entry]; }
+    // Components holding a cycle: more than one entry, or one entry with a
+    // choice leading back to itself.
+    const std::vector<uint32_t> &cyclicComponents() const { return _cyclic; }
+
+    // Number of choices on the longest path from the root, counting only
+    // choices between components, so going around a cycle adds nothing.
+    // Exact when the dialogue has no cycles. The end is the entry the path
+    // arrives at last, or NO_INDEX for an invalid root.
+    size_t longestPath() const { return _longestPath; }
+    uint32_t longestPathEnd() const { return _longestPathEnd; }
+
+  private:
+    void findComponents();
+    void findLongestPath();
+
+    uint32_t _root = NO_INDEX;
+
+    // Entry i's choices lead to _edges[_firstEdge[i], _firstEdge[i + 1]).
+    std::vector<uint32_t> _firstEdge;
+    std::vector<uint32_t> _edges;
+
+    std::vector<uint32_t> _unreachable;
+    std::vector<uint32_t> _dangling;
+    std::vector<uint32_t> _deadEnds;
+
+    std::vector<uint32_t> _component;
+    size_t _numComponents = 0;
+    std::vector<uint32_t> _cyclic;
+
+    size_t _longestPath = 0;
+    uint32_t _longestPathEnd = NO_INDEX;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,405 @@
+#include "dialogue_binary.hpp"
+#include "dialogue_manager.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using namespace floofy::binary;
+
+    class StringTableBuilder
+    {
+    public:
+        uint32_t add(std::string_view str)
+        {
+            auto find = offsets.find(str);
+            if (find != offsets.end())
+            {
+                return find->second;
+            }
+
+            auto offset = static_cast<uint32_t>(data.size());
+            auto length = static_cast<uint32_t>(str.size());
+            data.append(reinterpret_cast<const char *>(&length), sizeof(length));
+            data.append(str.data(), str.size());
+            data.push_back('\0');
+            offsets.emplace(str, offset);
+            return offset;
+        }
+
+        std::string data;
+        std::unordered_map<std::string_view, uint32_t> offsets;
+    };
+
+    uint64_t alignSection(uint64_t offset)
+    {
+        return (offset + 7) & ~uint64_t(7);
+    }
+
+    bool sectionInBounds(uint64_t offset, uint64_t count, size_t elementSize, size_t imageSize)
+    {
+        return offset % 8 == 0 && offset <= imageSize && count * elementSize <= imageSize - offset;
+    }
+
+    bool rangeInBounds(uint32_t first, uint32_t count, uint32_t total)
+    {
+        return uint64_t(first) + count <= total;
+    }
+
+    void writeSection(std::ostream &stream, uint64_t &written, uint64_t offset, const void *data, size_t size)
+    {
+        static const char padding[8] = {};
+        stream.write(padding, offset - written);
+        stream.write(reinterpret_cast<const char *>(data), size);
+        written = offset + size;
+    }
+
+    template <typename T>
+    void writeSection(std::ostream &stream, uint64_t &written, uint64_t offset, const std::vector<T> &records)
+    {
+        writeSection(stream, written, offset, records.data(), records.size() * sizeof(T));
+    }
+} // namespace
+
+namespace floofy
+{
+    namespace binary
+    {
+        /////////////////////////////////////////////////////////////////////////////
+        //ImageView
+
+        bool ImageView::validate() const
+        {
+            if (!data || size < sizeof(Header))
+            {
+                return false;
+            }
+
+            const auto &hdr = header();
+            if (std::memcmp(hdr.magic, MAGIC, sizeof(MAGIC)) != 0 || hdr.version != FORMAT_VERSION)
+            {
+                return false;
+            }
+
+            return sectionInBounds(hdr.dialoguesOffset, hdr.numDialogues, sizeof(DialogueRecord), size) &&
+                   sectionInBounds(hdr.participantsOffset, hdr.numParticipants, sizeof(ParticipantRecord), size) &&
+                   sectionInBounds(hdr.entriesOffset, hdr.numEntries, sizeof(EntryRecord), size) &&
+                   sectionInBounds(hdr.choicesOffset, hdr.numChoices, sizeof(ChoiceRecord), size) &&
+                   sectionInBounds(hdr.choiceRefsOffset, hdr.numChoiceRefs, sizeof(uint32_t), size) &&
+                   hdr.stringsOffset <= size && hdr.stringsSize <= size - hdr.stringsOffset;
+        }
+
+        bool ImageView::validate(const DialogueRecord &record) const
+        {
+            const auto &hdr = header();
+            return rangeInBounds(record.firstParticipant, record.numParticipants, hdr.numParticipants) &&
+                   rangeInBounds(record.firstEntry, record.numEntries, hdr.numEntries) &&
+                   rangeInBounds(record.firstChoice, record.numChoices, hdr.numChoices);
+        }
+
+        std::string_view ImageView::string(uint32_t ref) const
+        {
+            const auto &hdr = header();
+            if (uint64_t(ref) + sizeof(uint32_t) > hdr.stringsSize)
+            {
+                return {};
+            }
+
+            const char *str = data + hdr.stringsOffset + ref;
+            uint32_t length;
+            std::memcpy(&length, str, sizeof(length));
+            if (length > hdr.stringsSize - ref - sizeof(uint32_t))
+            {
+                return {};
+            }
+
+            return std::string_view(str + sizeof(uint32_t), length);
+        }
+
+        /////////////////////////////////////////////////////////////////////////////
+    } // namespace binary
+
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueManager
+
+    bool DialogueManager::writeBinary(const std::string &filePath) const
+    {
+        std::ofstream file(filePath, std::ios::binary);
+        if (file.is_open())
+        {
+            return writeBinaryStream(file);
+        }
+
+        return false;
+    }
+
+    bool DialogueManager::writeBinaryStream(std::ostream &stream) const
+    {
+        StringTableBuilder strings;
+        std::vector<DialogueRecord> dialogueRecords;
+        std::vector<ParticipantRecord> participantRecords;
+        std::vector<EntryRecord> entryRecords;
+        std::vector<ChoiceRecord> choiceRecords;
+        std::vector<uint32_t> choiceRefs;
+        std::unordered_map<const void *, uint32_t> localIndex;
+
+        dialogueRecords.reserve(dialogues.size());
+        for (const auto &dlg : dialogues)
+        {
+            DialogueRecord dlgRecord{};
+            dlgRecord.name = strings.add(dlg->name);
+            dlgRecord.firstParticipant = static_cast<uint32_t>(participantRecords.size());
+            dlgRecord.numParticipants = static_cast<uint32_t>(dlg->participants.size());
+            dlgRecord.firstEntry = static_cast<uint32_t>(entryRecords.size());
+            dlgRecord.numEntries = static_cast<uint32_t>(dlg->entries.size());
+            dlgRecord.firstChoice = static_cast<uint32_t>(choiceRecords.size());
+            dlgRecord.numChoices = static_cast<uint32_t>(dlg->choices.size());
+
+            const auto indexOf = [&localIndex](const void *ptr) {
+                auto find = localIndex.find(ptr);
+                return find == localIndex.end() ? NO_INDEX : find->second;
+            };
+
+            localIndex.clear();
+            for (uint32_t i = 0; i < dlg->participants.size(); ++i)
+            {
+                localIndex.emplace(dlg->participants[i], i);
+            }
+            for (uint32_t i = 0; i < dlg->entries.size(); ++i)
+            {
+                localIndex.emplace(dlg->entries[i], i);
+            }
+            for (uint32_t i = 0; i < dlg->choices.size(); ++i)
+            {
+                localIndex.emplace(dlg->choices[i], i);
+            }
+
+            //Participants
+            for (const auto &participant : dlg->participants)
+            {
+                ParticipantRecord record{};
+                record.id = participant->id._id;
+                record.name = strings.add(participant->name.view());
+                participantRecords.push_back(record);
+            }
+
+            //Entries
+            for (const auto &entry : dlg->entries)
+            {
+                EntryRecord record{};
+                record.id = entry->id._id;
+                record.entry = strings.add(entry->entry.view());
+                record.participant = indexOf(entry->activeParticipant);
+                record.x = entry->viewPosition.x;
+                record.y = entry->viewPosition.y;
+                record.lReaction = static_cast<int32_t>(entry->lReaction);
+                record.rReaction = static_cast<int32_t>(entry->rReaction);
+                record.firstChoiceRef = static_cast<uint32_t>(choiceRefs.size());
+                record.numChoiceRefs = static_cast<uint32_t>(entry->choices.size());
+                for (const auto &choice : entry->choices)
+                {
+                    choiceRefs.push_back(indexOf(choice));
+                }
+                entryRecords.push_back(record);
+            }
+
+            //Choices
+            for (const auto &choice : dlg->choices)
+            {
+                ChoiceRecord record{};
+                record.id = choice->id._id;
+                record.choice = strings.add(choice->choice.view());
+                record.src = indexOf(choice->src);
+                record.dst = choice->dst ? indexOf(choice->dst) : NO_INDEX;
+                if (choice->guidAssigned)
+                {
+                    record.flags |= CHOICE_GUID_ASSIGNED;
+                    auto guid = choice->guid.value();
+                    std::copy(guid.begin(), guid.end(), record.guid);
+                }
+                choiceRecords.push_back(record);
+            }
+
+            dialogueRecords.push_back(dlgRecord);
+        }
+
+        Header header{};
+        std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+        header.version = FORMAT_VERSION;
+        header.eReactionVersion = E_REACTION_VERSION;
+        header.numDialogues = static_cast<uint32_t>(dialogueRecords.size());
+        header.numParticipants = static_cast<uint32_t>(participantRecords.size());
+        header.numEntries = static_cast<uint32_t>(entryRecords.size());
+        header.numChoices = static_cast<uint32_t>(choiceRecords.size());
+        header.numChoiceRefs = static_cast<uint32_t>(choiceRefs.size());
+        header.dialoguesOffset = alignSection(sizeof(Header));
+        header.participantsOffset = alignSection(header.dialoguesOffset + dialogueRecords.size() * sizeof(DialogueRecord));
+        header.entriesOffset = alignSection(header.participantsOffset + participantRecords.size() * sizeof(ParticipantRecord));
+        header.choicesOffset = alignSection(header.entriesOffset + entryRecords.size() * sizeof(EntryRecord));
+        header.choiceRefsOffset = alignSection(header.choicesOffset + choiceRecords.size() * sizeof(ChoiceRecord));
+        header.stringsOffset = alignSection(header.choiceRefsOffset + choiceRefs.size() * sizeof(uint32_t));
+        header.stringsSize = strings.data.size();
+
+        uint64_t written = sizeof(Header);
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        writeSection(stream, written, header.dialoguesOffset, dialogueRecords);
+        writeSection(stream, written, header.participantsOffset, participantRecords);
+        writeSection(stream, written, header.entriesOffset, entryRecords);
+        writeSection(stream, written, header.choicesOffset, choiceRecords);
+        writeSection(stream, written, header.choiceRefsOffset, choiceRefs);
+        writeSection(stream, written, header.stringsOffset, strings.data.data(), strings.data.size());
+
+        return stream.good();
+    }
+
+    DialogueManagerPtr DialogueManager::readBinary(const std::string &filePath)
+    {
+        std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+        if (file.is_open())
+        {
+            // Backed by uint64_t so the records can be read in place.
+            auto size = static_cast<size_t>(file.tellg());
+            std::vector<uint64_t> contents((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+            file.seekg(0);
+            if (file.read(reinterpret_cast<char *>(contents.data()), size))
+            {
+                return readBinaryContents(reinterpret_cast<const char *>(contents.data()), size);
+            }
+        }
+
+        return nullptr;
+    }
+
+    DialoguePtr DialogueManager::readBinaryDialogue(const ImageView &image, size_t index)
+    {
+        const auto &header = image.header();
+        if (index >= header.numDialogues || !image.validate(image.dialogues()[index]))
+        {
+            return nullptr;
+        }
+
+        const auto &dlgRecord = image.dialogues()[index];
+        auto dlgPtr = std::make_unique<Dialogue>(std::string(image.string(dlgRecord.name)));
+        dlgPtr->reserve(dlgRecord.numParticipants, dlgRecord.numEntries, dlgRecord.numChoices);
+
+        //Participants
+        std::vector<ParticipantPtr> participants;
+        participants.reserve(dlgRecord.numParticipants);
+        for (uint32_t i = 0; i < dlgRecord.numParticipants; ++i)
+        {
+            const auto &record = image.participants()[dlgRecord.firstParticipant + i];
+            participants.push_back(dlgPtr->addParticipant(InternedString(image.string(record.name)), ID{record.id}));
+        }
+
+        //Entries
+        std::vector<DialogueEntryPtr> entries;
+        entries.reserve(dlgRecord.numEntries);
+        for (uint32_t i = 0; i < dlgRecord.numEntries; ++i)
+        {
+            const auto &record = image.entries()[dlgRecord.firstEntry + i];
+            if (record.participant >= dlgRecord.numParticipants ||
+                !rangeInBounds(record.firstChoiceRef, record.numChoiceRefs, header.numChoiceRefs))
+            {
+                return nullptr;
+            }
+
+            auto entry = dlgPtr->addDialogueEntry(participants[record.participant], InternedString(image.string(record.entry)), ID{record.id});
+            entry->viewPosition = {record.x, record.y};
+            entry->lReaction = static_cast<eReaction>(record.lReaction);
+            entry->rReaction = static_cast<eReaction>(record.rReaction);
+            entries.push_back(entry);
+        }
+
+        //Choices
+        std::vector<DialogueChoicePtr> choices;
+        choices.reserve(dlgRecord.numChoices);
+        for (uint32_t i = 0; i < dlgRecord.numChoices; ++i)
+        {
+            const auto &record = image.choices()[dlgRecord.firstChoice + i];
+            if (record.src >= dlgRecord.numEntries || (record.dst != NO_INDEX && record.dst >= dlgRecord.numEntries))
+            {
+                return nullptr;
+            }
+
+            auto dst = record.dst == NO_INDEX ? nullptr : entries[record.dst];
+            auto choice = dlgPtr->addDialogueChoice(entries[record.src], InternedString(image.string(record.choice)), dst, ID{record.id});
+            if (record.flags & CHOICE_GUID_ASSIGNED)
+            {
+                Guid::GuidT guid;
+                std::copy(std::begin(record.guid), std::end(record.guid), guid.begin());
+                choice->assignGuid(guid);
+            }
+            choices.push_back(choice);
+        }
+
+        //Per entry choice order
+        // The refs have to list exactly the choices leaving the entry, each
+        // once, removing entries and choices relies on it.
+        std::vector<uint8_t> listed(dlgRecord.numChoices, 0);
+        for (uint32_t i = 0; i < dlgRecord.numEntries; ++i)
+        {
+            const auto &record = image.entries()[dlgRecord.firstEntry + i];
+            auto &entryChoices = entries[i]->choices;
+            if (record.numChoiceRefs != entryChoices.size())
+            {
+                return nullptr;
+            }
+            entryChoices.clear();
+            for (uint32_t c = 0; c < record.numChoiceRefs; ++c)
+            {
+                auto ref = image.choiceRefs()[record.firstChoiceRef + c];
+                if (ref >= dlgRecord.numChoices || listed[ref] || choices[ref]->src != entries[i])
+                {
+                    return nullptr;
+                }
+                listed[ref] = 1;
+                entryChoices.push_back(choices[ref]);
+            }
+        }
+
+        return dlgPtr.release();
+    }
+
+    DialogueManagerPtr DialogueManager::readBinaryContents(const char *data, size_t size)
+    {
+        if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0)
+        {
+            std::vector<uint64_t> aligned((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+            std::memcpy(aligned.data(), data, size);
+            return readBinaryContents(reinterpret_cast<const char *>(aligned.data()), size);
+        }
+
+        ImageView image(data, size);
+        if (!image.validate() || image.header().eReactionVersion != E_REACTION_VERSION)
+        {
+            assert(false);
+            return nullptr;
+        }
+
+        const auto &header = image.header();
+        auto mgr = std::make_unique<DialogueManager>();
+        mgr->dialogues.reserve(header.numDialogues);
+        for (uint32_t d = 0; d < header.numDialogues; ++d)
+        {
+            // A dialogue failing its checks is a corrupt file, not a bug, so it
+            // is only reported through the null result.
+            std::unique_ptr<Dialogue> dlg(readBinaryDialogue(image, d));
+            if (!dlg || !mgr->addDialogue(dlg.get()))
+            {
+                return nullptr;
+            }
+            dlg.release();
+        }
+
+        return mgr.release();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace floofy
+{
+  namespace binary
+  {
+    /////////////////////////////////////////////////////////////////////////////
+    //Layout
+    //
+    // Header | DialogueRecord[] | ParticipantRecord[] | EntryRecord[] | ChoiceRecord[] | uint32_t choiceRefs[] | strings
+    //
+    // All sections are 8 byte aligned and stored little-endian, the records are
+    // fixed width so the whole image can be used in place once validated.
+    // Participant, entry and choice indices stored in a record are relative to
+    // the owning dialogue's first* index, an entry's choice ref range indexes
+    // the global choiceRefs section. Strings are referenced by their byte offset
+    // into the string table, where they are stored as a uint32_t length followed
+    // by the bytes and a null terminator. Equal strings are only stored once.
+
+    constexpr char MAGIC[4] = {'F', 'D', 'L', 'G'};
+    constexpr uint32_t FORMAT_VERSION = 1;
+    constexpr uint32_t NO_INDEX = 0xFFFFFFFF;
+    constexpr uint32_t CHOICE_GUID_ASSIGNED = 1 << 0;
+
+    struct Header
+    {
+      char magic[4];
+      uint32_t version;
+      uint32_t eReactionVersion;
+      uint32_t numDialogues;
+      uint32_t numParticipants;
+      uint32_t numEntries;
+      uint32_t numChoices;
+      uint32_t numChoiceRefs;
+      uint64_t dialoguesOffset;
+      uint64_t participantsOffset;
+      uint64_t entriesOffset;
+      uint64_t choicesOffset;
+      uint64_t choiceRefsOffset;
+      uint64_t stringsOffset;
+      uint64_t stringsSize;
+    };
+    static_assert(sizeof(Header) == 88, "Binary header layout changed");
+
+    struct DialogueRecord
+    {
+      uint32_t name;
+      uint32_t firstParticipant;
+      uint32_t numParticipants;
+      uint32_t firstEntry;
+      uint32_t numEntries;
+      uint32_t firstChoice;
+      uint32_t numChoices;
+      uint32_t reserved;
+    };
+    static_assert(sizeof(DialogueRecord) == 32, "Binary dialogue layout changed");
+
+    struct ParticipantRecord
+    {
+      uint64_t id;
+      uint32_t name;
+      uint32_t reserved;
+    };
+    static_assert(sizeof(ParticipantRecord) == 16, "Binary participant layout changed");
+
+    struct EntryRecord
+    {
+      uint64_t id;
+      uint32_t entry;
+      uint32_t participant;
+      double x;
+      double y;
+      int32_t lReaction;
+      int32_t rReaction;
+      uint32_t firstChoiceRef;
+      uint32_t numChoiceRefs;
+    };
+    static_assert(sizeof(EntryRecord) == 48, "Binary entry layout changed");
+
+    struct ChoiceRecord
+    {
+      uint64_t id;
+      uint32_t choice;
+      uint32_t src;
+      uint32_t dst;
+      uint32_t flags;
+      uint8_t guid[16];
+    };
+    static_assert(sizeof(ChoiceRecord) == 40, "Binary choice layout changed");
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //ImageView
+    // Non-owning view over a complete binary image. validate() only checks the
+    // header and that every section lies within the image, so it is O(1).
+    // validate(record) checks a dialogue's record ranges, indices stored in the
+    // records must still be range checked by the caller. string() is always
+    // bounds checked and returns an empty view for a bad reference.
+    class ImageView
+    {
+    public:
+      ImageView() = default;
+      ImageView(const char *data, size_t size) : data(data), size(size) {}
+
+      bool validate() const;
+      bool validate(const DialogueRecord &record) const;
+
+      const Header &header() const { return *reinterpret_cast<const Header *>(data); }
+      const DialogueRecord *dialogues() const { return section<DialogueRecord>(header().dialoguesOffset); }
+      const ParticipantRecord *participants() const { return section<ParticipantRecord>(header().participantsOffset); }
+      const EntryRecord *entries() const { return section<EntryRecord>(header().entriesOffset); }
+      const ChoiceRecord *choices() const { return section<ChoiceRecord>(header().choicesOffset); }
+      const uint32_t *choiceRefs() const { return section<uint32_t>(header().choiceRefsOffset); }
+      std::string_view string(uint32_t ref) const;
+
+      const char *data = nullptr;
+      size_t size = 0;
+
+    private:
+      template <typename T>
+      const T *section(uint64_t offset) const
+      {
+        return reinterpret_cast<const T *>(data + offset);
+      }
+    };
+    /////////////////////////////////////////////////////////////////////////////
+  } // namespace binary
+} // namespace floofy
@@ -0,0 +1,315 @@
+#include "dialogue_history.hpp"
+#include "common/hash.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace floofy
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueHistory
+
+    DialogueHistoryPtr DialogueHistory::attach(DialogueManager &mgr, size_t budget)
+    {
+        if (mgr._history)
+        {
+            return nullptr;
+        }
+
+        DialogueHistoryPtr history(new DialogueHistory(mgr, budget));
+        mgr._history = history.get();
+        return history;
+    }
+
+    DialogueHistory::~DialogueHistory()
+    {
+        if (_manager)
+        {
+            _manager->_history = nullptr;
+        }
+    }
+
+    void DialogueHistory::begin()
+    {
+        ++_depth;
+    }
+
+    void DialogueHistory::commit()
+    {
+        if (_depth == 0 || --_depth != 0 || _open.changes.empty())
+        {
+            return;
+        }
+
+        _undoBytes += _open.bytes;
+        _undo.push_back(std::move(_open));
+        _open = {};
+        clearOpenFields();
+        trim();
+    }
+
+    bool DialogueHistory::undo()
+    {
+        if (_depth != 0 || _undo.empty())
+        {
+            return false;
+        }
+
+        auto transaction = std::move(_undo.back());
+        _undo.pop_back();
+        _undoBytes -= transaction.bytes;
+        apply(transaction, true);
+        _redoBytes += transaction.bytes;
+        _redo.push_back(std::move(transaction));
+        return true;
+    }
+
+    bool DialogueHistory::redo()
+    {
+        if (_depth != 0 || _redo.empty())
+        {
+            return false;
+        }
+
+        auto transaction = std::move(_redo.back());
+        _redo.pop_back();
+        _redoBytes -= transaction.bytes;
+        apply(transaction, false);
+        _undoBytes += transaction.bytes;
+        _undo.push_back(std::move(transaction));
+        return true;
+    }
+
+    void DialogueHistory::clear()
+    {
+        _open = {};
+        clearOpenFields();
+        _undo.clear();
+        _redo.clear();
+        _undoBytes = 0;
+        _redoBytes = 0;
+    }
+
+    void DialogueHistory::setBudget(size_t budget)
+    {
+        _budget = budget;
+        trim();
+    }
+
+    void DialogueHistory::record(DialogueChange change)
+    {
+        if (_applying || !_manager)
+        {
+            return;
+        }
+
+        // A new change leaves nothing to redo.
+        _redo.clear();
+        _redoBytes = 0;
+
+        // The first change of a field in the open transaction holds the value
+        // to go back to. Since changes swap values, it also redoes to the
+        // field's latest value, later ones would only repeat it.
+        if (_depth != 0 && change.isField() &&
+            !insertOpenField(reinterpret_cast<uintptr_t>(change.node) | static_cast<uintptr_t>(change.kind)))
+        {
+            return;
+        }
+
+        const auto bytes = changeBytes(change);
+        _open.changes.push_back(std::move(change));
+        _open.bytes += bytes;
+        if (_depth == 0)
+        {
+            _undoBytes += _open.bytes;
+            _undo.push_back(std::move(_open));
+            _open = {};
+            trim();
+        }
+    }
+
+    size_t DialogueHistory::changeBytes(const DialogueChange &change)
+    {
+        auto text = std::get_if<InternedString>(&change.value);
+        return sizeof(DialogueChange) + (text ? text->size() : 0);
+    }
+
+    void DialogueHistory::apply(Transaction &transaction, bool undo)
+    {
+        using Kind = DialogueChange::Kind;
+
+        _applying = true;
+        const auto numChanges = transaction.changes.size();
+        for (size_t i = 0; i < numChanges; ++i)
+        {
+            auto &change = transaction.changes[undo ? numChanges - 1 - i : i];
+            auto dialogue = change.dialogue;
+            auto participant = static_cast<ParticipantPtr>(change.node);
+            auto entry = static_cast<DialogueEntryPtr>(change.node);
+            auto choice = static_cast<DialogueChoicePtr>(change.node);
+            // Whether an add or removal puts the node back.
+            const bool attach = (change.kind == Kind::AddParticipant || change.kind == Kind::AddEntry || change.kind == Kind::AddChoice) != undo;
+
+            switch (change.kind)
+            {
+            case Kind::ParticipantName:
+            {
+                auto &name = std::get<InternedString>(change.value);
+                std::swap(participant->name, name);
+                if (participant->_dialogue)
+                {
+                    dialogue->resolveParticipantName(name);
+                    dialogue->resolveParticipantName(participant->name);
+                }
+                break;
+            }
+            case Kind::EntryText:
+                std::swap(entry->entry, std::get<InternedString>(change.value));
+                break;
+            case Kind::EntryParticipant:
+                std::swap(entry->activeParticipant, std::get<ParticipantPtr>(change.value));
+                break;
+            case Kind::EntryPosition:
+                std::swap(entry->viewPosition, std::get<DialogueEntry::Vector2>(change.value));
+                break;
+            case Kind::EntryReactions:
+            {
+                auto &reactions = std::get<std::pair<eReaction, eReaction>>(change.value);
+                std::swap(entry->lReaction, reactions.first);
+                std::swap(entry->rReaction, reactions.second);
+                break;
+            }
+            case Kind::ChoiceText:
+                std::swap(choice->choice, std::get<InternedString>(change.value));
+                break;
+            case Kind::ChoiceDst:
+            {
+                auto &dst = std::get<DialogueEntryPtr>(change.value);
+                auto current = choice->dst;
+                choice->setDst(dst);
+                dst = current;
+                break;
+            }
+            case Kind::ChoiceGuid:
+            {
+                auto &guid = std::get<std::pair<Guid, bool>>(change.value);
+                auto current = std::make_pair(choice->guid, choice->guidAssigned);
+                if (guid.second)
+                {
+                    choice->assignGuid(guid.first);
+                }
+                else
+                {
+                    choice->clearGuid();
+                    choice->guid = guid.first;
+                }
+                guid = current;
+                break;
+            }
+            case Kind::AddParticipant:
+            case Kind::RemoveParticipant:
+                if (attach)
+                {
+                    dialogue->attachParticipant(participant, std::get<size_t>(change.value));
+                }
+                else
+                {
+                    dialogue->detachParticipant(std::get<size_t>(change.value));
+                }
+                break;
+            case Kind::AddEntry:
+            case Kind::RemoveEntry:
+                if (attach)
+                {
+                    dialogue->attachEntry(entry);
+                }
+                else
+                {
+                    dialogue->detachEntry(entry);
+                }
+                break;
+            case Kind::AddChoice:
+            case Kind::RemoveChoice:
+                if (attach)
+                {
+                    dialogue->attachChoice(choice, std::get<size_t>(change.value));
+                }
+                else
+                {
+                    dialogue->detachChoice(choice);
+                }
+                break;
+            }
+            dialogue->markModified();
+        }
+        _applying = false;
+    }
+
+    // Drops the oldest transactions until the history fits its budget, the
+    // latest one is kept regardless.
+    void DialogueHistory::trim()
+    {
+        while (_budget != 0 && _undo.size() > 1 && bytes() > _budget)
+        {
+            _undoBytes -= _undo.front().bytes;
+            _undo.pop_front();
+            ++_numDropped;
+        }
+    }
+
+    bool DialogueHistory::insertOpenField(uintptr_t field)
+    {
+        // Kept at most half full.
+        if ((_numOpenFields + 1) * 2 > _openFields.size())
+        {
+            auto fields = std::move(_openFields);
+            _openFields.assign(std::max<size_t>(64, fields.size() * 2), 0);
+            _numOpenFields = 0;
+            for (auto old : fields)
+            {
+                if (old)
+                {
+                    insertOpenField(old);
+                }
+            }
+        }
+
+        const auto mask = _openFields.size() - 1;
+        auto index = static_cast<size_t>(hashMix(field)) & mask;
+        while (_openFields[index] != 0)
+        {
+            if (_openFields[index] == field)
+            {
+                return false;
+            }
+            index = (index + 1) & mask;
+        }
+
+        _openFields[index] = field;
+        ++_numOpenFields;
+        return true;
+    }
+
+    // A table grown by one large transaction is given back once it is mostly
+    // empty, rather than cleared whole after every small one.
+    void DialogueHistory::clearOpenFields()
+    {
+        if (_numOpenFields == 0)
+        {
+            return;
+        }
+
+        if (_openFields.size() > 64 && _numOpenFields * 16 < _openFields.size())
+        {
+            _openFields = {};
+        }
+        else
+        {
+            std::fill(_openFields.begin(), _openFields.end(), 0);
+        }
+        _numOpenFields = 0;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "dialogue_manager.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //Forward Decls
+  class DialogueHistory;
+  using DialogueHistoryPtr = std::unique_ptr<DialogueHistory>;
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueChange
+  // One reversible edit of a node. Field changes hold the other value of the
+  // field and are applied by swapping it with the node's, so the same change
+  // undoes and redoes. Adds and removals hold the node's position in the list
+  // it is put back into.
+  struct DialogueChange
+  {
+    enum class Kind : uint8_t
+    {
+      ParticipantName,
+      EntryText,
+      EntryParticipant,
+      EntryPosition,
+      EntryReactions,
+      ChoiceText,
+      ChoiceDst,
+      ChoiceGuid,
+      AddParticipant,
+      RemoveParticipant,
+      AddEntry,
+      RemoveEntry,
+      AddChoice,
+      RemoveChoice
+    };
+
+    // Whether the change sets a field, rather than adding or removing a node.
+    bool isField() const { return kind < Kind::AddParticipant; }
+    static_assert(static_cast<int>(Kind::AddParticipant) <= 8, "field kinds fit the low bits of a node address");
+
+    Kind kind;
+    DialoguePtr dialogue;
+    void *node;
+    std::variant<InternedString, ParticipantPtr, DialogueEntryPtr, DialogueEntry::Vector2, std::pair<eReaction, eReaction>,
+                 std::pair<Guid, bool>, size_t>
+        value;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueHistory
+  // Undo log of a manager. While a history is attached every change made to
+  // the manager's dialogues through their nodes, setters and adders is
+  // recorded, and undo and redo apply a whole transaction in one call.
+  // Changes made outside begin and commit are a transaction each. Within a
+  // transaction a field changed more than once is recorded once, with the
+  // value it had before the first change, so a drag sending a position per
+  // frame holds one change per node.
+  //
+  // The budget bounds the bytes held by undoable transactions, the oldest
+  // ones are dropped to stay below it, the latest is always kept. Dialogue
+  // level changes, adding, removing, renaming and reordering dialogues, are
+  // not recorded. Removing a dialogue or reloading the manager clears the
+  // history, since the dialogue's nodes may be freed.
+  class DialogueHistory
+  {
+  public:
+    // nullptr when the manager already has a history attached.
+    static DialogueHistoryPtr attach(DialogueManager &mgr, size_t budget);
+
+    DialogueHistory(const DialogueHistory &) = delete;
+    DialogueHistory &operator=(const DialogueHistory &) = delete;
+    ~DialogueHistory();
+
+    // Transactions nest, changes are grouped until the outermost commit.
+    void begin();
+    void commit();
+
+    // False when there is nothing to undo or redo or a transaction is open.
+    bool undo();
+    bool redo();
+
+    void clear();
+    void setBudget(size_t budget);
+
+    size_t numUndo() const { return _undo.size(); }
+    size_t numRedo() const { return _redo.size(); }
+    // Transactions dropped to stay within the budget since the history was
+    // attached. It only grows, clearing is not counted, so a caller keeping
+    // an entry per transaction can tell how many of its oldest ones are gone
+    // even when as many new ones arrived meanwhile.
+    size_t numDropped() const { return _numDropped; }
+    // Bytes held by undoable and redoable transactions.
+    size_t bytes() const { return _undoBytes + _redoBytes; }
+
+    // Called by the model for every change while it is attached, the change
+    // holds the value the node had before.
+    void record(DialogueChange change);
+
+  private:
+    friend class DialogueManager;
+
+    struct Transaction
+    {
+      std::vector<DialogueChange> changes;
+      size_t bytes = 0;
+    };
+
+    DialogueHistory(DialogueManager &mgr, size_t budget) : _manager(&mgr), _budget(budget) {}
+
+    static size_t changeBytes(const DialogueChange &change);
+    void apply(Transaction &transaction, bool undo);
+    void trim();
+    // Adds the field to the set, false when it was in it already.
+    bool insertOpenField(uintptr_t field);
+    void clearOpenFields();
+
+    DialogueManagerPtr _manager;
+    size_t _budget;
+    size_t _depth = 0;
+    bool _applying = false;
+    Transaction _open;
+    // Fields already recorded in the open transaction as node addresses with
+    // the kind of change in their low bits, which are free since nodes are
+    // 8 byte aligned. An open addressing set that keeps its slots from one
+    // transaction to the next, so recording allocates nothing.
+    std::vector<uintptr_t> _openFields;
+    size_t _numOpenFields = 0;
+    std::deque<Transaction> _undo;
+    std::vector<Transaction> _redo;
+    size_t _undoBytes = 0;
+    size_t _redoBytes = 0;
+    size_t _numDropped = 0;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
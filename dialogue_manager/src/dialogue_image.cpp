@@ -0,0 +1,314 @@
+#include "dialogue_image.hpp"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace floofy
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueImage
+
+    DialogueImagePtr DialogueImage::open(const std::string &filePath)
+    {
+        DialogueImagePtr image(new DialogueImage);
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+        image->_file = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            return nullptr;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+        {
+            return nullptr;
+        }
+        image->_mapping = mapping;
+
+        const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data)
+        {
+            return nullptr;
+        }
+        image->_view = binary::ImageView(static_cast<const char *>(data), static_cast<size_t>(size.QuadPart));
+#else
+        int fd = ::open(filePath.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return nullptr;
+        }
+
+        void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        image->_mapping = data;
+        image->_view = binary::ImageView(static_cast<const char *>(data), static_cast<size_t>(info.st_size));
+#endif
+
+        if (!image->_view.validate())
+        {
+            return nullptr;
+        }
+
+        return image;
+    }
+
+    DialogueImage::~DialogueImage()
+    {
+#ifdef _WIN32
+        if (_view.data)
+        {
+            UnmapViewOfFile(_view.data);
+        }
+        if (_mapping)
+        {
+            CloseHandle(_mapping);
+        }
+        if (_file)
+        {
+            CloseHandle(_file);
+        }
+#else
+        if (_mapping)
+        {
+            munmap(_mapping, _view.size);
+        }
+#endif
+    }
+
+    size_t DialogueImage::numDialogues() const
+    {
+        return _view.header().numDialogues;
+    }
+
+    ImageDialogue DialogueImage::dialogue(size_t index) const
+    {
+        if (index >= numDialogues())
+        {
+            return {};
+        }
+
+        return ImageDialogue(&_view, _view.dialogues() + index);
+    }
+
+    ImageDialogue DialogueImage::dialogue(std::string_view name) const
+    {
+        const auto begin = _view.dialogues();
+        const auto end = begin + numDialogues();
+        auto find = std::find_if(begin, end, [this, name](const binary::DialogueRecord &record) {
+            return _view.string(record.name) == name;
+        });
+
+        return find == end ? ImageDialogue{} : ImageDialogue(&_view, find);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //ImageDialogue
+
+    ImageDialogue::ImageDialogue(const binary::ImageView *image, const binary::DialogueRecord *record)
+        : _image(image), _record(image->validate(*record) ? record : nullptr)
+    {
+    }
+
+    size_t ImageDialogue::index() const
+    {
+        return _record ? static_cast<size_t>(_record - _image->dialogues()) : 0;
+    }
+
+    std::string_view ImageDialogue::name() const
+    {
+        return _record ? _image->string(_record->name) : std::string_view{};
+    }
+
+    size_t ImageDialogue::numParticipants() const
+    {
+        return _record ? _record->numParticipants : 0;
+    }
+
+    ImageParticipant ImageDialogue::participant(size_t index) const
+    {
+        if (index >= numParticipants())
+        {
+            return {};
+        }
+
+        return ImageParticipant(_image, _image->participants() + _record->firstParticipant + index, index);
+    }
+
+    size_t ImageDialogue::numDialogueEntries() const
+    {
+        return _record ? _record->numEntries : 0;
+    }
+
+    ImageEntry ImageDialogue::dialogueEntry(size_t index) const
+    {
+        if (index >= numDialogueEntries())
+        {
+            return {};
+        }
+
+        return ImageEntry(*this, _image->entries() + _record->firstEntry + index, index);
+    }
+
+    size_t ImageDialogue::numDialogueChoices() const
+    {
+        return _record ? _record->numChoices : 0;
+    }
+
+    ImageChoice ImageDialogue::choice(size_t index) const
+    {
+        if (index >= numDialogueChoices())
+        {
+            return {};
+        }
+
+        return ImageChoice(*this, _image->choices() + _record->firstChoice + index, index);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //ImageParticipant
+
+    size_t ImageParticipant::id() const
+    {
+        return _record ? static_cast<size_t>(_record->id) : 0;
+    }
+
+    std::string_view ImageParticipant::name() const
+    {
+        return _record ? _image->string(_record->name) : std::string_view{};
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //ImageEntry
+
+    size_t ImageEntry::id() const
+    {
+        return _record ? static_cast<size_t>(_record->id) : 0;
+    }
+
+    std::string_view ImageEntry::entry() const
+    {
+        return _record ? _dialogue._image->string(_record->entry) : std::string_view{};
+    }
+
+    ImageParticipant ImageEntry::activeParticipant() const
+    {
+        return _record ? _dialogue.participant(_record->participant) : ImageParticipant{};
+    }
+
+    double ImageEntry::positionX() const
+    {
+        return _record ? _record->x : 0;
+    }
+
+    double ImageEntry::positionY() const
+    {
+        return _record ? _record->y : 0;
+    }
+
+    int ImageEntry::lReaction() const
+    {
+        return _record ? _record->lReaction : 0;
+    }
+
+    int ImageEntry::rReaction() const
+    {
+        return _record ? _record->rReaction : 0;
+    }
+
+    size_t ImageEntry::numDialogueChoices() const
+    {
+        if (!_record || uint64_t(_record->firstChoiceRef) + _record->numChoiceRefs > _dialogue._image->header().numChoiceRefs)
+        {
+            return 0;
+        }
+
+        return _record->numChoiceRefs;
+    }
+
+    ImageChoice ImageEntry::choice(size_t index) const
+    {
+        if (index >= numDialogueChoices())
+        {
+            return {};
+        }
+
+        return _dialogue.choice(_dialogue._image->choiceRefs()[_record->firstChoiceRef + index]);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //ImageChoice
+
+    size_t ImageChoice::id() const
+    {
+        return _record ? static_cast<size_t>(_record->id) : 0;
+    }
+
+    std::string_view ImageChoice::choice() const
+    {
+        return _record ? _dialogue._image->string(_record->choice) : std::string_view{};
+    }
+
+    ImageEntry ImageChoice::src() const
+    {
+        return _record ? _dialogue.dialogueEntry(_record->src) : ImageEntry{};
+    }
+
+    ImageEntry ImageChoice::dst() const
+    {
+        return _record ? _dialogue.dialogueEntry(_record->dst) : ImageEntry{};
+    }
+
+    bool ImageChoice::guidAssigned() const
+    {
+        return _record && (_record->flags & binary::CHOICE_GUID_ASSIGNED);
+    }
+
+    Guid ImageChoice::guid() const
+    {
+        Guid::GuidT value{};
+        if (_record)
+        {
+            std::copy(std::begin(_record->guid), std::end(_record->guid), value.begin());
+        }
+        return Guid(value);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
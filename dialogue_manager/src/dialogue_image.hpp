@@ -0,0 +1,163 @@
+#pragma once
+
+#include "dialogue_binary.hpp"
+#include "common/guid.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //Forward Decls
+  class DialogueImage;
+  using DialogueImagePtr = std::unique_ptr<DialogueImage>;
+  class ImageDialogue;
+  class ImageEntry;
+  class ImageChoice;
+  class ImageParticipant;
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueImage
+  // Read-only dialogues backed by a memory mapped binary dialogue file (see
+  // dialogue_binary.hpp). Opening only validates the header, nothing is copied
+  // or allocated per record, the views below point straight into the mapping
+  // and are valid for the lifetime of the image. The mapping is shared, so
+  // processes opening the same file share its pages.
+  class DialogueImage
+  {
+  public:
+    static DialogueImagePtr open(const std::string &filePath);
+
+    DialogueImage(const DialogueImage &) = delete;
+    DialogueImage &operator=(const DialogueImage &) = delete;
+    ~DialogueImage();
+
+    size_t numDialogues() const;
+    ImageDialogue dialogue(size_t index) const;
+    ImageDialogue dialogue(std::string_view name) const;
+
+    const binary::ImageView &view() const { return _view; }
+
+  private:
+    DialogueImage() = default;
+
+    binary::ImageView _view;
+    void *_file = nullptr;
+    void *_mapping = nullptr;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //ImageDialogue
+  // Views are small value types, a default constructed or out of range view is
+  // invalid and returns empty values from all accessors.
+  class ImageDialogue
+  {
+  public:
+    ImageDialogue() = default;
+    ImageDialogue(const binary::ImageView *image, const binary::DialogueRecord *record);
+
+    explicit operator bool() const { return _record != nullptr; }
+
+    size_t index() const;
+    std::string_view name() const;
+
+    size_t numParticipants() const;
+    ImageParticipant participant(size_t index) const;
+
+    size_t numDialogueEntries() const;
+    ImageEntry dialogueEntry(size_t index) const;
+
+    size_t numDialogueChoices() const;
+    ImageChoice choice(size_t index) const;
+
+  private:
+    friend class ImageEntry;
+    friend class ImageChoice;
+
+    const binary::ImageView *_image = nullptr;
+    const binary::DialogueRecord *_record = nullptr;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //ImageParticipant
+  class ImageParticipant
+  {
+  public:
+    ImageParticipant() = default;
+    ImageParticipant(const binary::ImageView *image, const binary::ParticipantRecord *record, size_t index)
+        : _image(image), _record(record), _index(index) {}
+
+    explicit operator bool() const { return _record != nullptr; }
+
+    size_t index() const { return _index; }
+    size_t id() const;
+    std::string_view name() const;
+
+  private:
+    const binary::ImageView *_image = nullptr;
+    const binary::ParticipantRecord *_record = nullptr;
+    size_t _index = 0;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //ImageEntry
+  class ImageEntry
+  {
+  public:
+    ImageEntry() = default;
+    ImageEntry(ImageDialogue dialogue, const binary::EntryRecord *record, size_t index)
+        : _dialogue(dialogue), _record(record), _index(index) {}
+
+    explicit operator bool() const { return _record != nullptr; }
+
+    size_t index() const { return _index; }
+    size_t id() const;
+    std::string_view entry() const;
+    ImageParticipant activeParticipant() const;
+    double positionX() const;
+    double positionY() const;
+    int lReaction() const;
+    int rReaction() const;
+
+    size_t numDialogueChoices() const;
+    ImageChoice choice(size_t index) const;
+
+  private:
+    ImageDialogue _dialogue;
+    const binary::EntryRecord *_record = nullptr;
+    size_t _index = 0;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //ImageChoice
+  class ImageChoice
+  {
+  public:
+    ImageChoice() = default;
+    ImageChoice(ImageDialogue dialogue, const binary::ChoiceRecord *record, size_t index)
+        : _dialogue(dialogue), _record(record), _index(index) {}
+
+    explicit operator bool() const { return _record != nullptr; }
+
+    size_t index() const { return _index; }
+    size_t id() const;
+    std::string_view choice() const;
+    ImageEntry src() const;
+    ImageEntry dst() const;
+    bool guidAssigned() const;
+    Guid guid() const;
+
+  private:
+    ImageDialogue _dialogue;
+    const binary::ChoiceRecord *_record = nullptr;
+    size_t _index = 0;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
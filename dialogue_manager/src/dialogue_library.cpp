@@ -0,0 +1,96 @@
+#include "dialogue_library.hpp"
+
+namespace floofy
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueLibrary
+
+    DialogueLibraryPtr DialogueLibrary::open(const std::string &filePath, size_t budget)
+    {
+        auto image = DialogueImage::open(filePath);
+        if (!image || image->view().header().eReactionVersion != E_REACTION_VERSION)
+        {
+            return nullptr;
+        }
+
+        DialogueLibraryPtr library(new DialogueLibrary);
+        const auto numDialogues = image->numDialogues();
+        library->_indexByName.reserve(numDialogues);
+        for (size_t i = 0; i < numDialogues; ++i)
+        {
+            library->_indexByName.emplace(image->dialogue(i).name(), i);
+        }
+        library->_slots.resize(numDialogues);
+        library->_image = std::move(image);
+        library->_budget = budget;
+        return library;
+    }
+
+    size_t DialogueLibrary::numDialogues() const
+    {
+        return _slots.size();
+    }
+
+    std::string_view DialogueLibrary::name(size_t index) const
+    {
+        return _image->dialogue(index).name();
+    }
+
+    size_t DialogueLibrary::index(std::string_view name) const
+    {
+        auto find = _indexByName.find(name);
+        return find == _indexByName.end() ? NO_INDEX : find->second;
+    }
+
+    DialoguePtr DialogueLibrary::dialogue(size_t index)
+    {
+        if (index >= _slots.size())
+        {
+            return nullptr;
+        }
+
+        auto &slot = _slots[index];
+        if (slot.dialogue)
+        {
+            _lru.splice(_lru.begin(), _lru, slot.lru);
+            return slot.dialogue.get();
+        }
+
+        slot.dialogue.reset(DialogueManager::readBinaryDialogue(_image->view(), index));
+        if (!slot.dialogue)
+        {
+            return nullptr;
+        }
+
+        slot.lru = _lru.insert(_lru.begin(), index);
+        evict();
+        return slot.dialogue.get();
+    }
+
+    DialoguePtr DialogueLibrary::dialogue(std::string_view name)
+    {
+        return dialogue(index(name));
+    }
+
+    bool DialogueLibrary::loaded(size_t index) const
+    {
+        return index < _slots.size() && _slots[index].dialogue;
+    }
+
+    void DialogueLibrary::setBudget(size_t budget)
+    {
+        _budget = budget;
+        evict();
+    }
+
+    void DialogueLibrary::evict()
+    {
+        while (_budget != 0 && _lru.size() > _budget)
+        {
+            _slots[_lru.back()].dialogue.reset();
+            _lru.pop_back();
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "dialogue_image.hpp"
+#include "dialogue_manager.hpp"
+
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //Forward Decls
+  class DialogueLibrary;
+  using DialogueLibraryPtr = std::unique_ptr<DialogueLibrary>;
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueLibrary
+  // Loads dialogues of a binary dialogue file on demand. Opening maps the file
+  // and indexes the dialogue names, a dialogue is only read into a Dialogue
+  // when first asked for and then kept for later calls.
+  //
+  // With a budget, at most that many dialogues are kept loaded and the least
+  // recently used one is freed to make room. A returned dialogue stays valid
+  // until it is evicted, or for the library's lifetime without a budget.
+  // Loaded dialogues belong to no manager, changes to them are not written
+  // back and are lost on eviction. Not thread safe.
+  class DialogueLibrary
+  {
+  public:
+    static constexpr size_t NO_INDEX = static_cast<size_t>(-1);
+
+    // A budget of 0 keeps every loaded dialogue.
+    static DialogueLibraryPtr open(const std::string &filePath, size_t budget = 0);
+
+    DialogueLibrary(const DialogueLibrary &) = delete;
+    DialogueLibrary &operator=(const DialogueLibrary &) = delete;
+
+    size_t numDialogues() const;
+    std::string_view name(size_t index) const;
+    size_t index(std::string_view name) const;
+
+    DialoguePtr dialogue(size_t index);
+    DialoguePtr dialogue(std::string_view name);
+
+    bool loaded(size_t index) const;
+    size_t numLoaded() const { return _lru.size(); }
+
+    size_t budget() const { return _budget; }
+    void setBudget(size_t budget);
+
+  private:
+    DialogueLibrary() = default;
+
+    void evict();
+
+    struct Slot
+    {
+      std::unique_ptr<Dialogue> dialogue;
+      std::list<size_t>::iterator lru;
+    };
+
+    DialogueImagePtr _image;
+    // Names point into the mapping, duplicates resolve to the first.
+    std::unordered_map<std::string_view, size_t> _indexByName;
+    std::vector<Slot> _slots;
+    // Loaded dialogues, most recently used first.
+    std::list<size_t> _lru;
+    size_t _budget = 0;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -1,26 +1,24 @@
 #include "dialogue_manager.hpp"
+#include "dialogue_history.hpp"
+#include "common/parallel.hpp"
 
 #include <nlohmann/json.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
-#include <iomanip>
-#include <sstream>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace
 {
-    struct FindDlgByNameFunctor
-    {
-        std::string name;
-
-        bool operator()(const floofy::DialoguePtr &dlg) const
-        {
-            return name == dlg->name;
-        }
-    };
-
     static constexpr int FILE_VERSION = 3;
-    constexpr unsigned E_REACTION_VERSION = 1;
 
     floofy::eReaction ReactionFromInt(int val, unsigned reactionVersion)
     {
@@ -33,6 +31,901 @@ namespace
         assert(false);
         return floofy::eReaction::None;
     }
+
+    /////////////////////////////////////////////////////////////////////////////
+    //JsonStreamWriter
+    // Writes json straight to a stream, formatted the way nlohmann dumps it
+    // with an indent of 2, or with no whitespace at all when indent is false.
+    class JsonStreamWriter
+    {
+    public:
+        JsonStreamWriter(std::ostream &stream, bool indent) : _stream(stream), _indent(indent)
+        {
+        }
+
+        JsonStreamWriter &beginObject() { return open('{'); }
+        JsonStreamWriter &endObject() { return close('}'); }
+        JsonStreamWriter &beginArray() { return open('['); }
+        JsonStreamWriter &endArray() { return close(']'); }
+
+        JsonStreamWriter &key(std::string_view name)
+        {
+            separate();
+            writeString(name);
+            _stream.write(": ", _indent ? 2 : 1);
+            _afterKey = true;
+            return *this;
+        }
+
+        JsonStreamWriter &value(std::string_view str)
+        {
+            separate();
+            writeString(str);
+            return *this;
+        }
+
+        JsonStreamWriter &unsignedValue(uint64_t val)
+        {
+            char buf[24];
+            auto result = std::to_chars(buf, buf + sizeof(buf), val);
+            return raw(buf, result.ptr);
+        }
+
+        JsonStreamWriter &integerValue(int64_t val)
+        {
+            char buf[24];
+            auto result = std::to_chars(buf, buf + sizeof(buf), val);
+            return raw(buf, result.ptr);
+        }
+
+        JsonStreamWriter &floatValue(double val)
+        {
+            if (!std::isfinite(val))
+            {
+                return raw("null", 4);
+            }
+
+            char buf[32];
+            auto end = std::to_chars(buf, buf + sizeof(buf) - 2, val).ptr;
+            if (std::find_if(buf, end, [](char c) { return c == '.' || c == 'e'; }) == end)
+            {
+                *end++ = '.';
+                *end++ = '0';
+            }
+            return raw(buf, end);
+        }
+
+    private:
+        JsonStreamWriter &raw(const char *begin, const char *end)
+        {
+            return raw(begin, static_cast<size_t>(end - begin));
+        }
+
+        JsonStreamWriter &raw(const char *str, size_t size)
+        {
+            separate();
+            _stream.write(str, size);
+            return *this;
+        }
+
+        JsonStreamWriter &open(char bracket)
+        {
+            separate();
+            _stream.put(bracket);
+            ++_depth;
+            _first = true;
+            return *this;
+        }
+
+        JsonStreamWriter &close(char bracket)
+        {
+            --_depth;
+            if (!_first)
+            {
+                newline();
+            }
+            _stream.put(bracket);
+            _first = false;
+            return *this;
+        }
+
+        void separate()
+        {
+            if (_afterKey)
+            {
+                _afterKey = false;
+                return;
+            }
+
+            if (_depth > 0)
+            {
+                if (!_first)
+                {
+                    _stream.put(',');
+                }
+                newline();
+            }
+            _first = false;
+        }
+
+        void newline()
+        {
+            if (!_indent)
+            {
+                return;
+            }
+
+            static const std::string spaces(64, ' ');
+            _stream.put('\n');
+            for (size_t remaining = _depth * 2; remaining > 0;)
+            {
+                auto count = std::min(remaining, spaces.size());
+                _stream.write(spaces.data(), count);
+                remaining -= count;
+            }
+        }
+
+        void writeString(std::string_view str)
+        {
+            static const char hex[] = "0123456789abcdef";
+
+            _stream.put('"');
+            size_t run = 0;
+            for (size_t i = 0; i < str.size(); ++i)
+            {
+                const auto c = static_cast<unsigned char>(str[i]);
+                if (c >= 0x20 && c != '"' && c != '\\')
+                {
+                    continue;
+                }
+
+                _stream.write(str.data() + run, i - run);
+                run = i + 1;
+
+                char escaped[6] = {'\\', 0, 0, 0, 0, 0};
+                size_t length = 2;
+                switch (c)
+                {
+                case '"': escaped[1] = '"'; break;
+                case '\\': escaped[1] = '\\'; break;
+                case '\b': escaped[1] = 'b'; break;
+                case '\f': escaped[1] = 'f'; break;
+                case '\n': escaped[1] = 'n'; break;
+                case '\r': escaped[1] = 'r'; break;
+                case '\t': escaped[1] = 't'; break;
+                default:
+                    escaped[1] = 'u';
+                    escaped[2] = '0';
+                    escaped[3] = '0';
+                    escaped[4] = hex[c >> 4];
+                    escaped[5] = hex[c & 0xF];
+                    length = 6;
+                    break;
+                }
+                _stream.write(escaped, length);
+            }
+            _stream.write(str.data() + run, str.size() - run);
+            _stream.put('"');
+        }
+
+        std::ostream &_stream;
+        const bool _indent;
+        size_t _depth = 0;
+        bool _first = true;
+        bool _afterKey = false;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueSaxReader
+    // Streams the json through nlohmann's SAX interface instead of building a
+    // DOM. Object keys are not ordered (nlohmann writes them sorted, so choices
+    // come before entries), so each dialogue is buffered into a ParsedDialogue,
+    // taking ownership of the parsed strings, and handed to onDialogue once its
+    // object closes. Peak memory is bounded by the largest dialogue.
+
+    struct ParsedParticipant
+    {
+        bool hasId = false, hasName = false;
+        size_t id = 0;
+        floofy::InternedString name;
+    };
+
+    struct ParsedEntry
+    {
+        bool hasId = false, hasEntry = false, hasActiveParticipant = false;
+        size_t id = 0;
+        floofy::InternedString entry;
+        size_t activeParticipant = 0;
+        double x = 0, y = 0;
+        int lReaction = 0, rReaction = 0;
+    };
+
+    struct ParsedChoice
+    {
+        bool hasId = false, hasChoice = false, hasSrc = false, hasDst = false;
+        size_t id = 0;
+        floofy::InternedString choice;
+        size_t src = 0, dst = 0;
+        size_t guidBytes = 0;
+        floofy::Guid::GuidT guid{};
+    };
+
+    struct ParsedDialogue
+    {
+        bool hasName = false, hasParticipants = false, hasEntries = false, hasChoices = false;
+        std::string name;
+        std::vector<ParsedParticipant> participants;
+        std::vector<ParsedEntry> entries;
+        std::vector<ParsedChoice> choices;
+    };
+
+    template <typename OnDialogue>
+    class DialogueSaxReader
+    {
+    public:
+        using json = nlohmann::json;
+
+        explicit DialogueSaxReader(OnDialogue onDialogue) : _onDialogue(std::move(onDialogue))
+        {
+        }
+
+        bool null() { return scalar(); }
+        bool boolean(bool) { return scalar(); }
+        bool number_integer(json::number_integer_t val) { return number(static_cast<size_t>(val), static_cast<double>(val)); }
+        bool number_unsigned(json::number_unsigned_t val) { return number(static_cast<size_t>(val), static_cast<double>(val)); }
+        bool number_float(json::number_float_t val, const json::string_t &) { return number(val >= 0 && val < 1e18 ? static_cast<size_t>(val) : 0, val); }
+        template <typename Binary>
+        bool binary(Binary &) { return scalar(); }
+
+        bool string(json::string_t &val)
+        {
+            switch (top())
+            {
+            case Context::Dialogue:
+                return _field == Field::Name ? assign(_dialogue.hasName, _dialogue.name, val) : ignore();
+            case Context::Participant:
+                return _field == Field::Name ? assign(_dialogue.participants.back().hasName, _dialogue.participants.back().name, val) : ignore();
+            case Context::Entry:
+                return _field == Field::Entry ? assign(_dialogue.entries.back().hasEntry, _dialogue.entries.back().entry, val) : ignore();
+            case Context::Choice:
+                return _field == Field::Choice ? assign(_dialogue.choices.back().hasChoice, _dialogue.choices.back().choice, val) : ignore();
+            default:
+                return scalar();
+            }
+        }
+
+        bool key(json::string_t &val)
+        {
+            _field = fieldFromKey(val);
+            return true;
+        }
+
+        bool start_object(std::size_t)
+        {
+            if (_contexts.empty())
+            {
+                return push(Context::Root);
+            }
+
+            switch (top())
+            {
+            case Context::Dialogues:
+                _dialogue.hasName = _dialogue.hasParticipants = _dialogue.hasEntries = _dialogue.hasChoices = false;
+                _dialogue.participants.clear();
+                _dialogue.entries.clear();
+                _dialogue.choices.clear();
+                return push(Context::Dialogue);
+            case Context::Participants:
+                _dialogue.participants.emplace_back();
+                return push(Context::Participant);
+            case Context::Entries:
+                _dialogue.entries.emplace_back();
+                return push(Context::Entry);
+            case Context::Choices:
+                _dialogue.choices.emplace_back();
+                return push(Context::Choice);
+            case Context::Entry:
+                return _field == Field::Position ? push(Context::Position) : nested();
+            default:
+                return nested();
+            }
+        }
+
+        bool end_object()
+        {
+            auto context = top();
+            _contexts.pop_back();
+            if (context == Context::Dialogue && !_onDialogue(_dialogue))
+            {
+                return fail();
+            }
+            if (context == Context::Root)
+            {
+                _finished = true;
+            }
+            return true;
+        }
+
+        bool start_array(std::size_t)
+        {
+            if (_contexts.empty())
+            {
+                return fail();
+            }
+
+            switch (top())
+            {
+            case Context::Root:
+                return _field == Field::Dialogues ? (_hasDialogues = true, push(Context::Dialogues)) : nested();
+            case Context::Dialogue:
+                switch (_field)
+                {
+                case Field::Participants:
+                    return _dialogue.hasParticipants = true, push(Context::Participants);
+                case Field::Entries:
+                    return _dialogue.hasEntries = true, push(Context::Entries);
+                case Field::Choices:
+                    return _dialogue.hasChoices = true, push(Context::Choices);
+                default:
+                    return nested();
+                }
+            case Context::Choice:
+                return _field == Field::Guid ? push(Context::Guid) : nested();
+            default:
+                return nested();
+            }
+        }
+
+        bool end_array()
+        {
+            _contexts.pop_back();
+            return true;
+        }
+
+        template <typename Exception>
+        bool parse_error(std::size_t, const std::string &, const Exception &)
+        {
+            return false;
+        }
+
+        bool failed() const { return _failed; }
+        bool finished() const { return _finished && _hasDialogues && !_failed; }
+        int fileVersion() const { return _fileVersion; }
+        unsigned eReactionVersion() const { return _eReactionVersion; }
+
+    private:
+        enum class Context
+        {
+            Root,
+            Dialogues,
+            Dialogue,
+            Participants,
+            Participant,
+            Entries,
+            Entry,
+            Position,
+            Choices,
+            Choice,
+            Guid,
+            Skip
+        };
+
+        enum class Field
+        {
+            Unknown,
+            Version,
+            EReactionVersion,
+            Dialogues,
+            Name,
+            Participants,
+            Entries,
+            Choices,
+            Id,
+            Entry,
+            ActiveParticipant,
+            Position,
+            X,
+            Y,
+            LReaction,
+            RReaction,
+            Choice,
+            Src,
+            Dst,
+            Guid
+        };
+
+        static Field fieldFromKey(const std::string &key)
+        {
+            static const std::unordered_map<std::string, Field> fields{
+                {"version", Field::Version},
+                {"eReactionVersion", Field::EReactionVersion},
+                {"dialogues", Field::Dialogues},
+                {"name", Field::Name},
+                {"participants", Field::Participants},
+                {"entries", Field::Entries},
+                {"choices", Field::Choices},
+                {"id", Field::Id},
+                {"entry", Field::Entry},
+                {"activeParticipant", Field::ActiveParticipant},
+                {"position", Field::Position},
+                {"x", Field::X},
+                {"y", Field::Y},
+                {"lReaction", Field::LReaction},
+                {"rReaction", Field::RReaction},
+                {"choice", Field::Choice},
+                {"src", Field::Src},
+                {"dst", Field::Dst},
+                {"guid", Field::Guid}};
+
+            auto find = fields.find(key);
+            return find == fields.end() ? Field::Unknown : find->second;
+        }
+
+        Context top() const
+        {
+            return _contexts.back();
+        }
+
+        bool push(Context context)
+        {
+            _contexts.push_back(context);
+            return true;
+        }
+
+        bool fail()
+        {
+            _failed = true;
+            return false;
+        }
+
+        // Values of unknown keys are skipped, anything else in the wrong place is an error.
+        bool ignore()
+        {
+            return _field == Field::Unknown || top() == Context::Skip ? true : fail();
+        }
+
+        bool nested()
+        {
+            return ignore() && push(Context::Skip);
+        }
+
+        bool scalar()
+        {
+            switch (top())
+            {
+            case Context::Root:
+            case Context::Dialogue:
+            case Context::Participant:
+            case Context::Entry:
+            case Context::Position:
+            case Context::Choice:
+            case Context::Skip:
+                return ignore();
+            default:
+                return fail();
+            }
+        }
+
+        bool assign(bool &has, std::string &dst, std::string &val)
+        {
+            has = true;
+            dst = std::move(val);
+            return true;
+        }
+
+        // Interns straight from the parser's buffer, which it keeps reusing.
+        bool assign(bool &has, floofy::InternedString &dst, const std::string &val)
+        {
+            has = true;
+            dst = floofy::InternedString(val);
+            return true;
+        }
+
+        bool assign(bool &has, size_t &dst, size_t val)
+        {
+            has = true;
+            dst = val;
+            return true;
+        }
+
+        bool number(size_t val, double dbl)
+        {
+            switch (top())
+            {
+            case Context::Root:
+                switch (_field)
+                {
+                case Field::Version:
+                    _fileVersion = static_cast<int>(val);
+                    return true;
+                case Field::EReactionVersion:
+                    _eReactionVersion = static_cast<unsigned>(val);
+                    return true;
+                default:
+                    return ignore();
+                }
+            case Context::Participant:
+            {
+                auto &part = _dialogue.participants.back();
+                return _field == Field::Id ? assign(part.hasId, part.id, val) : ignore();
+            }
+            case Context::Entry:
+            {
+                auto &entry = _dialogue.entries.back();
+                switch (_field)
+                {
+                case Field::Id:
+                    return assign(entry.hasId, entry.id, val);
+                case Field::ActiveParticipant:
+                    return assign(entry.hasActiveParticipant, entry.activeParticipant, val);
+                case Field::LReaction:
+                    entry.lReaction = static_cast<int>(val);
+                    return true;
+                case Field::RReaction:
+                    entry.rReaction = static_cast<int>(val);
+                    return true;
+                default:
+                    return ignore();
+                }
+            }
+            case Context::Position:
+            {
+                auto &entry = _dialogue.entries.back();
+                switch (_field)
+                {
+                case Field::X:
+                    entry.x = dbl;
+                    return true;
+                case Field::Y:
+                    entry.y = dbl;
+                    return true;
+                default:
+                    return ignore();
+                }
+            }
+            case Context::Choice:
+            {
+                auto &choice = _dialogue.choices.back();
+                switch (_field)
+                {
+                case Field::Id:
+                    return assign(choice.hasId, choice.id, val);
+                case Field::Src:
+                    return assign(choice.hasSrc, choice.src, val);
+                case Field::Dst:
+                    return assign(choice.hasDst, choice.dst, val);
+                default:
+                    return ignore();
+                }
+            }
+            case Context::Guid:
+            {
+                auto &choice = _dialogue.choices.back();
+                if (choice.guidBytes >= choice.guid.size())
+                {
+                    return fail();
+                }
+                choice.guid[choice.guidBytes++] = static_cast<uint8_t>(val);
+                return true;
+            }
+            default:
+                return scalar();
+            }
+        }
+
+        OnDialogue _onDialogue;
+        std::vector<Context> _contexts;
+        Field _field = Field::Unknown;
+        ParsedDialogue _dialogue;
+        int _fileVersion = 0;
+        unsigned _eReactionVersion = 0;
+        bool _hasDialogues = false;
+        bool _finished = false;
+        bool _failed = false;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //Writing
+
+    bool writeJson(std::ostream &stream, bool indent, const floofy::DialoguePtr *dialogues, size_t numDialogues)
+    {
+        // Keys are written in the order nlohmann sorts them in, so files are
+        // unchanged from those written through a json DOM.
+        JsonStreamWriter js(stream, indent);
+        js.beginObject();
+        {
+            //Graphs - Dialogues
+            js.key("dialogues").beginArray();
+            for (size_t i = 0; i < numDialogues; ++i)
+            {
+                const auto &dlg = dialogues[i];
+                js.beginObject();
+
+                //Edges - DialogueChoices
+                // Written in entry order, readers rebuild each entry's choice
+                // order from the order of this list.
+                js.key("choices").beginArray();
+                for (const auto &entry : dlg->entries)
+                {
+                    for (const auto &choice : entry->choices)
+                    {
+                        js.beginObject();
+                        js.key("choice").value(choice->choice.view());
+                        // A missing destination has always been written as -1 wrapped to size_t.
+                        js.key("dst").unsignedValue(choice->dst ? choice->dst->id._id : static_cast<size_t>(-1));
+                        if (choice->guidAssigned)
+                        {
+                            js.key("guid").beginArray();
+                            for (auto byte : choice->guid.value())
+                            {
+                                js.unsignedValue(byte);
+                            }
+                            js.endArray();
+                        }
+                        js.key("id").unsignedValue(choice->id._id);
+                        js.key("src").unsignedValue(choice->src->id._id);
+                        js.endObject();
+                    }
+                }
+                js.endArray();
+
+                //Nodes - DialogueEntries
+                js.key("entries").beginArray();
+                for (const auto &entry : dlg->entries)
+                {
+                    js.beginObject();
+                    js.key("activeParticipant").unsignedValue(entry->activeParticipant->id._id);
+                    js.key("entry").value(entry->entry.view());
+                    js.key("id").unsignedValue(entry->id._id);
+                    js.key("lReaction").integerValue(static_cast<int>(entry->lReaction));
+                    js.key("position").beginObject();
+                    js.key("x").floatValue(entry->viewPosition.x);
+                    js.key("y").floatValue(entry->viewPosition.y);
+                    js.endObject();
+                    js.key("rReaction").integerValue(static_cast<int>(entry->rReaction));
+                    js.endObject();
+                }
+                js.endArray();
+
+                js.key("name").value(dlg->name);
+
+                //Graph attributes - Participants
+                js.key("participants").beginArray();
+                for (const auto &participant : dlg->participants)
+                {
+                    js.beginObject();
+                    js.key("id").unsignedValue(participant->id._id);
+                    js.key("name").value(participant->name.view());
+                    js.endObject();
+                }
+                js.endArray();
+
+                js.endObject();
+            }
+            js.endArray();
+
+            //File Metadata
+            js.key("eReactionVersion").unsignedValue(floofy::E_REACTION_VERSION);
+            js.key("version").integerValue(FILE_VERSION);
+        }
+        js.endObject();
+        stream << std::endl;
+
+        return stream.good();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //Shards
+    // A sharded project is a directory with one regular dialogue file per
+    // dialogue and a manifest listing the dialogues, in order, with their file.
+    // File names are the dialogue name made path safe plus a hash of the exact
+    // name, so they stay put across saves and never depend on the platform.
+
+    constexpr const char *MANIFEST_FILE = "manifest.json";
+    constexpr int MANIFEST_VERSION = 1;
+
+    struct ManifestEntry
+    {
+        std::string name;
+        std::string file;
+    };
+
+    std::string shardFileName(const std::string &name)
+    {
+        static constexpr size_t MAX_READABLE = 48;
+        static const char hex[] = "0123456789abcdef";
+
+        std::string file;
+        for (size_t i = 0; i < name.size() && file.size() < MAX_READABLE; ++i)
+        {
+            const char c = name[i];
+            const bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_';
+            file += safe ? c : '_';
+        }
+
+        // 64-bit FNV-1a, std::hash differs between standard libraries.
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (auto c : name)
+        {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ull;
+        }
+        file += '-';
+        for (int shift = 60; shift >= 0; shift -= 4)
+        {
+            file += hex[(hash >> shift) & 0xF];
+        }
+        return file + ".json";
+    }
+
+    bool readManifest(const std::filesystem::path &root, std::vector<ManifestEntry> &entries)
+    {
+        std::ifstream file(root / MANIFEST_FILE);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        const auto manifest = nlohmann::json::parse(file, nullptr, false);
+        if (manifest.is_discarded() || !manifest.is_object())
+        {
+            return false;
+        }
+
+        auto version = manifest.find("version");
+        auto dialogues = manifest.find("dialogues");
+        if (version == manifest.end() || !version->is_number_integer() || version->get<int>() > MANIFEST_VERSION ||
+            dialogues == manifest.end() || !dialogues->is_array())
+        {
+            return false;
+        }
+
+        entries.clear();
+        entries.reserve(dialogues->size());
+        for (const auto &dlg : *dialogues)
+        {
+            auto name = dlg.find("name");
+            auto path = dlg.find("file");
+            if (!dlg.is_object() || name == dlg.end() || !name->is_string() || path == dlg.end() || !path->is_string())
+            {
+                return false;
+            }
+
+            // Shards always sit next to the manifest.
+            auto fileName = path->get<std::string>();
+            if (std::filesystem::path(fileName).filename().string() != fileName)
+            {
+                return false;
+            }
+            entries.push_back({name->get<std::string>(), std::move(fileName)});
+        }
+        return true;
+    }
+
+    // Written next to the old manifest and moved over it, so an interrupted
+    // save never leaves a half written manifest behind.
+    bool writeManifest(const std::filesystem::path &root, const std::vector<ManifestEntry> &entries)
+    {
+        const auto path = root / MANIFEST_FILE;
+        auto tmpPath = path;
+        tmpPath += ".tmp";
+        {
+            std::ofstream file(tmpPath);
+            if (!file.is_open())
+            {
+                return false;
+            }
+
+            JsonStreamWriter js(file, true);
+            js.beginObject();
+            js.key("dialogues").beginArray();
+            for (const auto &entry : entries)
+            {
+                js.beginObject();
+                js.key("file").value(entry.file);
+                js.key("name").value(entry.name);
+                js.endObject();
+            }
+            js.endArray();
+            js.key("version").integerValue(MANIFEST_VERSION);
+            js.endObject();
+            file << std::endl;
+            if (!file.good())
+            {
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        return !ec;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //Node lists
+    // Nodes know their position in their dialogue's lists, and entries know
+    // the choices leading to them, so removals never search or shift a list.
+
+    template <typename NodePtr>
+    void swapAndPop(std::vector<NodePtr> &nodes, NodePtr node)
+    {
+        assert(node->_index < nodes.size() && nodes[node->_index] == node);
+        auto &slot = nodes[node->_index];
+        slot = nodes.back();
+        slot->_index = node->_index;
+        nodes.pop_back();
+    }
+
+    void linkIncoming(floofy::DialogueChoicePtr choice)
+    {
+        if (choice->dst)
+        {
+            choice->dst->_incoming.push_back(choice);
+        }
+    }
+
+    void unlinkIncoming(floofy::DialogueChoicePtr choice)
+    {
+        if (choice->dst)
+        {
+            auto &incoming = choice->dst->_incoming;
+            auto find = std::find(incoming.begin(), incoming.end(), choice);
+            if (find != incoming.end())
+            {
+                *find = incoming.back();
+                incoming.pop_back();
+            }
+        }
+    }
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //History
+    // Records a change with the value the node had before, when the node's
+    // dialogue belongs to a manager with a history attached.
+
+    using Change = floofy::DialogueChange;
+
+    template <typename Value>
+    void record(Change::Kind kind, floofy::DialoguePtr dialogue, void *node, const Value &value)
+    {
+        auto history = dialogue ? dialogue->history() : nullptr;
+        if (history)
+        {
+            history->record({kind, dialogue, node, value});
+        }
+    }
+
+    // Groups the changes of an edit made of several into one transaction.
+    class HistoryTransaction
+    {
+    public:
+        explicit HistoryTransaction(floofy::DialoguePtr dialogue) : _history(dialogue->history())
+        {
+            if (_history)
+            {
+                _history->begin();
+            }
+        }
+        ~HistoryTransaction()
+        {
+            if (_history)
+            {
+                _history->commit();
+            }
+        }
+
+    private:
+        floofy::DialogueHistory *_history;
+    };
+    /////////////////////////////////////////////////////////////////////////////
 } // namespace
 
 namespace floofy
@@ -41,16 +934,29 @@ namespace floofy
     /////////////////////////////////////////////////////////////////////////////
     //DialogueManager
 
-    DialoguePtr DialogueManager::addDialogue(std::string name)
+    DialogueManager::~DialogueManager()
     {
-        auto findDialogue = std::find_if(dialogues.begin(), dialogues.end(), FindDlgByNameFunctor{name});
+        if (_history)
+        {
+            _history->clear();
+            _history->_manager = nullptr;
+        }
+        for (auto dlg : dialogues)
+        {
+            delete dlg;
+        }
+    }
 
-        if (findDialogue == dialogues.end())
+    DialoguePtr DialogueManager::addDialogue(std::string name)
+    {
+        if (_dialoguesByName.count(name) != 0)
         {
-            return dialogues.emplace_back(new Dialogue(name));
+            return nullptr;
         }
 
-        return nullptr;
+        DialoguePtr dlg = new Dialogue(name);
+        addDialogue(dlg);
+        return dlg;
     }
 
     bool DialogueManager::addDialogue(DialoguePtr dlg)
@@ -60,23 +966,25 @@ namespace floofy
             return false;
         }
 
-        auto findDialogue = std::find_if(dialogues.begin(), dialogues.end(), FindDlgByNameFunctor{dlg->name});
-        if (findDialogue != dialogues.end())
+        if (!_dialoguesByName.emplace(dlg->name, dlg).second)
         {
             return false;
         }
 
-        return dialogues.emplace_back(dlg);
+        dlg->_manager = this;
+        dialogues.emplace_back(dlg);
+        indexChoiceGuids(dlg);
+        return true;
     }
 
     DialoguePtr DialogueManager::dialogue(const std::string &name) const
     {
-        auto findDialogue = std::find_if(dialogues.begin(), dialogues.end(), FindDlgByNameFunctor{name});
-        if (findDialogue == dialogues.end())
+        auto findDialogue = _dialoguesByName.find(name);
+        if (findDialogue == _dialoguesByName.end())
         {
             return nullptr;
         }
-        return *findDialogue;
+        return findDialogue->second;
     }
 
     DialoguePtr DialogueManager::dialogue(size_t index) const
@@ -88,99 +996,290 @@ namespace floofy
 
     DialoguePtr DialogueManager::removeDialogue(const std::string &name)
     {
-        auto findDialogue = std::find_if(dialogues.begin(), dialogues.end(), FindDlgByNameFunctor{name});
-        if (findDialogue == dialogues.end())
+        auto findDialogue = _dialoguesByName.find(name);
+        if (findDialogue == _dialoguesByName.end())
         {
             return nullptr;
         }
 
-        auto dlgPtr = *findDialogue;
-        dialogues.erase(findDialogue);
+        auto dlgPtr = findDialogue->second;
+        if (_history)
+        {
+            _history->clear();
+        }
+        _dialoguesByName.erase(findDialogue);
+        dialogues.erase(std::find(dialogues.begin(), dialogues.end(), dlgPtr));
+        unindexChoiceGuids(dlgPtr);
+        dlgPtr->_manager = nullptr;
+        // The dialogue may be freed and its address reused, so it is no
+        // longer recognized as saved.
+        for (auto &saved : _shardRevisions)
+        {
+            if (saved.first == dlgPtr)
+            {
+                saved.first = nullptr;
+            }
+        }
         return dlgPtr;
     }
 
+    bool DialogueManager::renameDialogue(DialoguePtr dlg, std::string name)
+    {
+        if (!dlg || dlg->_manager != this)
+        {
+            return false;
+        }
+
+        if (dlg->name == name)
+        {
+            return true;
+        }
+
+        if (!_dialoguesByName.emplace(name, dlg).second)
+        {
+            return false;
+        }
+
+        _dialoguesByName.erase(dlg->name);
+        dlg->name = std::move(name);
+        dlg->markModified();
+        return true;
+    }
+
     size_t DialogueManager::numDialogues() const
     {
         return dialogues.size();
     }
 
-    bool DialogueManager::writeToFile(const std::string &filePath) const
+    DialogueChoicePtr DialogueManager::choice(const Guid &guid) const
+    {
+        auto find = _choicesByGuid.find(guid);
+        return find == _choicesByGuid.end() ? nullptr : find->second;
+    }
+
+    void DialogueManager::indexChoiceGuids(DialoguePtr dlg)
+    {
+        for (const auto &choice : dlg->choices)
+        {
+            indexChoiceGuid(choice);
+        }
+    }
+
+    void DialogueManager::unindexChoiceGuids(DialoguePtr dlg)
+    {
+        for (const auto &choice : dlg->choices)
+        {
+            unindexChoiceGuid(choice);
+        }
+    }
+
+    void DialogueManager::indexChoiceGuid(DialogueChoicePtr choice)
+    {
+        if (choice->guidAssigned)
+        {
+            _choicesByGuid.emplace(choice->guid, choice);
+        }
+    }
+
+    void DialogueManager::unindexChoiceGuid(DialogueChoicePtr choice)
+    {
+        auto find = _choicesByGuid.find(choice->guid);
+        if (find != _choicesByGuid.end() && find->second == choice)
+        {
+            _choicesByGuid.erase(find);
+        }
+    }
+
+    bool DialogueManager::writeToFile(const std::string &filePath, bool indent) const
     {
         std::ofstream file(filePath);
         if (file.is_open())
         {
-            nlohmann::json js;
+            return writeToStream(file, indent);
+        }
+
+        return false;
+    }
+
+    bool DialogueManager::writeToStream(std::ostream &stream, bool indent) const
+    {
+        return writeJson(stream, indent, dialogues.data(), dialogues.size());
+    }
+
+    bool DialogueManager::writeSharded(const std::string &directory, bool indent) const
+    {
+        return writeShards(directory, indent, false);
+    }
+
+    bool DialogueManager::writeShardedChanges(const std::string &directory, bool indent) const
+    {
+        return writeShards(directory, indent, true);
+    }
+
+    bool DialogueManager::modified() const
+    {
+        if (_shardRevisions.size() != dialogues.size())
+        {
+            return true;
+        }
+
+        for (size_t i = 0; i < dialogues.size(); ++i)
+        {
+            if (_shardRevisions[i].first != dialogues[i] || _shardRevisions[i].second != dialogues[i]->revision())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool DialogueManager::writeShards(const std::string &directory, bool indent, bool onlyModified) const
+    {
+        namespace fs = std::filesystem;
+        const fs::path root(directory);
+        const auto rootName = root.lexically_normal().string();
+        std::error_code ec;
+        fs::create_directories(root, ec);
+        if (ec)
+        {
+            return false;
+        }
+
+        std::vector<ManifestEntry> manifest;
+        manifest.reserve(dialogues.size());
+        std::unordered_map<std::string, size_t> files;
+        for (const auto &dlg : dialogues)
+        {
+            manifest.push_back({dlg->name, shardFileName(dlg->name)});
+            if (!files.emplace(manifest.back().file, manifest.size() - 1).second)
             {
-                //File Metadata
-                js["version"] = FILE_VERSION;
-                js["eReactionVersion"] = E_REACTION_VERSION;
+                assert(false);
+                return false;
+            }
+        }
 
-                //Graphs - Dialogues
-                std::vector<nlohmann::json> dialoguesJs;
-                for (const auto &dlg : dialogues)
-                {
-                    nlohmann::json dialogueJs;
-                    dialogueJs["name"] = dlg->name;
+        // Only dialogues whose revision moved since the last save to this
+        // directory are rewritten. The manifest is small and rewritten with
+        // any shard, a save with nothing to write touches no file at all.
+        // Shards edited behind the manager's back are not noticed.
+        std::vector<size_t> pending;
+        pending.reserve(dialogues.size());
+        std::unordered_map<const Dialogue *, uint64_t> saved;
+        const bool incremental = onlyModified && rootName == _shardDirectory;
+        if (incremental)
+        {
+            saved.insert(_shardRevisions.begin(), _shardRevisions.end());
+        }
+        for (size_t i = 0; i < dialogues.size(); ++i)
+        {
+            auto find = saved.find(dialogues[i]);
+            if (find == saved.end() || find->second != dialogues[i]->revision())
+            {
+                pending.push_back(i);
+            }
+        }
 
-                    //Graph attributes - Participants
-                    {
-                        std::vector<nlohmann::json> participantsJs;
-                        participantsJs.reserve(dlg->participants.size());
-                        for (const auto &participant : dlg->participants)
-                        {
-                            participantsJs.push_back({{"id", participant->id._id}, {"name", participant->name}});
-                        }
-                        dialogueJs["participants"] = participantsJs;
-                    }
+        bool listChanged = !incremental || saved.size() != dialogues.size() || !pending.empty();
+        for (size_t i = 0; !listChanged && i < dialogues.size(); ++i)
+        {
+            listChanged = _shardRevisions[i].first != dialogues[i];
+        }
 
-                    //Nodes - DialogueEntries
-                    {
-                        std::vector<nlohmann::json> entriesJs;
-                        entriesJs.reserve(dlg->entries.size());
-                        for (size_t i = 0; i < dlg->entries.size(); ++i)
-                        {
-                            entriesJs.push_back({{"id", dlg->entries[i]->id._id},
-                                                 {"entry", dlg->entries[i]->entry},
-                                                 {"activeParticipant", dlg->entries[i]->activeParticipant->id._id},
-                                                 {"position", nlohmann::json{
-                                                                  {"x", dlg->entries[i]->viewPosition.x},
-                                                                  {"y", dlg->entries[i]->viewPosition.y}}},
-                                                 {"lReaction", static_cast<int>(dlg->entries[i]->lReaction)},
-                                                 {"rReaction", static_cast<int>(dlg->entries[i]->rReaction)}});
-                        }
-                        dialogueJs["entries"] = entriesJs;
-                    }
+        // Forget what was saved until this save completed, a failed save
+        // leaves the directory in an unknown state.
+        _shardDirectory.clear();
+        _shardRevisions.clear();
 
-                    //Edges - DialogueChoices
-                    {
-                        std::vector<nlohmann::json> choicesJs;
-                        choicesJs.reserve(dlg->choices.size());
-                        for (size_t i = 0; i < dlg->choices.size(); ++i)
-                        {
-                            nlohmann::json obj{{"id", dlg->choices[i]->id._id},
-                                                 {"choice", dlg->choices[i]->choice},
-                                                 {"src", dlg->choices[i]->src->id._id},
-                                                 {"dst", dlg->choices[i]->dst ? dlg->choices[i]->dst->id._id : -1}};
-                            if(dlg->choices[i]->guidAssigned)
-                            {
-                                obj.push_back({"guid", dlg->choices[i]->guid.value()});
-                            }
-                            choicesJs.push_back(obj);
-                        }
-                        dialogueJs["choices"] = choicesJs;
-                    }
+        std::vector<ManifestEntry> previous;
+        if (listChanged)
+        {
+            readManifest(root, previous);
+        }
+
+        // Shards are written next to the live ones and renamed over them, so
+        // a save that fails halfway leaves every shard whole, old or new.
+        std::atomic<bool> written{true};
+        parallelFor(pending.size(), [&](size_t i) {
+            const auto index = pending[i];
+            const auto path = root / manifest[index].file;
+            auto tmpPath = path;
+            tmpPath += ".tmp";
+            bool shardWritten;
+            {
+                std::ofstream file(tmpPath);
+                shardWritten = file.is_open() && writeJson(file, indent, &dialogues[index], 1) && file.flush().good();
+            }
+            std::error_code renameError;
+            if (shardWritten)
+            {
+                fs::rename(tmpPath, path, renameError);
+            }
+            if (!shardWritten || renameError)
+            {
+                fs::remove(tmpPath, renameError);
+                written = false;
+            }
+        });
+        if (!written || (listChanged && !writeManifest(root, manifest)))
+        {
+            return false;
+        }
+
+        // Shards of dialogues that were removed or renamed since the last save.
+        for (const auto &entry : previous)
+        {
+            if (files.count(entry.file) == 0)
+            {
+                fs::remove(root / entry.file, ec);
+            }
+        }
+
+        _shardDirectory = rootName;
+        for (const auto &dlg : dialogues)
+        {
+            _shardRevisions.emplace_back(dlg, dlg->revision());
+        }
+        return true;
+    }
 
-                    dialoguesJs.emplace_back(std::move(dialogueJs));
-                }
-                js["dialogues"] = dialoguesJs;
+    DialogueManagerPtr DialogueManager::readSharded(const std::string &directory)
+    {
+        const std::filesystem::path root(directory);
+        std::vector<ManifestEntry> manifest;
+        if (!readManifest(root, manifest))
+        {
+            return nullptr;
+        }
 
-                file << std::setw(2) << js << std::endl;
+        std::vector<std::unique_ptr<DialogueManager>> shards(manifest.size());
+        parallelFor(manifest.size(), [&](size_t i) {
+            shards[i].reset(readFromFile((root / manifest[i].file).string()));
+        });
 
-                return true;
+        // Stitched together in manifest order, every shard must hold exactly
+        // the dialogue the manifest lists for it.
+        auto mgr = std::make_unique<DialogueManager>();
+        for (size_t i = 0; i < shards.size(); ++i)
+        {
+            if (!shards[i] || shards[i]->numDialogues() != 1 || shards[i]->dialogue(0)->name != manifest[i].name)
+            {
+                return nullptr;
+            }
+
+            auto dlg = shards[i]->removeDialogue(manifest[i].name);
+            if (!mgr->addDialogue(dlg))
+            {
+                delete dlg;
+                return nullptr;
             }
         }
 
-        return false;
+        mgr->_shardDirectory = root.lexically_normal().string();
+        for (const auto &dlg : mgr->dialogues)
+        {
+            mgr->_shardRevisions.emplace_back(dlg, dlg->revision());
+        }
+        return mgr.release();
     }
 
     DialogueManagerPtr DialogueManager::readFromFile(const std::string &filePath)
@@ -196,168 +1295,138 @@ namespace floofy
 
     DialogueManagerPtr DialogueManager::readContents(const std::string &contents)
     {
-        std::istringstream contentsStream(contents);
-        return readStream(contentsStream);
+        return readJson(contents);
     }
 
     DialogueManagerPtr DialogueManager::readStream(std::istream &stream)
     {
         if (stream.good())
         {
-            auto mgr = std::make_unique<DialogueManager>();
+            return readJson(stream);
+        }
+
+        return nullptr;
+    }
 
-            nlohmann::json json;
-            json << stream;
+    template <typename Input>
+    DialogueManagerPtr DialogueManager::readJson(Input &&input)
+    {
+        auto mgr = std::make_unique<DialogueManager>();
 
-            if (!json.is_object())
+        const auto onDialogue = [&mgr](ParsedDialogue &dlg) {
+            if (!dlg.hasName || !dlg.hasParticipants || !dlg.hasEntries || !dlg.hasChoices)
             {
-                assert(false);
-                return nullptr;
+                return false;
             }
 
-            int fileVersion = 0;
-            auto findVersion = json.find("version");
-            if (findVersion != json.end() && findVersion->is_number())
+            auto dlgPtr = mgr->addDialogue(std::move(dlg.name));
+            if (!dlgPtr)
             {
-                fileVersion = *findVersion;
+                return false;
             }
 
-            int eReactionVersion = 0;
-            if (fileVersion >= 2)
+            dlgPtr->reserve(dlg.participants.size(), dlg.entries.size(), dlg.choices.size());
+
+            //Participants
+            for (auto &part : dlg.participants)
             {
-                auto findEReactionVersion = json.find("eReactionVersion");
-                if (findEReactionVersion != json.end() && findEReactionVersion->is_number())
+                if (!part.hasName || !part.hasId)
                 {
-                    eReactionVersion = *findEReactionVersion;
+                    return false;
                 }
-            }
 
-            //Dialogues
-            auto findDlgs = json.find("dialogues");
-            if (findDlgs == json.end() || !findDlgs->is_array())
-            {
-                assert(false);
-                return nullptr;
+                dlgPtr->addParticipant(part.name, ID{part.id});
             }
 
-            for (const auto &dlg : *findDlgs)
+            //Entries
+            for (auto &entry : dlg.entries)
             {
-                if (!dlg.is_object() || !dlg.contains("name"))
+                if (!entry.hasEntry || !entry.hasId || !entry.hasActiveParticipant)
                 {
-                    assert(false);
-                    return nullptr;
+                    return false;
                 }
 
-                auto dlgPtr = mgr->addDialogue(dlg["name"]);
-
-                //Participants
-                auto findParts = dlg.find("participants");
-                if (findParts == dlg.end() || !findParts->is_array())
+                auto part = dlgPtr->participant(ID{entry.activeParticipant});
+                if (!part)
                 {
-                    assert(false);
-                    return nullptr;
+                    return false;
                 }
 
-                for (const auto &part : *findParts)
-                {
-                    if (!part.is_object() || !part.contains("name") || !part.contains("id"))
-                    {
-                        assert(false);
-                        return nullptr;
-                    }
+                auto dlgEntry = dlgPtr->addDialogueEntry(part, entry.entry, ID{entry.id});
+                dlgEntry->viewPosition = {entry.x, entry.y};
+                dlgEntry->lReaction = static_cast<eReaction>(entry.lReaction);
+                dlgEntry->rReaction = static_cast<eReaction>(entry.rReaction);
+            }
 
-                    dlgPtr->addParticipant(part["name"], ID{part["id"]});
+            //DialogueChoices
+            for (auto &choice : dlg.choices)
+            {
+                if (!choice.hasChoice || !choice.hasId || !choice.hasSrc || !choice.hasDst)
+                {
+                    return false;
                 }
 
-                //Entries
-                auto findEntries = dlg.find("entries");
-                if (findEntries == dlg.end() || !findEntries->is_array())
+                auto src = dlgPtr->dialogueEntry(ID{choice.src});
+                if (!src)
                 {
-                    assert(false);
-                    return nullptr;
+                    return false;
                 }
 
-                for (const auto &entry : *findEntries)
+                auto dst = dlgPtr->dialogueEntry(ID{choice.dst});
+                auto choicePtr = dlgPtr->addDialogueChoice(src, choice.choice, dst, ID{choice.id});
+                if (choice.guidBytes == choice.guid.size())
                 {
-                    if (!entry.is_object() || !entry.contains("entry") || !entry.contains("id") || !entry.contains("activeParticipant"))
-                    {
-                        assert(false);
-                        return nullptr;
-                    }
+                    choicePtr->assignGuid(choice.guid);
+                }
+            }
 
-                    auto part = dlgPtr->participant(ID{entry["activeParticipant"]});
-                    if (!part)
-                    {
-                        assert(false);
-                        return nullptr;
-                    }
+            return true;
+        };
 
-                    auto dlgEntry = dlgPtr->addDialogueEntry(part, entry["entry"], ID{entry["id"]});
-                    if (fileVersion >= 1)
-                    {
-                        auto pos = entry["position"];
-                        dlgEntry->viewPosition = {pos["x"], pos["y"]};
-                    }
+        DialogueSaxReader<decltype(onDialogue)> reader(onDialogue);
+        const bool parsed = nlohmann::json::sax_parse(std::forward<Input>(input), &reader);
+        if (reader.failed() || (parsed && !reader.finished()))
+        {
+            assert(false);
+            return nullptr;
+        }
+        else if (!parsed)
+        {
+            return nullptr;
+        }
 
-                    if (fileVersion >= 2)
-                    {
-                        dlgEntry->lReaction = ReactionFromInt(entry["lReaction"], eReactionVersion);
-                        dlgEntry->rReaction = ReactionFromInt(entry["rReaction"], eReactionVersion);
-                    }
+        // The version keys can follow the dialogues, so the fields they gate are
+        // fixed up once the whole file has been read.
+        for (const auto &dlg : mgr->dialogues)
+        {
+            for (const auto &entry : dlg->entries)
+            {
+                if (reader.fileVersion() < 1)
+                {
+                    entry->viewPosition = {};
                 }
 
-                //DialogueChoices
-                auto findDialogueChoice = dlg.find("choices");
-                if (findDialogueChoice == dlg.end() || !findDialogueChoice->is_array())
+                if (reader.fileVersion() < 2)
                 {
-                    assert(false);
-                    return nullptr;
+                    entry->lReaction = entry->rReaction = eReaction::None;
                 }
-
-                for (const auto &choice : *findDialogueChoice)
+                else if (reader.eReactionVersion() != E_REACTION_VERSION)
                 {
-                    if (!choice.is_object() || !choice.contains("choice") || !choice.contains("id") || !choice.contains("src") || !choice.contains("dst"))
-                    {
-                        assert(false);
-                        return nullptr;
-                    }
-
-                    auto src = dlgPtr->dialogueEntry(ID{choice["src"]});
-                    auto dst = dlgPtr->dialogueEntry(ID{choice["dst"]});
-                    if (!src)
-                    {
-                        assert(false);
-                        return nullptr;
-                    }
-
-                    DialogueChoicePtr choicePtr = nullptr;
-                    if (dst)
-                    {
-                        choicePtr = dlgPtr->addDialogueChoice(src, choice["choice"], dst, ID{choice["id"]});
-                    }
-                    else
-                    {
-                        choicePtr = dlgPtr->addDialogueChoice(src, choice["choice"], ID{choice["id"]});
-                    }
-
-                    if(fileVersion >= 3 && choice.contains("guid"))
-                    {
-                        Guid::GuidT data;
-                        auto array = choice["guid"];
-                        for(int i=0; i<data.size(); ++i)
-                        {
-                            data[i] = array[i];
-                        }
-                        choicePtr->guid = data;
-                        choicePtr->guidAssigned = true;
-                    }
+                    entry->lReaction = ReactionFromInt(static_cast<int>(entry->lReaction), reader.eReactionVersion());
+                    entry->rReaction = ReactionFromInt(static_cast<int>(entry->rReaction), reader.eReactionVersion());
                 }
             }
 
-            return mgr.release();
+            if (reader.fileVersion() < 3)
+            {
+                for (const auto &choice : dlg->choices)
+                {
+                    choice->clearGuid();
+                }
+            }
         }
 
-        return nullptr;
+        return mgr.release();
     }
 
     /////////////////////////////////////////////////////////////////////////////
@@ -365,9 +1434,37 @@ namespace floofy
     /////////////////////////////////////////////////////////////////////////////
     //Dialogue
 
-    ParticipantPtr Dialogue::addParticipant(std::string name)
+    void Dialogue::reserve(size_t numParticipants, size_t numEntries, size_t numChoices)
+    {
+        participants.reserve(participants.size() + numParticipants);
+        _participantPool.reserve(numParticipants);
+        _participantsByName.reserve(_participantsByName.size() + numParticipants);
+        _participantsById.reserve(_participantsById.size() + numParticipants);
+
+        entries.reserve(entries.size() + numEntries);
+        _entryPool.reserve(numEntries);
+        _entriesById.reserve(_entriesById.size() + numEntries);
+
+        choices.reserve(choices.size() + numChoices);
+        _choicePool.reserve(numChoices);
+        _choicesById.reserve(_choicesById.size() + numChoices);
+    }
+
+    bool Dialogue::setName(std::string name)
+    {
+        if (_manager)
+        {
+            return _manager->renameDialogue(this, std::move(name));
+        }
+
+        this->name = std::move(name);
+        markModified();
+        return true;
+    }
+
+    ParticipantPtr Dialogue::addParticipant(std::string_view name)
     {
-        return addParticipant(name, _nextParticipantId++);
+        return addParticipant(InternedString(name), _nextParticipantId++);
     }
 
     size_t Dialogue::numParticipants() const
@@ -380,54 +1477,66 @@ namespace floofy
         return participants.at(index);
     }
 
-    ParticipantPtr Dialogue::participant(const std::string &name) const
+    ParticipantPtr Dialogue::participant(std::string_view name) const
     {
-        const auto pred = [&name](const ParticipantPtr &other) {
-            return name == other->name;
-        };
-
-        auto findParticipant = std::find_if(participants.cbegin(), participants.cend(), pred);
+        // A name that was never interned cannot belong to a participant.
+        auto interned = InternedString::find(name);
+        return interned ? participant(*interned) : nullptr;
+    }
 
-        if (findParticipant == participants.end())
-        {
-            return {};
-        }
-        else
-        {
-            return *findParticipant;
-        }
+    ParticipantPtr Dialogue::participant(const InternedString &name) const
+    {
+        auto findParticipant = _participantsByName.find(name);
+        return findParticipant == _participantsByName.end() ? nullptr : findParticipant->second;
     }
 
     ParticipantPtr Dialogue::participant(ID id) const
     {
-        const auto pred = [id](const ParticipantPtr &other) {
-            return id == other->id;
-        };
-
-        auto findParticipant = std::find_if(participants.cbegin(), participants.cend(), pred);
+        auto findParticipant = _participantsById.find(id);
+        return findParticipant == _participantsById.end() ? nullptr : findParticipant->second;
+    }
 
-        if (findParticipant == participants.end())
+    void Dialogue::removeParticipant(std::string_view name)
+    {
+        auto interned = InternedString::find(name);
+        if (!interned || _participantsByName.count(*interned) == 0)
         {
-            return {};
+            return;
         }
-        else
+
+        // Last first, so putting them back in reverse restores the order.
+        HistoryTransaction transaction(this);
+        for (size_t i = participants.size(); i-- > 0;)
         {
-            return *findParticipant;
+            auto participant = participants[i];
+            if (participant->name == *interned)
+            {
+                detachParticipant(i);
+                record(Change::Kind::RemoveParticipant, this, participant, i);
+            }
         }
+        markModified();
     }
 
-    void Dialogue::removeParticipant(const std::string &name)
+    void Dialogue::renameParticipant(ParticipantPtr participant, std::string_view name)
     {
-        const auto pred = [&name](const ParticipantPtr &other) {
-            return name == other->name;
-        };
+        if (!participant || participant->_dialogue != this)
+        {
+            return;
+        }
+
+        record(Change::Kind::ParticipantName, this, participant, participant->name);
+        InternedString oldName = std::move(participant->name);
+        participant->name = InternedString(name);
 
-        participants.erase(std::remove_if(participants.begin(), participants.end(), pred));
+        resolveParticipantName(oldName);
+        resolveParticipantName(participant->name);
+        markModified();
     }
 
-    DialogueEntryPtr Dialogue::addDialogueEntry(ParticipantPtr activeParticipant, std::string entry)
+    DialogueEntryPtr Dialogue::addDialogueEntry(ParticipantPtr activeParticipant, std::string_view entry)
     {
-        return addDialogueEntry(activeParticipant, entry, _nextEntryId);
+        return addDialogueEntry(activeParticipant, InternedString(entry), _nextEntryId);
     }
 
     size_t Dialogue::numDialogueEntries() const
@@ -442,38 +1551,32 @@ namespace floofy
 
     DialogueEntryPtr Dialogue::dialogueEntry(ID id) const
     {
-        auto find = std::find_if(entries.begin(), entries.end(), [id](const DialogueEntryPtr &entry) {
-            return entry->id == id;
-        });
-
-        return find == entries.end() ? nullptr : *find;
+        auto find = _entriesById.find(id);
+        return find == _entriesById.end() ? nullptr : find->second;
     }
 
     void Dialogue::removeDialogueEntry(size_t index)
     {
-        entries.erase(entries.begin() + index);
+        removeEntry(entries.at(index));
     }
 
     void Dialogue::removeDialogueEntry(ID id)
     {
-        auto find = std::find_if(entries.begin(), entries.end(), [id](const DialogueEntryPtr &entry) {
-            return entry->id == id;
-        });
-
-        if(find != entries.end())
-        {            
-            entries.erase(find);
+        auto find = _entriesById.find(id);
+        if (find != _entriesById.end())
+        {
+            removeEntry(find->second);
         }
     }
 
-    DialogueChoicePtr Dialogue::addDialogueChoice(DialogueEntryPtr src, std::string choiceStr, DialogueEntryPtr dst)
+    DialogueChoicePtr Dialogue::addDialogueChoice(DialogueEntryPtr src, std::string_view choiceStr, DialogueEntryPtr dst)
     {
-        return addDialogueChoice(src, choiceStr, dst, _nextDialogueChoiceId);
+        return addDialogueChoice(src, InternedString(choiceStr), dst, _nextDialogueChoiceId);
     }
 
-    DialogueChoicePtr Dialogue::addDialogueChoice(DialogueEntryPtr src, std::string choiceStr)
+    DialogueChoicePtr Dialogue::addDialogueChoice(DialogueEntryPtr src, std::string_view choiceStr)
     {
-        return addDialogueChoice(src, choiceStr, _nextDialogueChoiceId);
+        return addDialogueChoice(src, InternedString(choiceStr), _nextDialogueChoiceId);
     }
 
     size_t Dialogue::numDialogueChoices() const
@@ -495,78 +1598,431 @@ namespace floofy
 
     DialogueChoicePtr Dialogue::choice(ID id) const
     {
-        const auto pred = [id](const DialogueChoicePtr &other) {
-            return id == other->id;
-        };
+        auto findDialogueChoice = _choicesById.find(id);
+        return findDialogueChoice == _choicesById.end() ? nullptr : findDialogueChoice->second;
+    }
 
-        auto findDialogueChoice = std::find_if(choices.begin(), choices.end(), pred);
-        if (findDialogueChoice == choices.end())
+    void Dialogue::removeDialogueChoice(ID id)
+    {
+        auto find = _choicesById.find(id);
+        if (find != _choicesById.end())
         {
-            return {};
+            auto choice = find->second;
+            auto position = detachChoice(choice);
+            record(Change::Kind::RemoveChoice, this, choice, position);
+            markModified();
         }
-        else
+    }
+
+    size_t Dialogue::moveDialogueEntries(const EntryMove *moves, size_t count)
+    {
+        HistoryTransaction transaction(this);
+        size_t moved = 0;
+        // Selections mostly list entries in the dialogue's order, so the
+        // entry after the previous one is tried before the lookup.
+        size_t next = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto entry = next < entries.size() && entries[next]->id == moves[i].entry ? entries[next] : dialogueEntry(moves[i].entry);
+            if (!entry)
+            {
+                continue;
+            }
+
+            next = entry->_index + 1;
+            record(Change::Kind::EntryPosition, this, entry, entry->viewPosition);
+            entry->viewPosition = {moves[i].x, moves[i].y};
+            ++moved;
+        }
+        if (moved != 0)
         {
-            return *findDialogueChoice;
+            markModified();
         }
+        return moved;
     }
 
-    void Dialogue::removeDialogueChoice(ID id)
+    size_t Dialogue::relinkDialogueChoices(const ChoiceRelink *relinks, size_t count)
     {
-        const auto pred = [&id](const DialogueChoicePtr &other) {
-            return id == other->id;
-        };
+        HistoryTransaction transaction(this);
+        size_t relinked = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto find = _choicesById.find(relinks[i].choice);
+            DialogueEntryPtr dst = nullptr;
+            if (relinks[i].dst != NO_ID)
+            {
+                auto findDst = _entriesById.find(relinks[i].dst);
+                dst = findDst == _entriesById.end() ? nullptr : findDst->second;
+            }
+            if (find == _choicesById.end() || (relinks[i].dst != NO_ID && !dst))
+            {
+                continue;
+            }
+
+            auto choice = find->second;
+            record(Change::Kind::ChoiceDst, this, choice, choice->dst);
+            unlinkIncoming(choice);
+            choice->dst = dst;
+            linkIncoming(choice);
+            ++relinked;
+        }
+        if (relinked != 0)
+        {
+            markModified();
+        }
+        return relinked;
+    }
+
+    void Dialogue::addDialogueEntries(const EntryCreate *records, size_t count, DialogueEntryPtr *created)
+    {
+        HistoryTransaction transaction(this);
+        reserve(0, count, 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            // An entry needs one of the dialogue's participants to be saved.
+            const auto &create = records[i];
+            DialogueEntryPtr entry = nullptr;
+            if (create.activeParticipant && create.activeParticipant->_dialogue == this)
+            {
+                entry = addDialogueEntry(create.activeParticipant, InternedString(create.entry), _nextEntryId);
+                entry->viewPosition = {create.x, create.y};
+            }
+            if (created)
+            {
+                created[i] = entry;
+            }
+        }
+    }
 
-        choices.erase(std::remove_if(choices.begin(), choices.end(), pred));
+    void Dialogue::addDialogueChoices(const ChoiceCreate *records, size_t count, DialogueChoicePtr *created)
+    {
+        HistoryTransaction transaction(this);
+        reserve(0, 0, count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            // Entries of other dialogues, or removed ones, would be linked to
+            // nodes this dialogue does not own.
+            const auto &create = records[i];
+            const auto valid = create.src && create.src->_dialogue == this && (!create.dst || create.dst->_dialogue == this);
+            auto choice = valid ? addDialogueChoice(create.src, InternedString(create.choice), create.dst, _nextDialogueChoiceId) : nullptr;
+            if (created)
+            {
+                created[i] = choice;
+            }
+        }
     }
 
-    ParticipantPtr Dialogue::addParticipant(std::string name, ID id)
+    ParticipantPtr Dialogue::addParticipant(InternedString name, ID id)
     {
         if (id >= _nextParticipantId)
             _nextParticipantId = id + 1;
-        return participants.emplace_back(new Participant(id, name));
+        auto participant = participants.emplace_back(_participantPool.create(id, std::move(name)));
+        participant->_dialogue = this;
+        _participantsByName.emplace(participant->name, participant);
+        _participantsById.emplace(id, participant);
+        record(Change::Kind::AddParticipant, this, participant, participants.size() - 1);
+        markModified();
+        return participant;
     }
 
-    DialogueEntryPtr Dialogue::addDialogueEntry(ParticipantPtr activeParticipant, std::string entry, ID id)
+    DialogueEntryPtr Dialogue::addDialogueEntry(ParticipantPtr activeParticipant, InternedString entry, ID id)
     {
         if (id >= _nextEntryId)
             _nextEntryId = id + 1;
-        return entries.emplace_back(new DialogueEntry(id, entry, activeParticipant));
+        auto dialogueEntry = entries.emplace_back(_entryPool.create(id, std::move(entry), activeParticipant));
+        dialogueEntry->_dialogue = this;
+        dialogueEntry->_index = entries.size() - 1;
+        _entriesById.emplace(id, dialogueEntry);
+        record(Change::Kind::AddEntry, this, dialogueEntry, size_t(0));
+        markModified();
+        return dialogueEntry;
     }
 
-    DialogueChoicePtr Dialogue::addDialogueChoice(DialogueEntryPtr src, std::string choiceStr, DialogueEntryPtr dst, ID id)
+    DialogueChoicePtr Dialogue::addDialogueChoice(DialogueEntryPtr src, InternedString choiceStr, DialogueEntryPtr dst, ID id)
     {
         if (id >= _nextDialogueChoiceId)
             _nextDialogueChoiceId = id + 1;
-        auto choice = choices.emplace_back(new DialogueChoice(id, src, choiceStr, dst));
+        auto choice = choices.emplace_back(_choicePool.create(id, src, std::move(choiceStr), dst));
         src->choices.push_back(choice);
+        linkIncoming(choice);
+        choice->_dialogue = this;
+        choice->_index = choices.size() - 1;
+        _choicesById.emplace(id, choice);
+        record(Change::Kind::AddChoice, this, choice, src->choices.size() - 1);
+        markModified();
 
         return choice;
     }
 
-    DialogueChoicePtr Dialogue::addDialogueChoice(DialogueEntryPtr src, std::string choiceStr, ID id)
+    DialogueChoicePtr Dialogue::addDialogueChoice(DialogueEntryPtr src, InternedString choiceStr, ID id)
     {
         if (id >= _nextDialogueChoiceId)
             _nextDialogueChoiceId = id + 1;
-        auto choice = choices.emplace_back(new DialogueChoice(id, src, choiceStr));
+        auto choice = choices.emplace_back(_choicePool.create(id, src, std::move(choiceStr)));
         src->choices.push_back(choice);
+        choice->_dialogue = this;
+        choice->_index = choices.size() - 1;
+        _choicesById.emplace(id, choice);
+        record(Change::Kind::AddChoice, this, choice, src->choices.size() - 1);
+        markModified();
 
         return choice;
     }
 
+    void Dialogue::removeEntry(DialogueEntryPtr entry)
+    {
+        // Choices leaving the entry go with it, self loops included, which
+        // leaves only other entries' choices in _incoming. Last first, so
+        // putting them back in reverse restores their order.
+        HistoryTransaction transaction(this);
+        while (!entry->choices.empty())
+        {
+            auto choice = entry->choices.back();
+            auto position = detachChoice(choice);
+            record(Change::Kind::RemoveChoice, this, choice, position);
+        }
+        for (const auto &choice : entry->_incoming)
+        {
+            record(Change::Kind::ChoiceDst, this, choice, choice->dst);
+            choice->dst = nullptr;
+        }
+        entry->_incoming.clear();
+
+        detachEntry(entry);
+        record(Change::Kind::RemoveEntry, this, entry, size_t(0));
+        markModified();
+    }
+
+    void Dialogue::attachParticipant(ParticipantPtr participant, size_t index)
+    {
+        participants.insert(participants.begin() + index, participant);
+        participant->_dialogue = this;
+        _participantsById.emplace(participant->id, participant);
+        resolveParticipantName(participant->name);
+    }
+
+    void Dialogue::detachParticipant(size_t index)
+    {
+        auto participant = participants[index];
+        participants.erase(participants.begin() + index);
+        _participantsById.erase(participant->id);
+        participant->_dialogue = nullptr;
+        resolveParticipantName(participant->name);
+    }
+
+    // Name lookups return the first participant with a name.
+    void Dialogue::resolveParticipantName(const InternedString &name)
+    {
+        _participantsByName.erase(name);
+        for (const auto &other : participants)
+        {
+            if (other->name == name)
+            {
+                _participantsByName.emplace(name, other);
+                break;
+            }
+        }
+    }
+
+    void Dialogue::attachEntry(DialogueEntryPtr entry)
+    {
+        entry->_dialogue = this;
+        entry->_index = entries.size();
+        entries.push_back(entry);
+        _entriesById.emplace(entry->id, entry);
+    }
+
+    void Dialogue::detachEntry(DialogueEntryPtr entry)
+    {
+        auto find = _entriesById.find(entry->id);
+        if (find != _entriesById.end() && find->second == entry)
+        {
+            _entriesById.erase(find);
+        }
+        swapAndPop(entries, entry);
+        entry->_dialogue = nullptr;
+    }
+
+    void Dialogue::attachChoice(DialogueChoicePtr choice, size_t position)
+    {
+        auto &srcChoices = choice->src->choices;
+        srcChoices.insert(srcChoices.begin() + std::min(position, srcChoices.size()), choice);
+        choice->_dialogue = this;
+        choice->_index = choices.size();
+        choices.push_back(choice);
+        linkIncoming(choice);
+        _choicesById.emplace(choice->id, choice);
+        if (_manager)
+        {
+            _manager->indexChoiceGuid(choice);
+        }
+    }
+
+    // Returns the position the choice had in its source's choices. A choice
+    // its source does not list is a broken invariant, caught in debug builds
+    // and otherwise reported as the end of the list.
+    size_t Dialogue::detachChoice(DialogueChoicePtr choice)
+    {
+        if (_manager)
+        {
+            _manager->unindexChoiceGuid(choice);
+        }
+        unlinkIncoming(choice);
+
+        auto find = _choicesById.find(choice->id);
+        if (find != _choicesById.end() && find->second == choice)
+        {
+            _choicesById.erase(find);
+        }
+        swapAndPop(choices, choice);
+        choice->_dialogue = nullptr;
+
+        auto &srcChoices = choice->src->choices;
+        auto position = std::find(srcChoices.begin(), srcChoices.end(), choice);
+        assert(position != srcChoices.end());
+        if (position == srcChoices.end())
+        {
+            return srcChoices.size();
+        }
+        const auto index = static_cast<size_t>(position - srcChoices.begin());
+        srcChoices.erase(position);
+        return index;
+    }
+
     /////////////////////////////////////////////////////////////////////////////
 
     /////////////////////////////////////////////////////////////////////////////
     //Participant
 
+    void Participant::setName(std::string_view name)
+    {
+        if (_dialogue)
+        {
+            _dialogue->renameParticipant(this, name);
+        }
+        else
+        {
+            this->name = InternedString(name);
+        }
+    }
+
     /////////////////////////////////////////////////////////////////////////////
 
     /////////////////////////////////////////////////////////////////////////////
     //DialogueEntry
 
+    void DialogueEntry::setEntry(std::string_view entry)
+    {
+        record(Change::Kind::EntryText, _dialogue, this, this->entry);
+        this->entry = InternedString(entry);
+        markModified();
+    }
+
+    void DialogueEntry::setActiveParticipant(ParticipantPtr participant)
+    {
+        record(Change::Kind::EntryParticipant, _dialogue, this, activeParticipant);
+        activeParticipant = participant;
+        markModified();
+    }
+
+    void DialogueEntry::setViewPosition(double x, double y)
+    {
+        record(Change::Kind::EntryPosition, _dialogue, this, viewPosition);
+        viewPosition = {x, y};
+        markModified();
+    }
+
+    void DialogueEntry::setLReaction(eReaction reaction)
+    {
+        record(Change::Kind::EntryReactions, _dialogue, this, std::make_pair(lReaction, rReaction));
+        lReaction = reaction;
+        markModified();
+    }
+
+    void DialogueEntry::setRReaction(eReaction reaction)
+    {
+        record(Change::Kind::EntryReactions, _dialogue, this, std::make_pair(lReaction, rReaction));
+        rReaction = reaction;
+        markModified();
+    }
+
+    void DialogueEntry::markModified()
+    {
+        if (_dialogue)
+        {
+            _dialogue->markModified();
+        }
+    }
+
     /////////////////////////////////////////////////////////////////////////////
 
     /////////////////////////////////////////////////////////////////////////////
     //DialogueChoice
 
+    void DialogueChoice::setChoice(std::string_view choice)
+    {
+        record(Change::Kind::ChoiceText, _dialogue, this, this->choice);
+        this->choice = InternedString(choice);
+        markModified();
+    }
+
+    void DialogueChoice::setDst(DialogueEntryPtr dst)
+    {
+        // Removed choices are no longer listed as incoming anywhere.
+        record(Change::Kind::ChoiceDst, _dialogue, this, this->dst);
+        if (_dialogue)
+        {
+            unlinkIncoming(this);
+        }
+        this->dst = dst;
+        if (_dialogue)
+        {
+            linkIncoming(this);
+        }
+        markModified();
+    }
+
+    void DialogueChoice::assignGuid()
+    {
+        assignGuid(guid);
+    }
+
+    void DialogueChoice::assignGuid(const Guid &guid)
+    {
+        record(Change::Kind::ChoiceGuid, _dialogue, this, std::make_pair(this->guid, guidAssigned));
+        auto manager = _dialogue ? _dialogue->_manager : nullptr;
+        if (manager && guidAssigned)
+        {
+            manager->unindexChoiceGuid(this);
+        }
+
+        this->guid = guid;
+        guidAssigned = true;
+        if (manager)
+        {
+            manager->indexChoiceGuid(this);
+        }
+        markModified();
+    }
+
+    void DialogueChoice::clearGuid()
+    {
+        record(Change::Kind::ChoiceGuid, _dialogue, this, std::make_pair(guid, guidAssigned));
+        if (guidAssigned && _dialogue && _dialogue->_manager)
+        {
+            _dialogue->_manager->unindexChoiceGuid(this);
+        }
+        guidAssigned = false;
+        markModified();
+    }
+
+    void DialogueChoice::markModified()
+    {
+        if (_dialogue)
+        {
+            _dialogue->markModified();
+        }
+    }
+
     /////////////////////////////////////////////////////////////////////////////
 } // namespace floofy
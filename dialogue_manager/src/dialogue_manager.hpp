@@ -2,8 +2,12 @@
 
 #include "common/id.hpp"
 #include "common/guid.hpp"
+#include "common/interned_string.hpp"
+#include "common/object_pool.hpp"
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 
@@ -21,30 +25,115 @@ namespace floofy
   using DialogueEntryPtr = DialogueEntry * ;
   class Participant;
   using ParticipantPtr = Participant * ;
+  class DialogueHistory;
+  namespace binary
+  {
+    class ImageView;
+  }
   /////////////////////////////////////////////////////////////////////////////
 
   /////////////////////////////////////////////////////////////////////////////
   //DialogueManager
   class DialogueManager
   {
+    friend class Dialogue;
+    friend class DialogueChoice;
+    friend class DialogueHistory;
+
   public:
+    // The manager owns the dialogues added to it, removeDialogue hands
+    // ownership back to the caller.
     DialogueManager() = default;
-    ~DialogueManager() = default;
+    DialogueManager(const DialogueManager &) = delete;
+    DialogueManager &operator=(const DialogueManager &) = delete;
+    ~DialogueManager();
 
     DialoguePtr addDialogue(std::string name);
     bool addDialogue(DialoguePtr dlg);
     DialoguePtr dialogue(const std::string &name) const;
     DialoguePtr dialogue(size_t index) const;
     DialoguePtr removeDialogue(const std::string &name);
+    bool renameDialogue(DialoguePtr dlg, std::string name);
     size_t numDialogues() const;
 
-    bool writeToFile(const std::string &filePath) const;
+    // Choice with the given assigned GUID in any of the dialogues, choices
+    // without an assigned GUID are not indexed.
+    DialogueChoicePtr choice(const Guid &guid) const;
+
+    bool writeToFile(const std::string &filePath, bool indent = true) const;
+    bool writeToStream(std::ostream &stream, bool indent = true) const;
+    bool writeBinary(const std::string &filePath) const;
+    bool writeBinaryStream(std::ostream &stream) const;
+
+    // Sharded layout, a directory with one file per dialogue in the regular
+    // format plus a manifest keeping their order. Shards are written and read
+    // in parallel, shards of dialogues no longer present are removed.
+    bool writeSharded(const std::string &directory, bool indent = true) const;
+    // Like writeSharded, but when the directory is the one last written or
+    // read only dialogues modified since are rewritten.
+    bool writeShardedChanges(const std::string &directory, bool indent = true) const;
+    // Whether any dialogue changed, or dialogues were added, removed or
+    // reordered, since the last sharded write or read.
+    bool modified() const;
 
     static DialogueManagerPtr readFromFile(const std::string &filePath);
     static DialogueManagerPtr readContents(const std::string &contents);
     static DialogueManagerPtr readStream(std::istream& stream);
+    static DialogueManagerPtr readBinary(const std::string &filePath);
+    static DialogueManagerPtr readBinaryContents(const char *data, size_t size);
+    // Reads a single dialogue out of a validated binary image, nullptr when
+    // the index or the dialogue's records are bad.
+    static DialoguePtr readBinaryDialogue(const binary::ImageView &image, size_t index);
+    static DialogueManagerPtr readSharded(const std::string &directory);
+
+    // Applies the contents of source to this manager in place. Dialogues are
+    // matched by name and their participants, entries and choices by ID, or
+    // by assigned GUID for choices whose ID changed. Only nodes that differ
+    // are touched, so pointers to nodes that still exist stay valid and
+    // unchanged dialogues keep their revision. New dialogues are moved out of
+    // source. Nodes and dialogues no longer present are detached like removed
+    // ones and stay readable until this manager is freed.
+    void reload(DialogueManager &source);
+    // Reads the file in the regular format and reloads from it, false leaves
+    // the manager untouched when the file cannot be read.
+    bool reloadFromFile(const std::string &filePath);
+    bool reloadContents(const std::string &contents);
+    // Frees the dialogues dropped by reloads so far, which are otherwise
+    // kept until the manager is freed. Pointers into them become invalid.
+    void releaseReloadRemoved();
+
+    // Undo log recording changes to the dialogues, null when none is attached.
+    DialogueHistory *history() const { return _history; }
 
     std::vector<DialoguePtr> dialogues;
+
+  private:
+    template <typename Input>
+    static DialogueManagerPtr readJson(Input &&input);
+
+    bool writeShards(const std::string &directory, bool indent, bool onlyModified) const;
+
+    static bool patchDialogue(Dialogue &live, const Dialogue &source);
+
+    void indexChoiceGuids(DialoguePtr dlg);
+    void unindexChoiceGuids(DialoguePtr dlg);
+    void indexChoiceGuid(DialogueChoicePtr choice);
+    void unindexChoiceGuid(DialogueChoicePtr choice);
+
+    std::unordered_map<std::string, DialoguePtr> _dialoguesByName;
+    // GUIDs are expected to be unique, should two choices share one the
+    // first indexed wins.
+    std::unordered_map<Guid, DialogueChoicePtr> _choicesByGuid;
+
+    // Dialogue revisions as of the last sharded write or read of
+    // _shardDirectory, bookkeeping only, so it is updated by const writes.
+    mutable std::string _shardDirectory;
+    mutable std::vector<std::pair<const Dialogue *, uint64_t>> _shardRevisions;
+
+    // Dialogues dropped by a reload, kept for pointers still held to them.
+    std::vector<std::unique_ptr<Dialogue>> _reloadRemoved;
+
+    DialogueHistory *_history = nullptr;
   };
   /////////////////////////////////////////////////////////////////////////////
 
@@ -53,33 +142,89 @@ namespace floofy
   class Dialogue
   {
     friend class DialogueManager;
+    friend class DialogueHistory;
 
   public:
     Dialogue(std::string name) : name(std::move(name))
     {
     }
 
-    ParticipantPtr addParticipant(std::string name);
+    bool setName(std::string name);
+
+    // Bumped by every change made through the dialogue, its nodes' setters and
+    // the C API, so savers and caches can tell whether it changed.
+    uint64_t revision() const { return _revision; }
+    void markModified() { ++_revision; }
+
+    // History of the manager the dialogue belongs to, if any.
+    DialogueHistory *history() const { return _manager ? _manager->history() : nullptr; }
+
+    // Makes room for the given number of additional nodes up front.
+    void reserve(size_t numParticipants, size_t numEntries, size_t numChoices);
+
+    ParticipantPtr addParticipant(std::string_view name);
     size_t numParticipants() const;
     ParticipantPtr participant(size_t index) const;
-    ParticipantPtr participant(const std::string &name) const;
+    ParticipantPtr participant(std::string_view name) const;
+    ParticipantPtr participant(const InternedString &name) const;
     ParticipantPtr participant(ID id) const;
-    void removeParticipant(const std::string &name);
+    void removeParticipant(std::string_view name);
+    void renameParticipant(ParticipantPtr participant, std::string_view name);
 
-    DialogueEntryPtr addDialogueEntry(ParticipantPtr activeParticipant, std::string entry);
+    // Removals are O(1) apart from the nodes' own links: the last node of the
+    // list takes the removed one's place, so indexes of other nodes may
+    // change. Removing an entry removes its choices and leaves choices leading
+    // to it without a destination. Removed nodes stay readable through
+    // existing pointers until the dialogue is freed, with _dialogue cleared.
+    DialogueEntryPtr addDialogueEntry(ParticipantPtr activeParticipant, std::string_view entry);
     size_t numDialogueEntries() const;
     DialogueEntryPtr dialogueEntry(size_t index) const;
     DialogueEntryPtr dialogueEntry(ID id) const;
     void removeDialogueEntry(size_t index);
     void removeDialogueEntry(ID id);
 
-    DialogueChoicePtr addDialogueChoice(DialogueEntryPtr src, std::string choiceStr, DialogueEntryPtr dst);
-    DialogueChoicePtr addDialogueChoice(DialogueEntryPtr src, std::string choiceStr);
+    DialogueChoicePtr addDialogueChoice(DialogueEntryPtr src, std::string_view choiceStr, DialogueEntryPtr dst);
+    DialogueChoicePtr addDialogueChoice(DialogueEntryPtr src, std::string_view choiceStr);
     size_t numDialogueChoices() const;
     DialogueChoicePtr choice(size_t index) const;
     DialogueChoicePtr choice(ID id) const;
     void removeDialogueChoice(ID id);
 
+    // Batches for editor operations on many nodes at once, each applied as
+    // one history transaction with storage reserved up front. Moves and
+    // relinks naming an ID not in the dialogue are skipped and the number
+    // applied is returned. Created nodes are written to created, if given.
+    // Entry records without a participant of the dialogue, and choice records
+    // without a source entry or with an entry that is not in the dialogue,
+    // create nothing and yield nullptr.
+    static constexpr ID NO_ID = ID{ static_cast<size_t>(-1) };
+    struct EntryMove
+    {
+      ID entry;
+      double x, y;
+    };
+    struct ChoiceRelink
+    {
+      ID choice;
+      ID dst; // NO_ID clears the destination
+    };
+    struct EntryCreate
+    {
+      ParticipantPtr activeParticipant;
+      std::string_view entry;
+      double x, y;
+    };
+    struct ChoiceCreate
+    {
+      DialogueEntryPtr src;
+      std::string_view choice;
+      DialogueEntryPtr dst;
+    };
+    size_t moveDialogueEntries(const EntryMove *moves, size_t count);
+    size_t relinkDialogueChoices(const ChoiceRelink *relinks, size_t count);
+    void addDialogueEntries(const EntryCreate *records, size_t count, DialogueEntryPtr *created = nullptr);
+    void addDialogueChoices(const ChoiceCreate *records, size_t count, DialogueChoicePtr *created = nullptr);
+
     std::string name;
     std::vector<ParticipantPtr> participants;
     std::vector<DialogueChoicePtr> choices;
@@ -87,12 +232,42 @@ namespace floofy
     ID _nextParticipantId = ID{ 1 };
     ID _nextDialogueChoiceId = ID{ 1 };
     ID _nextEntryId = ID{ 1 };
+    DialogueManagerPtr _manager = nullptr;
 
   private:
-    ParticipantPtr addParticipant(std::string name, ID id);
-    DialogueEntryPtr addDialogueEntry(ParticipantPtr activeParticipant, std::string entry, ID id);
-    DialogueChoicePtr addDialogueChoice(DialogueEntryPtr dialogueEntry, std::string choiceStr, DialogueEntryPtr dst, ID id);
-    DialogueChoicePtr addDialogueChoice(DialogueEntryPtr dialogueEntry, std::string choiceStr, ID id);
+    ParticipantPtr addParticipant(InternedString name, ID id);
+    DialogueEntryPtr addDialogueEntry(ParticipantPtr activeParticipant, InternedString entry, ID id);
+    DialogueChoicePtr addDialogueChoice(DialogueEntryPtr dialogueEntry, InternedString choiceStr, DialogueEntryPtr dst, ID id);
+    DialogueChoicePtr addDialogueChoice(DialogueEntryPtr dialogueEntry, InternedString choiceStr, ID id);
+    void removeEntry(DialogueEntryPtr entry);
+
+    // Put nodes into and take them out of the lists and indexes, without
+    // touching their links or recording anything. The history replays adds
+    // and removals through these.
+    void attachParticipant(ParticipantPtr participant, size_t index);
+    void detachParticipant(size_t index);
+    // Name lookups return the first participant with a name, this points
+    // the lookup of name back at it after a rename, add or removal.
+    void resolveParticipantName(const InternedString &name);
+    void attachEntry(DialogueEntryPtr entry);
+    void detachEntry(DialogueEntryPtr entry);
+    // Choices go back to the given position in their source's choices.
+    void attachChoice(DialogueChoicePtr choice, size_t position);
+    size_t detachChoice(DialogueChoicePtr choice);
+
+    // Lookup indexes, kept in sync by every add, remove and rename.
+    std::unordered_map<InternedString, ParticipantPtr> _participantsByName;
+    std::unordered_map<ID, ParticipantPtr> _participantsById;
+    std::unordered_map<ID, DialogueEntryPtr> _entriesById;
+    std::unordered_map<ID, DialogueChoicePtr> _choicesById;
+
+    // Node storage, nodes live until the dialogue is freed, including removed
+    // ones which may still be referenced by other nodes or by API handles.
+    ObjectPool<Participant> _participantPool;
+    ObjectPool<DialogueEntry> _entryPool;
+    ObjectPool<DialogueChoice> _choicePool;
+
+    uint64_t _revision = 0;
   };
   /////////////////////////////////////////////////////////////////////////////
 
@@ -101,10 +276,13 @@ namespace floofy
   class Participant
   {
   public:
-    Participant(ID id, std::string name) : id(id), name(std::move(name)) {}
+    Participant(ID id, InternedString name) : id(id), name(std::move(name)) {}
+
+    void setName(std::string_view name);
 
     ID id;
-    std::string name;
+    InternedString name;
+    DialoguePtr _dialogue = nullptr;
   };
   /////////////////////////////////////////////////////////////////////////////
 
@@ -120,6 +298,8 @@ namespace floofy
     Surprised
   }; // REMEMBER TO UPDATE DIALOGUEMANAGER.CS
 
+  constexpr unsigned E_REACTION_VERSION = 1;
+
   /////////////////////////////////////////////////////////////////////////////
 
 
@@ -128,7 +308,7 @@ namespace floofy
   class DialogueEntry
   {
   public:
-    DialogueEntry(ID id, std::string entry, ParticipantPtr participant)
+    DialogueEntry(ID id, InternedString entry, ParticipantPtr participant)
       : id(id), entry(std::move(entry)), activeParticipant(std::move(participant))
     {
     }
@@ -136,8 +316,15 @@ namespace floofy
     bool operator==(const DialogueEntry &other) const;
     bool operator!=(const DialogueEntry &other) const;
 
+    // Setters mark the owning dialogue as modified.
+    void setEntry(std::string_view entry);
+    void setActiveParticipant(ParticipantPtr participant);
+    void setViewPosition(double x, double y);
+    void setLReaction(eReaction reaction);
+    void setRReaction(eReaction reaction);
+
     ID id;
-    std::string entry;
+    InternedString entry;
     std::vector<DialogueChoicePtr> choices;
     ParticipantPtr activeParticipant;
     struct Vector2
@@ -146,6 +333,14 @@ namespace floofy
     } viewPosition;
     eReaction lReaction = eReaction::None;
     eReaction rReaction = eReaction::None;
+    DialoguePtr _dialogue = nullptr;
+    // Position in the dialogue's entries, and the choices whose dst is this
+    // entry in no particular order.
+    size_t _index = 0;
+    std::vector<DialogueChoicePtr> _incoming;
+
+  private:
+    void markModified();
   };
   /////////////////////////////////////////////////////////////////////////////
 
@@ -154,23 +349,39 @@ namespace floofy
   class DialogueChoice
   {
   public:
-    DialogueChoice(ID id, DialogueEntryPtr src, std::string choice, DialogueEntryPtr dst)
-      : id(id), src(std::move(src)), choice(std::move(choice)), dst(std::move(dst))
+    DialogueChoice(ID id, DialogueEntryPtr src, InternedString choice, DialogueEntryPtr dst)
+      : id(id), choice(std::move(choice)), src(std::move(src)), dst(std::move(dst))
     {
     }
-    DialogueChoice(ID id, DialogueEntryPtr src, std::string choice)
-      : id(id), src(std::move(src)), choice(std::move(choice)), dst(nullptr)
+    DialogueChoice(ID id, DialogueEntryPtr src, InternedString choice)
+      : id(id), choice(std::move(choice)), src(std::move(src)), dst(nullptr)
     {
     }
 
     bool operator==(const DialogueChoice &other) const;
     bool operator!=(const DialogueChoice &other) const;
 
+    // Setters mark the owning dialogue as modified.
+    void setChoice(std::string_view choice);
+    void setDst(DialogueEntryPtr dst);
+
+    // Assign through these rather than the fields, so the manager's GUID
+    // index follows.
+    void assignGuid();
+    void assignGuid(const Guid &guid);
+    void clearGuid();
+
     ID id;
     Guid guid; 
     bool guidAssigned = false;
-    std::string choice;
+    InternedString choice;
     DialogueEntryPtr src, dst;
+    DialoguePtr _dialogue = nullptr;
+    // Position in the dialogue's choices.
+    size_t _index = 0;
+
+  private:
+    void markModified();
   };
   /////////////////////////////////////////////////////////////////////////////
 } // namespace floofy
\ No newline at end of file
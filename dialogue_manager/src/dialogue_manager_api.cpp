@@ -1,9 +1,22 @@
 #include "dialogue_manager/dialogue_manager_api.h"
 
+#include "dialogue_analysis.hpp"
+#include "dialogue_history.hpp"
+#include "dialogue_image.hpp"
+#include "dialogue_library.hpp"
 #include "dialogue_manager.hpp"
+#include "dialogue_runner.hpp"
+#include "dialogue_snapshot.hpp"
+#include "dialogue_store.hpp"
+#include "dialogue_watcher.hpp"
 #include "common/defines.hpp"
 #include "common/guid.hpp"
 
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <vector>
+
 using namespace floofy;
 
 namespace
@@ -14,8 +27,17 @@ namespace
   CAST_OPERATIONS(HDialogueEntry, DialogueEntry);
   CAST_OPERATIONS(HDialogueChoice, DialogueChoice);
   CAST_OPERATIONS(HGuid, Guid);
+  CAST_OPERATIONS(HDialogueImage, DialogueImage);
+  CAST_OPERATIONS(HDialogueLibrary, DialogueLibrary);
+  CAST_OPERATIONS(HDialogueStore, DialogueStore);
+  CAST_OPERATIONS(HDialogueRunner, DialogueRunner);
+  CAST_OPERATIONS(HDialoguePublisher, DialoguePublisher);
+  CAST_OPERATIONS(HDialogueSnapshot, DialogueSnapshotPtr);
+  CAST_OPERATIONS(HDialogueFileWatcher, DialogueFileWatcher);
+  CAST_OPERATIONS(HDialogueHistory, DialogueHistory);
+  CAST_OPERATIONS(HDialogueAnalysis, DialogueAnalysis);
 
-  void returnString(const std::string &dst, char *buf, _size_t bufSize)
+  void returnString(std::string_view dst, char *buf, _size_t bufSize)
   {
     if (!buf || bufSize < 1)
       return;
@@ -23,9 +45,64 @@ namespace
     buf[length] = '\0';
   }
 
-  void setString(std::string &str, char *buf, _size_t bufSize)
+  const char *returnView(std::string_view view, _size_t *length)
+  {
+    if (length)
+      *length = static_cast<_size_t>(view.size());
+    return view.data();
+  }
+
+  template <typename View>
+  _size_t indexOf(const View &view)
+  {
+    return view ? static_cast<_size_t>(view.index()) : DIALOGUE_INVALID_INDEX;
+  }
+
+  _size_t storeIndex(uint32_t index)
+  {
+    return index == DialogueStore::NO_INDEX ? DIALOGUE_INVALID_INDEX : static_cast<_size_t>(index);
+  }
+
+  _size_t analysisIndex(uint32_t index)
   {
-    str.assign(buf, bufSize);
+    return index == DialogueAnalysis::NO_INDEX ? DIALOGUE_INVALID_INDEX : static_cast<_size_t>(index);
+  }
+
+  _size_t returnIndices(const std::vector<uint32_t> &indices, _size_t *buf, _size_t capacity)
+  {
+    for (size_t i = 0; i < indices.size() && i < capacity; ++i)
+    {
+      buf[i] = static_cast<_size_t>(indices[i]);
+    }
+    return static_cast<_size_t>(indices.size());
+  }
+
+  // Converts a batch's records into the model's a chunk at a time in a
+  // buffer on the stack, so a large selection costs no copy of itself, and
+  // applies the chunks as one transaction. Returns the sum of what apply
+  // returns per chunk.
+  template <typename CppRecord, typename Record, typename Convert, typename Apply>
+  _size_t applyBatch(Dialogue &dialogue, const Record *records, _size_t count, Convert &&convert, Apply &&apply)
+  {
+    static_assert(std::is_trivially_destructible_v<CppRecord>);
+    constexpr size_t CHUNK_SIZE = 256;
+    alignas(CppRecord) unsigned char buffer[CHUNK_SIZE * sizeof(CppRecord)];
+    auto chunk = reinterpret_cast<CppRecord *>(buffer);
+
+    auto history = dialogue.history();
+    if (history)
+      history->begin();
+    _size_t applied = 0;
+    for (size_t first = 0; first < count; first += CHUNK_SIZE)
+    {
+      const auto size = std::min<size_t>(count - first, CHUNK_SIZE);
+      for (size_t i = 0; i < size; ++i)
+        new (chunk + i) CppRecord(convert(records[first + i]));
+      applied += static_cast<_size_t>(apply(chunk, size));
+    }
+    if (history)
+      history->commit();
+    return applied;
   }
 } // namespace
 
@@ -47,6 +124,11 @@ extern "C"
     return cast(mgr)->writeToFile(std::string(filePath, filePathSize));
   }
 
+  _result_t writeDialoguesCompact(HDialogueManager *mgr, const char *filePath, _size_t filePathSize)
+  {
+    return cast(mgr)->writeToFile(std::string(filePath, filePathSize), false);
+  }
+
   HDialogueManager *readDialoguesFromFile(const char *filePath, _size_t filePathSize)
   {
     return cast(DialogueManager::readFromFile(std::string(filePath, filePathSize)));
@@ -57,6 +139,131 @@ extern "C"
     return cast(DialogueManager::readContents(std::string(contents, contentsPathSize)));
   }
 
+  _result_t writeDialoguesBinary(HDialogueManager *mgr, const char *filePath, _size_t filePathSize)
+  {
+    return cast(mgr)->writeBinary(std::string(filePath, filePathSize));
+  }
+
+  HDialogueManager *readDialoguesBinaryFromFile(const char *filePath, _size_t filePathSize)
+  {
+    return cast(DialogueManager::readBinary(std::string(filePath, filePathSize)));
+  }
+
+  HDialogueManager *readDialoguesBinaryFromContents(const char *contents, _size_t contentsSize)
+  {
+    return cast(DialogueManager::readBinaryContents(contents, contentsSize));
+  }
+
+  _result_t writeDialoguesSharded(HDialogueManager *mgr, const char *directory, _size_t directorySize)
+  {
+    return cast(mgr)->writeSharded(std::string(directory, directorySize));
+  }
+
+  _result_t writeDialoguesShardedChanges(HDialogueManager *mgr, const char *directory, _size_t directorySize)
+  {
+    return cast(mgr)->writeShardedChanges(std::string(directory, directorySize));
+  }
+
+  HDialogueManager *readDialoguesSharded(const char *directory, _size_t directorySize)
+  {
+    return cast(DialogueManager::readSharded(std::string(directory, directorySize)));
+  }
+
+  bool dialogueManagerModified(HDialogueManager *mgr)
+  {
+    return cast(mgr)->modified();
+  }
+
+  _result_t reloadDialoguesFromFile(HDialogueManager *mgr, const char *filePath, _size_t filePathSize)
+  {
+    return cast(mgr)->reloadFromFile(std::string(filePath, filePathSize));
+  }
+
+  _result_t reloadDialoguesFromContents(HDialogueManager *mgr, const char *contents, _size_t contentsSize)
+  {
+    return cast(mgr)->reloadContents(std::string(contents, contentsSize));
+  }
+
+  void releaseDialoguesRemovedByReload(HDialogueManager *mgr)
+  {
+    cast(mgr)->releaseReloadRemoved();
+  }
+
+  HDialogueFileWatcher *newDialogueFileWatcher(const char *filePath, _size_t filePathSize)
+  {
+    return cast(DialogueFileWatcher::open(std::string(filePath, filePathSize)).release());
+  }
+
+  void freeDialogueFileWatcher(HDialogueFileWatcher *watcher)
+  {
+    delete cast(watcher);
+  }
+
+  bool dialogueFileWatcherChanged(HDialogueFileWatcher *watcher)
+  {
+    return cast(watcher)->changed();
+  }
+
+  HDialogueHistory *newDialogueHistory(HDialogueManager *mgr, _size_t budget)
+  {
+    return cast(DialogueHistory::attach(*cast(mgr), budget).release());
+  }
+
+  void freeDialogueHistory(HDialogueHistory *history)
+  {
+    delete cast(history);
+  }
+
+  void dialogueHistoryBegin(HDialogueHistory *history)
+  {
+    cast(history)->begin();
+  }
+
+  void dialogueHistoryCommit(HDialogueHistory *history)
+  {
+    cast(history)->commit();
+  }
+
+  bool dialogueHistoryUndo(HDialogueHistory *history)
+  {
+    return cast(history)->undo();
+  }
+
+  bool dialogueHistoryRedo(HDialogueHistory *history)
+  {
+    return cast(history)->redo();
+  }
+
+  _size_t dialogueHistoryNumUndo(HDialogueHistory *history)
+  {
+    return cast(history)->numUndo();
+  }
+
+  _size_t dialogueHistoryNumRedo(HDialogueHistory *history)
+  {
+    return cast(history)->numRedo();
+  }
+
+  _size_t dialogueHistoryNumDropped(HDialogueHistory *history)
+  {
+    return cast(history)->numDropped();
+  }
+
+  _size_t dialogueHistoryBytes(HDialogueHistory *history)
+  {
+    return cast(history)->bytes();
+  }
+
+  void setDialogueHistoryBudget(HDialogueHistory *history, _size_t budget)
+  {
+    cast(history)->setBudget(budget);
+  }
+
+  void clearDialogueHistory(HDialogueHistory *history)
+  {
+    cast(history)->clear();
+  }
+
   HDialogue *addNewDialogue(HDialogueManager *mgr, const char *name, _size_t nameSize)
   {
     auto cppMgr = cast(mgr);
@@ -98,10 +305,16 @@ extern "C"
     return cast(cppMgr->dialogue(index));
   }
 
+  HDialogueChoice *choiceFromGuid(HDialogueManager *mgr, HGuid *guid)
+  {
+    auto cppMgr = cast(mgr);
+    return guid ? cast(cppMgr->choice(*cast(guid))) : nullptr;
+  }
+
   HParticipant *addParticipant(HDialogue *dialogue, const char *name, _size_t nameSize)
   {
     auto cppDlg = cast(dialogue);
-    return cast(cppDlg->addParticipant(std::string(name, nameSize)));
+    return cast(cppDlg->addParticipant(std::string_view(name, nameSize)));
   }
 
   _size_t numParticipants(HDialogue *dialogue)
@@ -119,19 +332,19 @@ extern "C"
   HParticipant *participantFromName(HDialogue *dialogue, const char *name, _size_t size)
   {
     auto cppDlg = cast(dialogue);
-    return cast(cppDlg->participant(std::string(name, size)));
+    return cast(cppDlg->participant(std::string_view(name, size)));
   }
 
   void removeParticipant(HDialogue *dialogue, const char *name, _size_t size)
   {
     auto cppDlg = cast(dialogue);
-    cppDlg->removeParticipant(std::string(name, size));
+    cppDlg->removeParticipant(std::string_view(name, size));
   }
 
   HDialogueEntry *addDialogueEntry(HDialogue *dialogue, HParticipant *part, const char *name, _size_t size)
   {
     auto cppDlg = cast(dialogue);
-    return cast(cppDlg->addDialogueEntry(cast(part), std::string(name, size)));
+    return cast(cppDlg->addDialogueEntry(cast(part), std::string_view(name, size)));
   }
 
   _size_t numDialogueEntries(HDialogue *dialogue)
@@ -166,7 +379,7 @@ extern "C"
     HDialogueEntry *destDialogueEntry)
   {
     auto cppDlg = cast(dialogue);
-    return cast(cppDlg->addDialogueChoice(cast(dialogueEntry), std::string(name, size), cast(destDialogueEntry)));
+    return cast(cppDlg->addDialogueChoice(cast(dialogueEntry), std::string_view(name, size), cast(destDialogueEntry)));
   }
 
   HDialogueChoice *addDialogueChoice(HDialogue *dialogue,
@@ -175,7 +388,7 @@ extern "C"
     _size_t size)
   {
     auto cppDlg = cast(dialogue);
-    return cast(cppDlg->addDialogueChoice(cast(dialogueEntry), std::string(name, size)));
+    return cast(cppDlg->addDialogueChoice(cast(dialogueEntry), std::string_view(name, size)));
   }
 
   _size_t numDialogueChoices(HDialogue *dialogue)
@@ -197,6 +410,125 @@ extern "C"
     cppDlg->removeDialogueChoice(cppChoice->id);
   }
 
+  _size_t dialogueParticipantsData(HDialogue *dialogue, ParticipantData *data, _size_t capacity)
+  {
+    const auto &participants = cast(dialogue)->participants;
+    for (size_t i = 0; i < participants.size() && i < capacity; ++i)
+    {
+      const auto &participant = participants[i];
+      auto &record = data[i];
+      record.participant = cast(participant);
+      record.name = returnView(participant->name.view(), &record.nameLength);
+      record.id = static_cast<_size_t>(participant->id._id);
+    }
+    return static_cast<_size_t>(participants.size());
+  }
+
+  _size_t dialogueEntriesData(HDialogue *dialogue, DialogueEntryData *data, _size_t capacity)
+  {
+    const auto &entries = cast(dialogue)->entries;
+    for (size_t i = 0; i < entries.size() && i < capacity; ++i)
+    {
+      const auto &entry = entries[i];
+      auto &record = data[i];
+      record.entry = cast(entry);
+      record.activeParticipant = cast(entry->activeParticipant);
+      record.content = returnView(entry->entry.view(), &record.contentLength);
+      record.positionX = entry->viewPosition.x;
+      record.positionY = entry->viewPosition.y;
+      record.id = static_cast<_size_t>(entry->id._id);
+      record.participantId = entry->activeParticipant ? static_cast<_size_t>(entry->activeParticipant->id._id) : DIALOGUE_INVALID_INDEX;
+      record.numChoices = static_cast<_size_t>(entry->choices.size());
+      record.lReaction = static_cast<int>(entry->lReaction);
+      record.rReaction = static_cast<int>(entry->rReaction);
+    }
+    return static_cast<_size_t>(entries.size());
+  }
+
+  _size_t dialogueChoicesData(HDialogue *dialogue, DialogueChoiceData *data, _size_t capacity)
+  {
+    const auto &choices = cast(dialogue)->choices;
+    for (size_t i = 0; i < choices.size() && i < capacity; ++i)
+    {
+      const auto &choice = choices[i];
+      auto &record = data[i];
+      record.choice = cast(choice);
+      record.src = cast(choice->src);
+      record.dst = cast(choice->dst);
+      record.content = returnView(choice->choice.view(), &record.contentLength);
+      record.id = static_cast<_size_t>(choice->id._id);
+      record.srcId = choice->src ? static_cast<_size_t>(choice->src->id._id) : DIALOGUE_INVALID_INDEX;
+      record.dstId = choice->dst ? static_cast<_size_t>(choice->dst->id._id) : DIALOGUE_INVALID_INDEX;
+      record.guidAssigned = choice->guidAssigned ? 1 : 0;
+    }
+    return static_cast<_size_t>(choices.size());
+  }
+
+  _size_t dialogueEntryChoices(HDialogueEntry *entry, HDialogueChoice **choices, _size_t capacity)
+  {
+    const auto &entryChoices = cast(entry)->choices;
+    for (size_t i = 0; i < entryChoices.size() && i < capacity; ++i)
+    {
+      choices[i] = cast(entryChoices[i]);
+    }
+    return static_cast<_size_t>(entryChoices.size());
+  }
+
+  _size_t moveDialogueEntries(HDialogue *dialogue, const DialogueEntryMove *moves, _size_t count)
+  {
+    return applyBatch<Dialogue::EntryMove>(
+        *cast(dialogue), moves, count,
+        [](const DialogueEntryMove &move) { return Dialogue::EntryMove{ID{move.id}, move.positionX, move.positionY}; },
+        [cppDlg = cast(dialogue)](const Dialogue::EntryMove *chunk, size_t size) { return cppDlg->moveDialogueEntries(chunk, size); });
+  }
+
+  _size_t relinkDialogueChoices(HDialogue *dialogue, const DialogueChoiceRelink *relinks, _size_t count)
+  {
+    return applyBatch<Dialogue::ChoiceRelink>(
+        *cast(dialogue), relinks, count,
+        [](const DialogueChoiceRelink &relink) {
+          return Dialogue::ChoiceRelink{ID{relink.id}, relink.dstId == DIALOGUE_INVALID_INDEX ? Dialogue::NO_ID : ID{relink.dstId}};
+        },
+        [cppDlg = cast(dialogue)](const Dialogue::ChoiceRelink *chunk, size_t size) { return cppDlg->relinkDialogueChoices(chunk, size); });
+  }
+
+  void addDialogueEntries(HDialogue *dialogue, const DialogueEntryCreate *records, _size_t count, HDialogueEntry **created)
+  {
+    auto cppDlg = cast(dialogue);
+    cppDlg->reserve(0, count, 0);
+    applyBatch<Dialogue::EntryCreate>(
+        *cppDlg, records, count,
+        [](const DialogueEntryCreate &record) {
+          return Dialogue::EntryCreate{cast(record.activeParticipant), std::string_view(record.content, record.contentLength), record.positionX,
+                                       record.positionY};
+        },
+        [cppDlg, &created, nodes = std::vector<DialogueEntryPtr>()](const Dialogue::EntryCreate *chunk, size_t size) mutable {
+          nodes.resize(created ? size : 0);
+          cppDlg->addDialogueEntries(chunk, size, created ? nodes.data() : nullptr);
+          for (size_t i = 0; i < nodes.size(); ++i)
+            *created++ = cast(nodes[i]);
+          return size;
+        });
+  }
+
+  void addDialogueChoices(HDialogue *dialogue, const DialogueChoiceCreate *records, _size_t count, HDialogueChoice **created)
+  {
+    auto cppDlg = cast(dialogue);
+    cppDlg->reserve(0, 0, count);
+    applyBatch<Dialogue::ChoiceCreate>(
+        *cppDlg, records, count,
+        [](const DialogueChoiceCreate &record) {
+          return Dialogue::ChoiceCreate{cast(record.src), std::string_view(record.content, record.contentLength), cast(record.dst)};
+        },
+        [cppDlg, &created, nodes = std::vector<DialogueChoicePtr>()](const Dialogue::ChoiceCreate *chunk, size_t size) mutable {
+          nodes.resize(created ? size : 0);
+          cppDlg->addDialogueChoices(chunk, size, created ? nodes.data() : nullptr);
+          for (size_t i = 0; i < nodes.size(); ++i)
+            *created++ = cast(nodes[i]);
+          return size;
+        });
+  }
+
   void dialogueName(HDialogue *dialogue, char *name, _size_t bufferSize)
   {
     auto cppDlg = cast(dialogue);
@@ -206,31 +538,61 @@ extern "C"
   void setDialogueName(HDialogue *dialogue, char *name, _size_t bufferSize)
   {
     auto cppDlg = cast(dialogue);
-    setString(cppDlg->name, name, bufferSize);
+    cppDlg->setName(std::string(name, bufferSize));
+  }
+
+  _size_t dialogueNameLength(HDialogue *dialogue)
+  {
+    return static_cast<_size_t>(cast(dialogue)->name.size());
+  }
+
+  const char *dialogueNameView(HDialogue *dialogue, _size_t *length)
+  {
+    return returnView(cast(dialogue)->name, length);
   }
 
   void participantName(HParticipant *participant, char *name, _size_t bufferSize)
   {
     auto cppPart = cast(participant);
-    returnString(cppPart->name, name, bufferSize);
+    returnString(cppPart->name.view(), name, bufferSize);
   }
 
   void setParticipantName(HParticipant *participant, char *name, _size_t bufferSize)
   {
     auto cppPart = cast(participant);
-    setString(cppPart->name, name, bufferSize);
+    cppPart->setName(std::string(name, bufferSize));
+  }
+
+  _size_t participantNameLength(HParticipant *participant)
+  {
+    return static_cast<_size_t>(cast(participant)->name.size());
+  }
+
+  const char *participantNameView(HParticipant *participant, _size_t *length)
+  {
+    return returnView(cast(participant)->name.view(), length);
   }
 
   void dialogueEntryContent(HDialogueEntry *entry, char *content, _result_t bufferSize)
   {
     auto cppEntry = cast(entry);
-    returnString(cppEntry->entry, content, bufferSize);
+    returnString(cppEntry->entry.view(), content, bufferSize);
   }
 
   void setDialogueEntryContent(HDialogueEntry *entry, char *content, _result_t bufferSize)
   {
     auto cppEntry = cast(entry);
-    setString(cppEntry->entry, content, bufferSize);
+    cppEntry->setEntry(std::string(content, bufferSize));
+  }
+
+  _size_t dialogueEntryContentLength(HDialogueEntry *entry)
+  {
+    return static_cast<_size_t>(cast(entry)->entry.size());
+  }
+
+  const char *dialogueEntryContentView(HDialogueEntry *entry, _size_t *length)
+  {
+    return returnView(cast(entry)->entry.view(), length);
   }
 
   _size_t dialogueEntryNumDialogueChoices(HDialogueEntry *entry)
@@ -254,7 +616,7 @@ extern "C"
   void setDialogueEntryActiveParticipant(HDialogueEntry *entry, HParticipant *participant)
   {
     auto cppEntry = cast(entry);
-    cppEntry->activeParticipant = cast(participant);
+    cppEntry->setActiveParticipant(cast(participant));
   }
 
   double dialogueEntryPositionX(HDialogueEntry *entry)
@@ -272,7 +634,7 @@ extern "C"
   void setDialogueEntryPosition(HDialogueEntry *entry, double x, double y)
   {
     auto cppEntry = cast(entry);
-    cppEntry->viewPosition = { x, y };
+    cppEntry->setViewPosition(x, y);
   }
 
   int dialogueEntryLReaction(HDialogueEntry *entry)
@@ -284,7 +646,7 @@ extern "C"
   void setDialogueEntryLReaction(HDialogueEntry *entry, int reaction)
   {
     auto cppEntry = cast(entry);
-    cppEntry->lReaction = static_cast<floofy::eReaction>(reaction);
+    cppEntry->setLReaction(static_cast<floofy::eReaction>(reaction));
   }
 
   int dialogueEntryRReaction(HDialogueEntry *entry)
@@ -296,19 +658,29 @@ extern "C"
   void setDialogueEntryRReaction(HDialogueEntry *entry, int reaction)
   {
     auto cppEntry = cast(entry);
-    cppEntry->rReaction = static_cast<floofy::eReaction>(reaction);
+    cppEntry->setRReaction(static_cast<floofy::eReaction>(reaction));
   }
 
   void dialogueChoiceContent(HDialogueChoice *choice, char *content, _size_t bufferSize)
   {
     auto cppDialogueChoice = cast(choice);
-    returnString(cppDialogueChoice->choice, content, bufferSize);
+    returnString(cppDialogueChoice->choice.view(), content, bufferSize);
   }
 
   void setDialogueChoiceContent(HDialogueChoice *choice, char *content, _size_t bufferSize)
   {
     auto cppDialogueChoice = cast(choice);
-    setString(cppDialogueChoice->choice, content, bufferSize);
+    cppDialogueChoice->setChoice(std::string(content, bufferSize));
+  }
+
+  _size_t dialogueChoiceContentLength(HDialogueChoice *choice)
+  {
+    return static_cast<_size_t>(cast(choice)->choice.size());
+  }
+
+  const char *dialogueChoiceContentView(HDialogueChoice *choice, _size_t *length)
+  {
+    return returnView(cast(choice)->choice.view(), length);
   }
 
   HDialogueEntry *dialogueChoiceSrcEntry(HDialogueChoice *choice)
@@ -326,13 +698,13 @@ extern "C"
   void setDialogueChoiceDstEntry(HDialogueChoice *choice, HDialogueEntry *entry)
   {
     auto cppDialogueChoice = cast(choice);
-    cppDialogueChoice->dst = cast(entry);
+    cppDialogueChoice->setDst(cast(entry));
   }
 
   void assignDialogueChoiceGuid(HDialogueChoice *choice)
   {
     auto cppDialogueChoice = cast(choice);
-    cppDialogueChoice->guidAssigned = true;
+    cppDialogueChoice->assignGuid();
   }
 
   bool dialogueChoiceGuidAssigned(HDialogueChoice *choice)
@@ -357,7 +729,9 @@ extern "C"
   EXPORT void guidToString(HGuid *guid, char *content, _size_t bufferSize)
   {
     auto cppGuid = cast(guid);
-    returnString(cppGuid->toString(), content, bufferSize);
+    char text[Guid::STRING_LENGTH];
+    cppGuid->format(text);
+    returnString(std::string_view(text, sizeof(text)), content, bufferSize);
   }
 
   EXPORT HGuid* guidFromString(const char *content, _size_t bufferSize)
@@ -365,14 +739,459 @@ extern "C"
     if(content == 0 || bufferSize == 0)
       return NULL;
 
-    auto guid = new Guid(std::string{content, bufferSize});
+    // Malformed strings give the invalid GUID, see guidIsValid.
+    auto guid = new Guid(std::string_view{content, bufferSize});
     return cast(guid);
   }
 
+  EXPORT void freeGuid(HGuid *guid)
+  {
+    delete cast(guid);
+  }
+
   EXPORT bool guidIsValid(HGuid *guid)
   {
     auto cppGuid = cast(guid);
     return cppGuid->isValid();
   }
 
-}
\ No newline at end of file
+  HDialogueImage *openDialogueImage(const char *filePath, _size_t filePathSize)
+  {
+    return cast(DialogueImage::open(std::string(filePath, filePathSize)).release());
+  }
+
+  void closeDialogueImage(HDialogueImage *image)
+  {
+    delete cast(image);
+  }
+
+  _size_t dialogueImageNumDialogues(HDialogueImage *image)
+  {
+    return cast(image)->numDialogues();
+  }
+
+  _size_t dialogueImageDialogueFromName(HDialogueImage *image, const char *name, _size_t size)
+  {
+    auto cppImage = cast(image);
+    return indexOf(cppImage->dialogue(std::string_view(name, size)));
+  }
+
+  const char *dialogueImageDialogueName(HDialogueImage *image, _size_t dialogue, _size_t *length)
+  {
+    auto cppImage = cast(image);
+    return returnView(cppImage->dialogue(dialogue).name(), length);
+  }
+
+  _size_t dialogueImageNumParticipants(HDialogueImage *image, _size_t dialogue)
+  {
+    auto cppImage = cast(image);
+    return cppImage->dialogue(dialogue).numParticipants();
+  }
+
+  const char *dialogueImageParticipantName(HDialogueImage *image, _size_t dialogue, _size_t participant, _size_t *length)
+  {
+    auto cppImage = cast(image);
+    return returnView(cppImage->dialogue(dialogue).participant(participant).name(), length);
+  }
+
+  _size_t dialogueImageNumDialogueEntries(HDialogueImage *image, _size_t dialogue)
+  {
+    auto cppImage = cast(image);
+    return cppImage->dialogue(dialogue).numDialogueEntries();
+  }
+
+  const char *dialogueImageEntryContent(HDialogueImage *image, _size_t dialogue, _size_t entry, _size_t *length)
+  {
+    auto cppImage = cast(image);
+    return returnView(cppImage->dialogue(dialogue).dialogueEntry(entry).entry(), length);
+  }
+
+  _size_t dialogueImageEntryActiveParticipant(HDialogueImage *image, _size_t dialogue, _size_t entry)
+  {
+    auto cppImage = cast(image);
+    return indexOf(cppImage->dialogue(dialogue).dialogueEntry(entry).activeParticipant());
+  }
+
+  int dialogueImageEntryLReaction(HDialogueImage *image, _size_t dialogue, _size_t entry)
+  {
+    auto cppImage = cast(image);
+    return cppImage->dialogue(dialogue).dialogueEntry(entry).lReaction();
+  }
+
+  int dialogueImageEntryRReaction(HDialogueImage *image, _size_t dialogue, _size_t entry)
+  {
+    auto cppImage = cast(image);
+    return cppImage->dialogue(dialogue).dialogueEntry(entry).rReaction();
+  }
+
+  _size_t dialogueImageEntryNumDialogueChoices(HDialogueImage *image, _size_t dialogue, _size_t entry)
+  {
+    auto cppImage = cast(image);
+    return cppImage->dialogue(dialogue).dialogueEntry(entry).numDialogueChoices();
+  }
+
+  _size_t dialogueImageEntryDialogueChoiceFromIndex(HDialogueImage *image, _size_t dialogue, _size_t entry, _size_t index)
+  {
+    auto cppImage = cast(image);
+    return indexOf(cppImage->dialogue(dialogue).dialogueEntry(entry).choice(index));
+  }
+
+  _size_t dialogueImageNumDialogueChoices(HDialogueImage *image, _size_t dialogue)
+  {
+    auto cppImage = cast(image);
+    return cppImage->dialogue(dialogue).numDialogueChoices();
+  }
+
+  const char *dialogueImageChoiceContent(HDialogueImage *image, _size_t dialogue, _size_t choice, _size_t *length)
+  {
+    auto cppImage = cast(image);
+    return returnView(cppImage->dialogue(dialogue).choice(choice).choice(), length);
+  }
+
+  _size_t dialogueImageChoiceDstEntry(HDialogueImage *image, _size_t dialogue, _size_t choice)
+  {
+    auto cppImage = cast(image);
+    return indexOf(cppImage->dialogue(dialogue).choice(choice).dst());
+  }
+
+  HDialogueLibrary *openDialogueLibrary(const char *filePath, _size_t filePathSize, _size_t budget)
+  {
+    return cast(DialogueLibrary::open(std::string(filePath, filePathSize), budget).release());
+  }
+
+  void closeDialogueLibrary(HDialogueLibrary *library)
+  {
+    delete cast(library);
+  }
+
+  _size_t dialogueLibraryNumDialogues(HDialogueLibrary *library)
+  {
+    return cast(library)->numDialogues();
+  }
+
+  _size_t dialogueLibraryNumLoaded(HDialogueLibrary *library)
+  {
+    return cast(library)->numLoaded();
+  }
+
+  HDialogue *dialogueLibraryDialogueFromName(HDialogueLibrary *library, const char *name, _size_t size)
+  {
+    return cast(cast(library)->dialogue(std::string_view(name, size)));
+  }
+
+  HDialogue *dialogueLibraryDialogueFromIndex(HDialogueLibrary *library, _size_t index)
+  {
+    return cast(cast(library)->dialogue(index));
+  }
+
+  HDialogueStore *buildDialogueStore(HDialogue *dialogue)
+  {
+    auto cppDlg = cast(dialogue);
+    if (!cppDlg)
+    {
+      return nullptr;
+    }
+
+    return cast(new DialogueStore(*cppDlg));
+  }
+
+  void freeDialogueStore(HDialogueStore *store)
+  {
+    delete cast(store);
+  }
+
+  _size_t dialogueStoreNumParticipants(HDialogueStore *store)
+  {
+    return cast(store)->numParticipants();
+  }
+
+  const char *dialogueStoreParticipantName(HDialogueStore *store, _size_t participant, _size_t *length)
+  {
+    auto cppStore = cast(store);
+    if (participant >= cppStore->numParticipants())
+    {
+      return returnView({}, length);
+    }
+
+    return returnView(cppStore->participantName(static_cast<uint32_t>(participant)), length);
+  }
+
+  _size_t dialogueStoreNumDialogueEntries(HDialogueStore *store)
+  {
+    return cast(store)->numEntries();
+  }
+
+  _size_t dialogueStoreEntryFromId(HDialogueStore *store, _size_t id)
+  {
+    return storeIndex(cast(store)->entryIndex(ID{id}));
+  }
+
+  const char *dialogueStoreEntryContent(HDialogueStore *store, _size_t entry, _size_t *length)
+  {
+    auto cppStore = cast(store);
+    if (entry >= cppStore->numEntries())
+    {
+      return returnView({}, length);
+    }
+
+    return returnView(cppStore->entryText(static_cast<uint32_t>(entry)), length);
+  }
+
+  _size_t dialogueStoreEntryActiveParticipant(HDialogueStore *store, _size_t entry)
+  {
+    auto cppStore = cast(store);
+    if (entry >= cppStore->numEntries())
+    {
+      return DIALOGUE_INVALID_INDEX;
+    }
+
+    return storeIndex(cppStore->entryParticipant(static_cast<uint32_t>(entry)));
+  }
+
+  _size_t dialogueStoreEntryNumDialogueChoices(HDialogueStore *store, _size_t entry)
+  {
+    auto cppStore = cast(store);
+    if (entry >= cppStore->numEntries())
+    {
+      return 0;
+    }
+
+    return cppStore->entryChoices(static_cast<uint32_t>(entry)).size();
+  }
+
+  _size_t dialogueStoreEntryDialogueChoiceFromIndex(HDialogueStore *store, _size_t entry, _size_t index)
+  {
+    auto cppStore = cast(store);
+    if (index >= dialogueStoreEntryNumDialogueChoices(store, entry))
+    {
+      return DIALOGUE_INVALID_INDEX;
+    }
+
+    return cppStore->entryChoices(static_cast<uint32_t>(entry))[index];
+  }
+
+  _size_t dialogueStoreEntryNextEntries(HDialogueStore *store, _size_t entry, _size_t *entries, _size_t capacity)
+  {
+    auto cppStore = cast(store);
+    if (entry >= cppStore->numEntries())
+    {
+      return 0;
+    }
+
+    // Returns the number of destinations, at most capacity of them are written.
+    const auto choices = cppStore->entryChoices(static_cast<uint32_t>(entry));
+    for (size_t i = 0; i < choices.size() && i < capacity; ++i)
+    {
+      entries[i] = storeIndex(cppStore->choiceDst(choices[i]));
+    }
+    return choices.size();
+  }
+
+  _size_t dialogueStoreNumDialogueChoices(HDialogueStore *store)
+  {
+    return cast(store)->numChoices();
+  }
+
+  const char *dialogueStoreChoiceContent(HDialogueStore *store, _size_t choice, _size_t *length)
+  {
+    auto cppStore = cast(store);
+    if (choice >= cppStore->numChoices())
+    {
+      return returnView({}, length);
+    }
+
+    return returnView(cppStore->choiceText(static_cast<uint32_t>(choice)), length);
+  }
+
+  _size_t dialogueStoreChoiceDstEntry(HDialogueStore *store, _size_t choice)
+  {
+    auto cppStore = cast(store);
+    if (choice >= cppStore->numChoices())
+    {
+      return DIALOGUE_INVALID_INDEX;
+    }
+
+    return storeIndex(cppStore->choiceDst(static_cast<uint32_t>(choice)));
+  }
+
+  HDialoguePublisher *newDialoguePublisher()
+  {
+    return cast(new DialoguePublisher);
+  }
+
+  void freeDialoguePublisher(HDialoguePublisher *publisher)
+  {
+    delete cast(publisher);
+  }
+
+  _size_t publishDialogueSnapshot(HDialoguePublisher *publisher, HDialogueManager *mgr)
+  {
+    auto cppPublisher = cast(publisher);
+    auto cppMgr = cast(mgr);
+    if (!cppPublisher || !cppMgr)
+    {
+      return 0;
+    }
+
+    cppPublisher->publish(*cppMgr);
+    return static_cast<_size_t>(cppPublisher->version());
+  }
+
+  HDialogueSnapshot *acquireDialogueSnapshot(HDialoguePublisher *publisher)
+  {
+    auto snapshot = cast(publisher)->current();
+    return snapshot ? cast(new DialogueSnapshotPtr(std::move(snapshot))) : nullptr;
+  }
+
+  void releaseDialogueSnapshot(HDialogueSnapshot *snapshot)
+  {
+    delete cast(snapshot);
+  }
+
+  _size_t dialogueSnapshotNumDialogues(HDialogueSnapshot *snapshot)
+  {
+    return (*cast(snapshot))->numDialogues();
+  }
+
+  HDialogueStore *dialogueSnapshotStoreFromIndex(HDialogueSnapshot *snapshot, _size_t index)
+  {
+    const auto &cppSnapshot = *cast(snapshot);
+    return index < cppSnapshot->numDialogues() ? cast(const_cast<DialogueStore *>(&cppSnapshot->dialogue(index))) : nullptr;
+  }
+
+  HDialogueStore *dialogueSnapshotStoreFromName(HDialogueSnapshot *snapshot, const char *name, _size_t size)
+  {
+    return cast(const_cast<DialogueStore *>((*cast(snapshot))->dialogue(std::string_view(name, size))));
+  }
+
+  HDialogueRunner *newDialogueRunner(HDialogueStore *store, _size_t entry)
+  {
+    auto cppStore = cast(store);
+    if (!cppStore || entry >= cppStore->numEntries())
+    {
+      return nullptr;
+    }
+
+    return cast(new DialogueRunner(*cppStore, static_cast<uint32_t>(entry)));
+  }
+
+  void freeDialogueRunner(HDialogueRunner *runner)
+  {
+    delete cast(runner);
+  }
+
+  void dialogueRunnerReset(HDialogueRunner *runner, _size_t entry)
+  {
+    auto cppRunner = cast(runner);
+    cppRunner->reset(entry < cppRunner->store().numEntries() ? static_cast<uint32_t>(entry) : DialogueStore::NO_INDEX);
+  }
+
+  bool dialogueRunnerFinished(HDialogueRunner *runner)
+  {
+    return cast(runner)->finished();
+  }
+
+  _size_t dialogueRunnerCurrentEntry(HDialogueRunner *runner)
+  {
+    return storeIndex(cast(runner)->current());
+  }
+
+  _size_t dialogueRunnerNumChoices(HDialogueRunner *runner)
+  {
+    return cast(runner)->choices().size();
+  }
+
+  _size_t dialogueRunnerChoiceFromIndex(HDialogueRunner *runner, _size_t index)
+  {
+    const auto choices = cast(runner)->choices();
+    return index < choices.size() ? choices[index] : DIALOGUE_INVALID_INDEX;
+  }
+
+  bool dialogueRunnerSelect(HDialogueRunner *runner, _size_t index)
+  {
+    return cast(runner)->select(index);
+  }
+
+  static uint32_t analysisRoot(const Dialogue &dialogue, _size_t root)
+  {
+    return root < dialogue.entries.size() ? static_cast<uint32_t>(root) : DialogueAnalysis::NO_INDEX;
+  }
+
+  HDialogueAnalysis *analyseDialogue(HDialogue *dialogue, _size_t root)
+  {
+    return cast(new DialogueAnalysis(*cast(dialogue), analysisRoot(*cast(dialogue), root)));
+  }
+
+  _size_t analyseDialogues(HDialogueManager *mgr, const _size_t *roots, HDialogueAnalysis **analyses, _size_t capacity)
+  {
+    auto cppMgr = cast(mgr);
+    const auto numDialogues = cppMgr->numDialogues();
+    if (capacity < numDialogues)
+    {
+      return static_cast<_size_t>(numDialogues);
+    }
+
+    std::vector<uint32_t> cppRoots;
+    if (roots)
+    {
+      cppRoots.resize(numDialogues);
+      for (size_t i = 0; i < numDialogues; ++i)
+      {
+        cppRoots[i] = analysisRoot(*cppMgr->dialogue(i), roots[i]);
+      }
+    }
+
+    auto cppAnalyses = DialogueAnalysis::analyse(*cppMgr, roots ? cppRoots.data() : nullptr);
+    for (size_t i = 0; i < cppAnalyses.size(); ++i)
+    {
+      analyses[i] = cast(new DialogueAnalysis(std::move(cppAnalyses[i])));
+    }
+    return static_cast<_size_t>(cppAnalyses.size());
+  }
+
+  void freeDialogueAnalysis(HDialogueAnalysis *analysis)
+  {
+    delete cast(analysis);
+  }
+
+  _size_t dialogueAnalysisUnreachableEntries(HDialogueAnalysis *analysis, _size_t *entries, _size_t capacity)
+  {
+    return returnIndices(cast(analysis)->unreachableEntries(), entries, capacity);
+  }
+
+  _size_t dialogueAnalysisDanglingChoices(HDialogueAnalysis *analysis, _size_t *choices, _size_t capacity)
+  {
+    return returnIndices(cast(analysis)->danglingChoices(), choices, capacity);
+  }
+
+  _size_t dialogueAnalysisDeadEnds(HDialogueAnalysis *analysis, _size_t *entries, _size_t capacity)
+  {
+    return returnIndices(cast(analysis)->deadEnds(), entries, capacity);
+  }
+
+  _size_t dialogueAnalysisNumComponents(HDialogueAnalysis *analysis)
+  {
+    return static_cast<_size_t>(cast(analysis)->numComponents());
+  }
+
+  _size_t dialogueAnalysisEntryComponent(HDialogueAnalysis *analysis, _size_t entry)
+  {
+    auto cppAnalysis = cast(analysis);
+    return entry < cppAnalysis->numEntries() ? analysisIndex(cppAnalysis->component(static_cast<uint32_t>(entry))) : DIALOGUE_INVALID_INDEX;
+  }
+
+  _size_t dialogueAnalysisCyclicComponents(HDialogueAnalysis *analysis, _size_t *components, _size_t capacity)
+  {
+    return returnIndices(cast(analysis)->cyclicComponents(), components, capacity);
+  }
+
+  _size_t dialogueAnalysisLongestPath(HDialogueAnalysis *analysis)
+  {
+    return static_cast<_size_t>(cast(analysis)->longestPath());
+  }
+
+  _size_t dialogueAnalysisLongestPathEnd(HDialogueAnalysis *analysis)
+  {
+    return analysisIndex(cast(analysis)->longestPathEnd());
+  }
+}
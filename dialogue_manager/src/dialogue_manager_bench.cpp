@@ -0,0 +1,937 @@
+#include "dialogue_manager/dialogue_manager_api.h"
+
+#include "dialogue_analysis.hpp"
+#include "dialogue_history.hpp"
+#include "dialogue_library.hpp"
+#include "dialogue_manager.hpp"
+#include "dialogue_runner.hpp"
+#include "dialogue_snapshot.hpp"
+#include "dialogue_store.hpp"
+#include "common/guid.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace floofy;
+
+/////////////////////////////////////////////////////////////////////////////
+// Allocation counting
+
+namespace
+{
+  std::atomic<size_t> allocations{0};
+
+  // Every replaced delete frees through here. Were free inlined into them,
+  // GCC would see memory from operator new reach free and warn about a
+  // mismatched deallocation, which the replacements make deliberately.
+#ifdef _MSC_VER
+  __declspec(noinline)
+#else
+  __attribute__((noinline))
+#endif
+  void freeAllocation(void *ptr, bool aligned) noexcept
+  {
+#ifdef _WIN32
+    if (aligned)
+    {
+      _aligned_free(ptr);
+      return;
+    }
+#else
+    (void)aligned;
+#endif
+    std::free(ptr);
+  }
+}
+
+void *operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+  freeAllocation(ptr, false);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  freeAllocation(ptr, false);
+}
+
+void *operator new(size_t size, std::align_val_t align)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  const auto alignment = static_cast<size_t>(align);
+  // Like the unaligned path, a size of 0 still gets its own block, aligned_alloc
+  // may return null for it.
+  size = size ? size : 1;
+#ifdef _WIN32
+  void *ptr = _aligned_malloc(size, alignment);
+#else
+  void *ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+  if (!ptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+  freeAllocation(ptr, true);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+  freeAllocation(ptr, true);
+}
+
+namespace
+{
+  // Reports the allocations made since construction as a per iteration average.
+  class AllocationCounter
+  {
+  public:
+    explicit AllocationCounter(benchmark::State &state) : _state(state), _start(allocations.load()) {}
+    ~AllocationCounter()
+    {
+      _state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations.load() - _start), benchmark::Counter::kAvgIterations);
+    }
+
+  private:
+    benchmark::State &_state;
+    size_t _start;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Synthetic dialogues
+  //
+  // Arguments are the number of entries, the number of choices per entry and
+  // the length of every entry and choice text. Destinations are chosen with a
+  // fixed seed so every run measures the same graph.
+
+  constexpr size_t NUM_PARTICIPANTS = 4;
+
+  std::string makeText(std::mt19937 &rng, size_t length)
+  {
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::string text(length, ' ');
+    for (auto &c : text)
+    {
+      c = static_cast<char>(letter(rng));
+    }
+    return text;
+  }
+
+  void fillDialogue(Dialogue &dlg, size_t numEntries, size_t fanOut, size_t textLength, std::mt19937 &rng)
+  {
+    for (size_t i = 0; i < NUM_PARTICIPANTS; ++i)
+    {
+      dlg.addParticipant("Participant " + std::to_string(i));
+    }
+
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+      auto entry = dlg.addDialogueEntry(dlg.participant(i % NUM_PARTICIPANTS), makeText(rng, textLength));
+      entry->viewPosition = {double(i), double(i % 16)};
+    }
+
+    std::uniform_int_distribution<size_t> dst(0, numEntries - 1);
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+      for (size_t c = 0; c < fanOut; ++c)
+      {
+        dlg.addDialogueChoice(dlg.dialogueEntry(i), makeText(rng, textLength), dlg.dialogueEntry(dst(rng)));
+      }
+    }
+  }
+
+  std::unique_ptr<DialogueManager> makeManager(size_t numEntries, size_t fanOut, size_t textLength)
+  {
+    std::mt19937 rng(1234);
+    std::unique_ptr<DialogueManager> mgr(new DialogueManager);
+    fillDialogue(*mgr->addDialogue("Dialogue"), numEntries, fanOut, textLength, rng);
+    return mgr;
+  }
+
+  std::unique_ptr<DialogueManager> makeManager(const benchmark::State &state)
+  {
+    return makeManager(static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)), static_cast<size_t>(state.range(2)));
+  }
+
+  // A project of many mid sized dialogues, like a game's dialogue folder.
+  std::unique_ptr<DialogueManager> makeProject(size_t numDialogues)
+  {
+    std::mt19937 rng(1234);
+    std::unique_ptr<DialogueManager> mgr(new DialogueManager);
+    for (size_t i = 0; i < numDialogues; ++i)
+    {
+      fillDialogue(*mgr->addDialogue("Dialogue " + std::to_string(i)), 500, 2, 48, rng);
+    }
+    return mgr;
+  }
+
+  void graphArgs(benchmark::internal::Benchmark *bench)
+  {
+    bench->ArgNames({"entries", "fanout", "text"});
+    bench->Args({1000, 2, 32});
+    bench->Args({10000, 3, 64});
+    bench->Args({50000, 4, 128});
+  }
+} // namespace
+
+/////////////////////////////////////////////////////////////////////////////
+// Load and save
+
+static void BM_JsonSave(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  size_t bytes = 0;
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    std::ostringstream stream;
+    mgr->writeToStream(stream, false);
+    bytes += stream.tellp();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_JsonSave)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_JsonLoad(benchmark::State &state)
+{
+  std::string contents;
+  {
+    auto mgr = makeManager(state);
+    std::ostringstream stream;
+    mgr->writeToStream(stream, false);
+    contents = stream.str();
+  }
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    std::unique_ptr<DialogueManager> mgr(DialogueManager::readContents(contents));
+    benchmark::DoNotOptimize(mgr.get());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * contents.size()));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_JsonLoad)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+
+static void BM_BinaryLoad(benchmark::State &state)
+{
+  std::string contents;
+  {
+    auto mgr = makeManager(state);
+    std::ostringstream stream;
+    mgr->writeBinaryStream(stream);
+    contents = stream.str();
+  }
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    std::unique_ptr<DialogueManager> mgr(DialogueManager::readBinaryContents(contents.data(), contents.size()));
+    benchmark::DoNotOptimize(mgr.get());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * contents.size()));
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BinaryLoad)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+
+// Choices drawn from a handful of stock lines, as in real banks. Repeated
+// texts share their storage so only the unique ones allocate.
+static void BM_BinaryLoadStockChoices(benchmark::State &state)
+{
+  const char *stock[] = {"Goodbye.", "Tell me more.", "Why?", "I have to go.", "What do you mean?", "Yes.", "No.", "Maybe later."};
+  std::string contents;
+  {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<size_t> pick(0, std::size(stock) - 1);
+    DialogueManager mgr;
+    auto dlg = mgr.addDialogue("Dialogue");
+    fillDialogue(*dlg, static_cast<size_t>(state.range(0)), 0, 64, rng);
+    for (size_t i = 0; i < dlg->numDialogueEntries(); ++i)
+    {
+      for (size_t c = 0; c < 3; ++c)
+      {
+        dlg->addDialogueChoice(dlg->dialogueEntry(i), stock[pick(rng)], dlg->dialogueEntry((i + c + 1) % dlg->numDialogueEntries()));
+      }
+    }
+    std::ostringstream stream;
+    mgr.writeBinaryStream(stream);
+    contents = stream.str();
+  }
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    std::unique_ptr<DialogueManager> mgr(DialogueManager::readBinaryContents(contents.data(), contents.size()));
+    benchmark::DoNotOptimize(mgr.get());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BinaryLoadStockChoices)->ArgName("entries")->Arg(10000)->Unit(benchmark::kMillisecond);
+
+// Whole project to disk, as one file or sharded into one file per dialogue.
+static void BM_ProjectSave(benchmark::State &state)
+{
+  const bool sharded = state.range(0) != 0;
+  auto mgr = makeProject(200);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(sharded ? mgr->writeSharded("bench_project", false) : mgr->writeToFile("bench_project.json", false));
+  }
+  state.SetItemsProcessed(state.iterations() * mgr->numDialogues());
+}
+BENCHMARK(BM_ProjectSave)->ArgName("sharded")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Saving after editing a single entry, rewriting every shard or only the
+// modified one.
+static void BM_ProjectSaveAfterEdit(benchmark::State &state)
+{
+  const bool incremental = state.range(0) != 0;
+  auto mgr = makeProject(200);
+  mgr->writeSharded("bench_project", false);
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    auto entry = mgr->dialogue(i++ % mgr->numDialogues())->dialogueEntry(size_t(0));
+    entry->setViewPosition(entry->viewPosition.x + 1.0, entry->viewPosition.y);
+    benchmark::DoNotOptimize(incremental ? mgr->writeShardedChanges("bench_project", false) : mgr->writeSharded("bench_project", false));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProjectSaveAfterEdit)->ArgName("incremental")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ProjectLoad(benchmark::State &state)
+{
+  const bool sharded = state.range(0) != 0;
+  const auto numDialogues = makeProject(200)->numDialogues();
+  makeProject(200)->writeSharded("bench_project", false);
+  makeProject(200)->writeToFile("bench_project.json", false);
+  for (auto _ : state)
+  {
+    std::unique_ptr<DialogueManager> mgr(sharded ? DialogueManager::readSharded("bench_project") : DialogueManager::readFromFile("bench_project.json"));
+    benchmark::DoNotOptimize(mgr.get());
+  }
+  state.SetItemsProcessed(state.iterations() * numDialogues);
+}
+BENCHMARK(BM_ProjectLoad)->ArgName("sharded")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Opening a binary project and reaching one dialogue, reading every dialogue
+// up front or only the one asked for.
+static void BM_ProjectOpenOneDialogue(benchmark::State &state)
+{
+  const bool lazy = state.range(0) != 0;
+  makeProject(200)->writeBinary("bench_project.dlgb");
+  for (auto _ : state)
+  {
+    if (lazy)
+    {
+      auto library = DialogueLibrary::open("bench_project.dlgb");
+      benchmark::DoNotOptimize(library->dialogue(size_t(100)));
+    }
+    else
+    {
+      std::unique_ptr<DialogueManager> mgr(DialogueManager::readBinary("bench_project.dlgb"));
+      benchmark::DoNotOptimize(mgr->dialogue(size_t(100)));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProjectOpenOneDialogue)->ArgName("lazy")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Picking up a project file after one entry was edited elsewhere, replacing
+// the manager with a freshly read one or reloading it in place. Both parse
+// the whole file, the in place reload keeps every other node.
+static void BM_ProjectReloadAfterEdit(benchmark::State &state)
+{
+  const bool inPlace = state.range(0) != 0;
+  std::string contents;
+  {
+    auto mgr = makeProject(200);
+    mgr->dialogue(size_t(100))->dialogueEntry(size_t(0))->setEntry("Edited");
+    std::ostringstream stream;
+    mgr->writeToStream(stream, false);
+    contents = stream.str();
+  }
+
+  std::unique_ptr<DialogueManager> mgr(makeProject(200));
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    if (inPlace)
+    {
+      benchmark::DoNotOptimize(mgr->reloadContents(contents));
+    }
+    else
+    {
+      mgr.reset(DialogueManager::readContents(contents));
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * contents.size()));
+}
+BENCHMARK(BM_ProjectReloadAfterEdit)->ArgName("inplace")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+/////////////////////////////////////////////////////////////////////////////
+// Lookups
+
+static void BM_DialogueFromName(benchmark::State &state)
+{
+  DialogueManager mgr;
+  std::vector<std::string> names;
+  for (int64_t i = 0; i < state.range(0); ++i)
+  {
+    names.push_back("Dialogue " + std::to_string(i));
+    mgr.addDialogue(names.back());
+  }
+
+  size_t i = 0;
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(mgr.dialogue(names[i++ % names.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DialogueFromName)->Arg(16)->Arg(1024)->Arg(16384);
+
+static void BM_EntryFromId(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = mgr->dialogue(0);
+  const size_t numEntries = dlg->numDialogueEntries();
+
+  size_t i = 0;
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(dlg->dialogueEntry(ID{1 + i++ % numEntries}));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EntryFromId)->Apply(graphArgs);
+
+static void BM_ChoiceFromId(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = mgr->dialogue(0);
+  const size_t numChoices = dlg->numDialogueChoices();
+
+  size_t i = 0;
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(dlg->choice(ID{1 + i++ % numChoices}));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChoiceFromId)->Apply(graphArgs);
+
+static void BM_ChoiceFromGuid(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = mgr->dialogue(0);
+  std::vector<Guid> guids;
+  guids.reserve(dlg->numDialogueChoices());
+  for (const auto &choice : dlg->choices)
+  {
+    choice->assignGuid();
+    guids.push_back(choice->guid);
+  }
+
+  size_t i = 0;
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(mgr->choice(guids[i++ % guids.size()]));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChoiceFromGuid)->Apply(graphArgs);
+
+static void BM_ParticipantFromName(benchmark::State &state)
+{
+  auto mgr = makeManager(16, 1, 8);
+  auto dlg = mgr->dialogue(0);
+  const std::string name = "Participant 3";
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(dlg->participant(name));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParticipantFromName);
+
+/////////////////////////////////////////////////////////////////////////////
+// Editing
+
+static void BM_AddRemoveChurn(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = mgr->dialogue(0);
+  auto part = dlg->participant(size_t(0));
+  auto dst = dlg->dialogueEntry(size_t(0));
+  const std::string text(static_cast<size_t>(state.range(2)), 'x');
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    auto entry = dlg->addDialogueEntry(part, text);
+    auto choice = dlg->addDialogueChoice(entry, text, dst);
+    dlg->removeDialogueChoice(choice->id);
+    dlg->removeDialogueEntry(entry->id);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AddRemoveChurn)->Apply(graphArgs);
+
+// Deletes a random tenth of the entries one by one, like deleting a large
+// selection in the editor.
+static void BM_RemoveSelection(benchmark::State &state)
+{
+  std::mt19937 rng(1234);
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    auto mgr = makeManager(state);
+    auto dlg = mgr->dialogue(0);
+    std::vector<ID> selection;
+    for (size_t i = 0; i < dlg->numDialogueEntries(); i += 10)
+    {
+      selection.push_back(dlg->dialogueEntry(i)->id);
+    }
+    std::shuffle(selection.begin(), selection.end(), rng);
+    state.ResumeTiming();
+
+    for (auto id : selection)
+    {
+      dlg->removeDialogueEntry(id);
+    }
+
+    state.PauseTiming();
+    mgr.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * (state.range(0) / 10));
+}
+BENCHMARK(BM_RemoveSelection)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+
+// Undoing and redoing a drag of every entry, recorded as one transaction.
+static void BM_UndoDrag(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = mgr->dialogue(0);
+  auto history = DialogueHistory::attach(*mgr, 0);
+  history->begin();
+  for (auto entry : dlg->entries)
+  {
+    entry->setViewPosition(entry->viewPosition.x + 10.0, entry->viewPosition.y);
+  }
+  history->commit();
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    history->undo();
+    history->redo();
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * state.range(0));
+}
+BENCHMARK(BM_UndoDrag)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+// The same drag undone and redone by replaying saved positions through the
+// setters, as an undo stack kept outside the library does.
+static void BM_ReplayDrag(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = mgr->dialogue(0);
+  std::vector<DialogueEntry::Vector2> before;
+  for (auto entry : dlg->entries)
+  {
+    before.push_back(entry->viewPosition);
+  }
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < before.size(); ++i)
+    {
+      dlg->entries[i]->setViewPosition(before[i].x, before[i].y);
+    }
+    for (size_t i = 0; i < before.size(); ++i)
+    {
+      dlg->entries[i]->setViewPosition(before[i].x + 10.0, before[i].y);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 2 * state.range(0));
+}
+BENCHMARK(BM_ReplayDrag)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+/////////////////////////////////////////////////////////////////////////////
+// Traversal
+
+static void BM_RunnerWalk(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  DialogueStore store(*mgr->dialogue(0));
+  DialogueRunner runner(store, 0);
+
+  size_t step = 0;
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    const auto choices = runner.choices();
+    if (choices.size() == 0 || !runner.select(step++ % choices.size()) || runner.finished())
+    {
+      runner.reset(0);
+    }
+    benchmark::DoNotOptimize(runner.current());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RunnerWalk)->Apply(graphArgs);
+
+static void BM_PointerWalk(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto start = mgr->dialogue(0)->dialogueEntry(size_t(0));
+  auto entry = start;
+
+  size_t step = 0;
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    const auto &choices = entry->choices;
+    entry = choices.empty() ? start : choices[step++ % choices.size()]->dst;
+    if (!entry)
+    {
+      entry = start;
+    }
+    benchmark::DoNotOptimize(entry);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PointerWalk)->Apply(graphArgs);
+
+/////////////////////////////////////////////////////////////////////////////
+// Analysis
+
+static void BM_AnalyseDialogue(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  const auto &dlg = *mgr->dialogue(0);
+
+  for (auto _ : state)
+  {
+    DialogueAnalysis analysis(dlg, 0);
+    benchmark::DoNotOptimize(analysis.longestPath());
+  }
+  state.SetItemsProcessed(state.iterations() * dlg.entries.size());
+}
+BENCHMARK(BM_AnalyseDialogue)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+// A content check of a whole project on one thread or on all of them.
+static void BM_AnalyseProject(benchmark::State &state)
+{
+  auto mgr = makeProject(1000);
+  const auto maxThreads = static_cast<size_t>(state.range(0));
+
+  for (auto _ : state)
+  {
+    auto analyses = DialogueAnalysis::analyse(*mgr, nullptr, maxThreads);
+    benchmark::DoNotOptimize(analyses.data());
+  }
+  state.SetItemsProcessed(state.iterations() * mgr->numDialogues());
+}
+BENCHMARK(BM_AnalyseProject)->ArgName("threads")->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/////////////////////////////////////////////////////////////////////////////
+// Concurrent reads
+
+namespace
+{
+  // One project published for all reader threads.
+  const DialoguePublisher &projectPublisher()
+  {
+    static const auto publisher = []() {
+      auto publisher = std::make_unique<DialoguePublisher>();
+      publisher->publish(*makeProject(64));
+      return publisher;
+    }();
+    return *publisher;
+  }
+} // namespace
+
+// A server query: find a dialogue by name and take a step in it, through a
+// per thread reader that only checks the publisher's version.
+static void BM_SnapshotQuery(benchmark::State &state)
+{
+  const auto &publisher = projectPublisher();
+  DialoguePublisher::Reader reader(publisher);
+  const std::string name = "Dialogue " + std::to_string(state.thread_index() % 64);
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    auto store = reader.snapshot()->dialogue(name);
+    DialogueRunner runner(*store, 0);
+    runner.select(0);
+    benchmark::DoNotOptimize(runner.current());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SnapshotQuery)->ThreadRange(1, 4);
+
+// The same query taking a reference to the current snapshot every time,
+// which locks the publisher and shares its reference count across threads.
+static void BM_SnapshotQueryAcquire(benchmark::State &state)
+{
+  const auto &publisher = projectPublisher();
+  const std::string name = "Dialogue " + std::to_string(state.thread_index() % 64);
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    auto snapshot = publisher.current();
+    auto store = snapshot->dialogue(name);
+    DialogueRunner runner(*store, 0);
+    runner.select(0);
+    benchmark::DoNotOptimize(runner.current());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SnapshotQueryAcquire)->ThreadRange(1, 4);
+
+/////////////////////////////////////////////////////////////////////////////
+// Guid
+
+static void BM_GuidConstruct(benchmark::State &state)
+{
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    Guid guid;
+    benchmark::DoNotOptimize(guid);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GuidConstruct);
+
+static void BM_GuidGenerateBatch(benchmark::State &state)
+{
+  const auto version = state.range(0) == 7 ? GuidVersion::V7 : GuidVersion::V4;
+  std::vector<Guid> guids(1024, Guid(Guid::GuidT{}));
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    Guid::generate(guids.data(), guids.size(), version);
+    benchmark::DoNotOptimize(guids.data());
+  }
+  state.SetItemsProcessed(state.iterations() * guids.size());
+}
+BENCHMARK(BM_GuidGenerateBatch)->ArgName("version")->Arg(4)->Arg(7)->ThreadRange(1, 4);
+
+// Texts of 1024 random GUIDs back to back, STRING_LENGTH chars each.
+static std::string guidTexts(const std::vector<Guid> &guids)
+{
+  std::string texts(guids.size() * Guid::STRING_LENGTH, '\0');
+  for (size_t i = 0; i < guids.size(); ++i)
+  {
+    guids[i].format(&texts[i * Guid::STRING_LENGTH]);
+  }
+  return texts;
+}
+
+static void BM_GuidParse(benchmark::State &state)
+{
+  const auto guids = Guid::generate(1024);
+  const auto texts = guidTexts(guids);
+  std::vector<Guid> parsed(guids.size(), Guid(Guid::GuidT{}));
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < parsed.size(); ++i)
+    {
+      Guid::parse(std::string_view(texts).substr(i * Guid::STRING_LENGTH, Guid::STRING_LENGTH), parsed[i]);
+    }
+    benchmark::DoNotOptimize(parsed.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * parsed.size());
+  state.SetBytesProcessed(state.iterations() * texts.size());
+}
+BENCHMARK(BM_GuidParse);
+
+static void BM_GuidFormat(benchmark::State &state)
+{
+  const auto guids = Guid::generate(1024);
+  std::string texts(guids.size() * Guid::STRING_LENGTH, '\0');
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    char *out = &texts[0];
+    for (const auto &guid : guids)
+    {
+      out = guid.format(out);
+    }
+    benchmark::DoNotOptimize(texts.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * guids.size());
+  state.SetBytesProcessed(state.iterations() * texts.size());
+}
+BENCHMARK(BM_GuidFormat);
+
+static void BM_GuidToString(benchmark::State &state)
+{
+  const Guid guid = Guid::generate();
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(guid.toString());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GuidToString);
+
+static void BM_GuidHashLookup(benchmark::State &state)
+{
+  const auto version = state.range(0) == 7 ? GuidVersion::V7 : GuidVersion::V4;
+  const auto guids = Guid::generate(static_cast<size_t>(state.range(1)), version);
+  std::unordered_map<Guid, size_t> index;
+  for (size_t i = 0; i < guids.size(); ++i)
+  {
+    index.emplace(guids[i], i);
+  }
+
+  AllocationCounter counter(state);
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(index.find(guids[i]));
+    i = (i + 7919) % guids.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GuidHashLookup)->ArgNames({"version", "guids"})->Args({4, 10000})->Args({7, 10000})->Args({7, 1000000});
+
+/////////////////////////////////////////////////////////////////////////////
+// C API
+
+static void BM_CApiEntryPerCall(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = reinterpret_cast<HDialogue *>(mgr->dialogue(0));
+  const _size_t numEntries = numDialogueEntries(dlg);
+  std::vector<char> buffer(1024);
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    for (_size_t i = 0; i < numEntries; ++i)
+    {
+      auto entry = dialogueEntryFromIndex(dlg, i);
+      dialogueEntryContent(entry, buffer.data(), static_cast<_size_t>(buffer.size() - 1));
+      benchmark::DoNotOptimize(dialogueEntryPositionX(entry));
+      benchmark::DoNotOptimize(dialogueEntryPositionY(entry));
+      benchmark::DoNotOptimize(dialogueEntryLReaction(entry));
+      benchmark::DoNotOptimize(dialogueEntryRReaction(entry));
+      benchmark::DoNotOptimize(dialogueEntryActiveParticipant(entry));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * numEntries);
+}
+BENCHMARK(BM_CApiEntryPerCall)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+static void BM_CApiEntriesBulk(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = reinterpret_cast<HDialogue *>(mgr->dialogue(0));
+  std::vector<DialogueEntryData> data(numDialogueEntries(dlg));
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(dialogueEntriesData(dlg, data.data(), static_cast<_size_t>(data.size())));
+  }
+  state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_CApiEntriesBulk)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+// Dragging every entry by one step with the editor's undo log attached, one
+// setter call per entry inside a transaction or a single batch call.
+static void BM_CApiMovePerCall(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = reinterpret_cast<HDialogue *>(mgr->dialogue(0));
+  auto history = newDialogueHistory(reinterpret_cast<HDialogueManager *>(mgr.get()), 1 << 20);
+  const _size_t numEntries = numDialogueEntries(dlg);
+
+  AllocationCounter counter(state);
+  for (auto _ : state)
+  {
+    dialogueHistoryBegin(history);
+    for (_size_t i = 0; i < numEntries; ++i)
+    {
+      auto entry = dialogueEntryFromIndex(dlg, i);
+      setDialogueEntryPosition(entry, dialogueEntryPositionX(entry) + 1.0, dialogueEntryPositionY(entry));
+    }
+    dialogueHistoryCommit(history);
+  }
+  state.SetItemsProcessed(state.iterations() * numEntries);
+  freeDialogueHistory(history);
+}
+BENCHMARK(BM_CApiMovePerCall)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+static void BM_CApiMoveBatch(benchmark::State &state)
+{
+  auto mgr = makeManager(state);
+  auto dlg = reinterpret_cast<HDialogue *>(mgr->dialogue(0));
+  auto history = newDialogueHistory(reinterpret_cast<HDialogueManager *>(mgr.get()), 1 << 20);
+  std::vector<DialogueEntryData> data(numDialogueEntries(dlg));
+  dialogueEntriesData(dlg, data.data(), static_cast<_size_t>(data.size()));
+  // Alternates between a step right and back, as the editor sends a drag.
+  std::vector<DialogueEntryMove> moves[2];
+  for (const auto &entry : data)
+  {
+    moves[0].push_back({entry.id, entry.positionX + 1.0, entry.positionY});
+    moves[1].push_back({entry.id, entry.positionX, entry.positionY});
+  }
+
+  AllocationCounter counter(state);
+  size_t step = 0;
+  for (auto _ : state)
+  {
+    const auto &stepMoves = moves[step++ & 1];
+    benchmark::DoNotOptimize(moveDialogueEntries(dlg, stepMoves.data(), static_cast<_size_t>(stepMoves.size())));
+  }
+  state.SetItemsProcessed(state.iterations() * data.size());
+  freeDialogueHistory(history);
+}
+BENCHMARK(BM_CApiMoveBatch)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
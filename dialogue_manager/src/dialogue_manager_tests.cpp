@@ -1,7 +1,16 @@
 #include "dialogue_manager/dialogue_manager_api.h"
+#include "dialogue_manager/src/dialogue_binary.hpp"
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
 /////////////////////////////////////////////////////////////////////////////
 // DialogueManager Tests
 
@@ -65,6 +74,61 @@ TEST_F(DialogueManagerTest, RemovedDialogueNoLongerRetrieved)
   auto retDlg = dialogueFromName(dlgMgr, dlgName.c_str(), dlgName.length());
 
   EXPECT_EQ(retDlg, nullptr);
+  freeDialogue(newDlg);
+}
+
+TEST_F(DialogueManagerTest, RenamedDialogueRetrievedByNewName)
+{
+  auto newDlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  std::string newName = "A renamed dialogue";
+  setDialogueName(newDlg, newName.data(), newName.length());
+
+  EXPECT_EQ(dialogueFromName(dlgMgr, dlgName.c_str(), dlgName.length()), nullptr);
+  EXPECT_EQ(dialogueFromName(dlgMgr, newName.c_str(), newName.length()), newDlg);
+  EXPECT_NE(addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length()), nullptr);
+}
+
+TEST_F(DialogueManagerTest, RenameToExistingDialogueNameIsRejected)
+{
+  std::string otherName = "Another dialogue";
+  auto newDlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto otherDlg = addNewDialogue(dlgMgr, otherName.c_str(), otherName.length());
+  setDialogueName(otherDlg, dlgName.data(), dlgName.length());
+
+  EXPECT_EQ(dialogueFromName(dlgMgr, dlgName.c_str(), dlgName.length()), newDlg);
+  EXPECT_EQ(dialogueFromName(dlgMgr, otherName.c_str(), otherName.length()), otherDlg);
+}
+
+TEST_F(DialogueManagerTest, ChoiceFromGuidFollowsAssignmentAndRemoval)
+{
+  std::string text = "Hello";
+  auto dlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto part = addParticipant(dlg, text.c_str(), text.length());
+  auto entry = addDialogueEntry(dlg, part, text.c_str(), text.length());
+  auto choice1 = addDialogueChoice(dlg, entry, text.c_str(), text.length());
+  auto choice2 = addDialogueChoice(dlg, entry, text.c_str(), text.length());
+
+  // Only assigned GUIDs are indexed.
+  EXPECT_EQ(choiceFromGuid(dlgMgr, dialogueChoiceGuid(choice1)), nullptr);
+  assignDialogueChoiceGuid(choice1);
+  assignDialogueChoiceGuid(choice2);
+  EXPECT_EQ(choiceFromGuid(dlgMgr, dialogueChoiceGuid(choice1)), choice1);
+  EXPECT_EQ(choiceFromGuid(dlgMgr, dialogueChoiceGuid(choice2)), choice2);
+
+  std::string guidStr(36, '\0');
+  guidToString(dialogueChoiceGuid(choice2), &guidStr[0], guidStr.size());
+  auto parsed = guidFromString(guidStr.c_str(), guidStr.size());
+  EXPECT_EQ(choiceFromGuid(dlgMgr, parsed), choice2);
+
+  removeDialogueChoice(dlg, choice2);
+  EXPECT_EQ(choiceFromGuid(dlgMgr, parsed), nullptr);
+  freeGuid(parsed);
+
+  // Dialogues take their choices' GUIDs along when removed and re-added.
+  removeDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  EXPECT_EQ(choiceFromGuid(dlgMgr, dialogueChoiceGuid(choice1)), nullptr);
+  addExistingDialogue(dlgMgr, dlg);
+  EXPECT_EQ(choiceFromGuid(dlgMgr, dialogueChoiceGuid(choice1)), choice1);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -164,6 +228,24 @@ TEST_F(DialogueTest, RemoveParticipantDecrementsNumParticipants)
   EXPECT_EQ(numParticipants(dlg), 3);
 }
 
+TEST_F(DialogueTest, RemoveMissingParticipantLeavesParticipants)
+{
+  addParticipant(dlg, "1", 1);
+  removeParticipant(dlg, "2", 1);
+  EXPECT_EQ(numParticipants(dlg), 1);
+  EXPECT_NE(participantFromName(dlg, "1", 1), nullptr);
+}
+
+TEST_F(DialogueTest, RenamedParticipantRetrievedByNewName)
+{
+  auto bob = addParticipant(dlg, "Bob", 3);
+  std::string newName = "Sue";
+  setParticipantName(bob, newName.data(), newName.length());
+
+  EXPECT_EQ(participantFromName(dlg, "Bob", 3), nullptr);
+  EXPECT_EQ(participantFromName(dlg, "Sue", 3), bob);
+}
+
 TEST_F(DialogueTestWithParticipants, AddDialogueEntryIncrementsNumEntries)
 {
   addDialogueEntry(dlg, part1, "1", 1);
@@ -238,6 +320,59 @@ TEST_F(DialogueTestWithParticipants, RemoveChoiceByPointerDecrementsNumChoices)
   EXPECT_EQ(numDialogueChoices(dlg), 2);
 }
 
+TEST_F(DialogueTestWithParticipants, RemovedChoiceIsUnlinkedFromItsEntry)
+{
+  auto entry = addDialogueEntry(dlg, part1, "1", 1);
+  auto choice1 = addDialogueChoice(dlg, entry, "1", 1);
+  auto choice2 = addDialogueChoice(dlg, entry, "2", 1);
+  auto choice3 = addDialogueChoice(dlg, entry, "3", 1);
+
+  removeDialogueChoice(dlg, choice1);
+  ASSERT_EQ(dialogueEntryNumDialogueChoices(entry), 2);
+  EXPECT_EQ(dialogueEntryDialogueChoiceFromIndex(entry, 0), choice2);
+  EXPECT_EQ(dialogueEntryDialogueChoiceFromIndex(entry, 1), choice3);
+  EXPECT_EQ(dialogueChoiceFromIndex(dlg, 0), choice3);
+}
+
+TEST_F(DialogueTestWithParticipants, RemovedEntryTakesItsChoicesAndUnlinksIncomingOnes)
+{
+  auto entry1 = addDialogueEntry(dlg, part1, "1", 1);
+  auto entry2 = addDialogueEntry(dlg, part2, "2", 1);
+  auto entry3 = addDialogueEntry(dlg, part3, "3", 1);
+  auto incoming = addDialogueChoiceWithDest(dlg, entry1, "to 2", 4, entry2);
+  auto kept = addDialogueChoiceWithDest(dlg, entry1, "to 3", 4, entry3);
+  addDialogueChoiceWithDest(dlg, entry2, "to 3", 4, entry3);
+  addDialogueChoiceWithDest(dlg, entry2, "loop", 4, entry2);
+  auto retargeted = addDialogueChoiceWithDest(dlg, entry3, "to 1", 4, entry1);
+  setDialogueChoiceDstEntry(retargeted, entry2);
+  setDialogueChoiceDstEntry(retargeted, entry1);
+
+  removeDialogueEntryPtr(dlg, entry2);
+  EXPECT_EQ(numDialogueEntries(dlg), 2);
+  EXPECT_EQ(dialogueEntryFromIndex(dlg, 1), entry3);
+  ASSERT_EQ(numDialogueChoices(dlg), 3);
+  EXPECT_EQ(dialogueChoiceDstEntry(incoming), nullptr);
+  EXPECT_EQ(dialogueChoiceDstEntry(kept), entry3);
+  EXPECT_EQ(dialogueChoiceDstEntry(retargeted), entry1);
+  ASSERT_EQ(dialogueEntryNumDialogueChoices(entry1), 2);
+  EXPECT_EQ(dialogueEntryDialogueChoiceFromIndex(entry1, 0), incoming);
+  EXPECT_EQ(dialogueEntryDialogueChoiceFromIndex(entry1, 1), kept);
+
+  // Saving must not reach the removed entry through any choice, and each
+  // entry keeps its choice order.
+  std::string dest = "removed_entry.json";
+  ASSERT_TRUE(writeDialogues(dlgMgr, dest.c_str(), dest.length()));
+  auto mgr = readDialoguesFromFile(dest.c_str(), dest.length());
+  ASSERT_NE(mgr, nullptr);
+  auto loaded = dialogueFromIndex(mgr, 0);
+  ASSERT_EQ(numDialogueChoices(loaded), 3);
+  auto loadedEntry1 = dialogueEntryFromIndex(loaded, 0);
+  ASSERT_EQ(dialogueEntryNumDialogueChoices(loadedEntry1), 2);
+  EXPECT_EQ(dialogueChoiceDstEntry(dialogueEntryDialogueChoiceFromIndex(loadedEntry1, 0)), nullptr);
+  EXPECT_EQ(dialogueChoiceDstEntry(dialogueEntryDialogueChoiceFromIndex(loadedEntry1, 1)), dialogueEntryFromIndex(loaded, 1));
+  freeDialogueManager(mgr);
+}
+
 TEST_F(DialogueTestWithParticipants, CanSetAndRetrieveReactionsOfEntries)
 {
   auto entry = addDialogueEntry(dlg, part1, "1", 1);
@@ -386,6 +521,7 @@ TEST(MultipleDialogues, fileIO)
     auto guid = dialogueChoiceGuid(choice1);
     guidToString(guid, &guidVal2[0], guidVal2.size());
     EXPECT_EQ(guidVal, guidVal2);
+    EXPECT_EQ(choiceFromGuid(mgr, guid), choice1);
 
     auto choice2 = dialogueChoiceFromIndex(dlg, 1);
     dialogueChoiceContent(choice2, strBuf, bufSize);
@@ -492,6 +628,1132 @@ TEST(MultipleDialogues, fileIO)
     EXPECT_EQ(dialogueChoiceDstEntry(choice2), entry3);
     EXPECT_EQ(dialogueChoiceDstEntry(choice3), entry1);
   }
+
+  freeDialogueManager(mgr);
+  freeDialogueManager(dlgMgr);
+}
+
+TEST(MultipleDialogues, readContentsParsesKeysInAnyOrder)
+{
+  std::string contents = R"({
+    "dialogues": [{
+      "choices": [{"choice": "Bye", "dst": -1, "id": 1, "src": 2, "guid": [1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16]}],
+      "entries": [{"activeParticipant": 1, "entry": "Hi", "id": 2, "lReaction": 1, "rReaction": 2,
+                   "position": {"x": 1.5, "y": -2}, "unknown": {"nested": [1, 2]}}],
+      "name": "Dialogue",
+      "participants": [{"id": 1, "name": "Bob"}]
+    }],
+    "eReactionVersion": 1,
+    "version": 2
+  })";
+
+  auto mgr = readDialoguesFromContents(contents.c_str(), contents.length());
+  ASSERT_NE(mgr, nullptr);
+  ASSERT_EQ(numDialogues(mgr), 1);
+
+  auto dlg = dialogueFromName(mgr, "Dialogue", 8);
+  ASSERT_NE(dlg, nullptr);
+  ASSERT_EQ(numDialogueEntries(dlg), 1);
+  auto entry = dialogueEntryFromIndex(dlg, 0);
+  EXPECT_EQ(dialogueEntryActiveParticipant(entry), participantFromName(dlg, "Bob", 3));
+  EXPECT_EQ(dialogueEntryPositionX(entry), 1.5);
+  EXPECT_EQ(dialogueEntryPositionY(entry), -2);
+  EXPECT_EQ(dialogueEntryLReaction(entry), 1);
+  EXPECT_EQ(dialogueEntryRReaction(entry), 2);
+
+  ASSERT_EQ(numDialogueChoices(dlg), 1);
+  auto choice = dialogueChoiceFromIndex(dlg, 0);
+  EXPECT_EQ(dialogueChoiceSrcEntry(choice), entry);
+  EXPECT_EQ(dialogueChoiceDstEntry(choice), nullptr);
+  // Guids were only introduced in version 3.
+  EXPECT_FALSE(dialogueChoiceGuidAssigned(choice));
+
+  freeDialogueManager(mgr);
+}
+
+TEST(MultipleDialogues, readContentsReturnsNullOnMalformedJson)
+{
+  std::string contents = R"({"dialogues": [{"name": "Dialogue", )";
+  EXPECT_EQ(readDialoguesFromContents(contents.c_str(), contents.length()), nullptr);
+}
+
+TEST(MultipleDialogues, compactFileIOEscapesStrings)
+{
+  auto dlgMgr = newDialogueManager();
+  std::string dlgName = "A \"quoted\"\\ name";
+  std::string entryStr = "Line 1\nLine 2\t\x01";
+
+  auto dlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto part = addParticipant(dlg, "Bob", 3);
+  auto entry = addDialogueEntry(dlg, part, entryStr.c_str(), entryStr.length());
+  setDialogueEntryPosition(entry, 0.1, -3);
+
+  std::string dest = "test_compact.json";
+  ASSERT_TRUE(writeDialoguesCompact(dlgMgr, dest.c_str(), dest.length()));
+  freeDialogueManager(dlgMgr);
+
+  auto mgr = readDialoguesFromFile(dest.c_str(), dest.length());
+  ASSERT_NE(mgr, nullptr);
+  auto readDlg = dialogueFromName(mgr, dlgName.c_str(), dlgName.length());
+  ASSERT_NE(readDlg, nullptr);
+  ASSERT_EQ(numDialogueEntries(readDlg), 1);
+
+  constexpr size_t bufSize = 1024;
+  char strBuf[bufSize];
+  auto readEntry = dialogueEntryFromIndex(readDlg, 0);
+  dialogueEntryContent(readEntry, strBuf, bufSize);
+  EXPECT_STREQ(strBuf, entryStr.c_str());
+  EXPECT_EQ(dialogueEntryPositionX(readEntry), 0.1);
+  EXPECT_EQ(dialogueEntryPositionY(readEntry), -3);
+
+  freeDialogueManager(mgr);
+}
+
+// Positions are written as the shortest text that reads back to the same
+// double, std::to_chars with ".0" added to integral values. That differs
+// from nlohmann's dump for some values, 1e+05 where it writes 100000.0.
+TEST(MultipleDialogues, fileIOKeepsPositionsExact)
+{
+  const std::vector<std::pair<double, const char *>> values = {
+    {0.1, "0.1"},
+    {-3.0, "-3.0"},
+    {100000.0, "1e+05"},
+    {1e15, "1e+15"},
+    {123456789.125, "123456789.125"},
+    {1e-7, "1e-07"},
+    {5e-324, "5e-324"},
+    {1.7976931348623157e308, "1.7976931348623157e+308"},
+  };
+
+  auto dlgMgr = newDialogueManager();
+  auto dlg = addNewDialogue(dlgMgr, "Numbers", 7);
+  auto part = addParticipant(dlg, "Bob", 3);
+  for (const auto &value : values)
+  {
+    auto entry = addDialogueEntry(dlg, part, "", 0);
+    setDialogueEntryPosition(entry, value.first, 0.0);
+  }
+
+  std::string dest = "test_numbers.json";
+  ASSERT_TRUE(writeDialoguesCompact(dlgMgr, dest.c_str(), dest.length()));
+  freeDialogueManager(dlgMgr);
+
+  std::ifstream file(dest, std::ios::binary);
+  const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  file.close();
+  for (const auto &value : values)
+  {
+    EXPECT_NE(contents.find(std::string("\"x\":") + value.second + ","), std::string::npos) << value.second;
+  }
+
+  auto mgr = readDialoguesFromFile(dest.c_str(), dest.length());
+  ASSERT_NE(mgr, nullptr);
+  auto readDlg = dialogueFromIndex(mgr, 0);
+  ASSERT_EQ(numDialogueEntries(readDlg), values.size());
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    EXPECT_EQ(dialogueEntryPositionX(dialogueEntryFromIndex(readDlg, i)), values[i].first);
+  }
+
+  freeDialogueManager(mgr);
+  std::filesystem::remove(dest);
+}
+
+TEST(MultipleDialogues, binaryFileIO)
+{
+  auto dlgMgr = newDialogueManager();
+  std::string dlgName = "Dialogue 1";
+  std::string partName = "Participant 1";
+  std::string entry1Str = "Entry 1";
+  std::string entry2Str = "Entry 2";
+  std::string choiceStr = "Goodbye.";
+
+  auto dlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto part = addParticipant(dlg, partName.c_str(), partName.length());
+  auto entry1 = addDialogueEntry(dlg, part, entry1Str.c_str(), entry1Str.length());
+  setDialogueEntryPosition(entry1, 3, 42);
+  setDialogueEntryLReaction(entry1, 2);
+  setDialogueEntryRReaction(entry1, 4);
+  auto entry2 = addDialogueEntry(dlg, part, entry2Str.c_str(), entry2Str.length());
+  auto choice1 = addDialogueChoiceWithDest(dlg, entry1, choiceStr.c_str(), choiceStr.length(), entry2);
+  assignDialogueChoiceGuid(choice1);
+  addDialogueChoice(dlg, entry2, choiceStr.c_str(), choiceStr.length());
+
+  std::string dest = "test.dlgb";
+  ASSERT_TRUE(writeDialoguesBinary(dlgMgr, dest.c_str(), dest.length()));
+
+  auto mgr = readDialoguesBinaryFromFile(dest.c_str(), dest.length());
+  ASSERT_NE(mgr, nullptr);
+  ASSERT_EQ(numDialogues(mgr), 1);
+
+  constexpr size_t bufSize = 1024;
+  char strBuf[bufSize];
+
+  auto readDlg = dialogueFromIndex(mgr, 0);
+  dialogueName(readDlg, strBuf, bufSize);
+  EXPECT_STREQ(strBuf, dlgName.c_str());
+  ASSERT_EQ(numParticipants(readDlg), 1);
+  auto readPart = participantFromIndex(readDlg, 0);
+  participantName(readPart, strBuf, bufSize);
+  EXPECT_STREQ(strBuf, partName.c_str());
+
+  ASSERT_EQ(numDialogueEntries(readDlg), 2);
+  auto readEntry1 = dialogueEntryFromIndex(readDlg, 0);
+  auto readEntry2 = dialogueEntryFromIndex(readDlg, 1);
+  dialogueEntryContent(readEntry1, strBuf, bufSize);
+  EXPECT_STREQ(strBuf, entry1Str.c_str());
+  EXPECT_EQ(dialogueEntryActiveParticipant(readEntry1), readPart);
+  EXPECT_EQ(dialogueEntryPositionX(readEntry1), 3);
+  EXPECT_EQ(dialogueEntryPositionY(readEntry1), 42);
+  EXPECT_EQ(dialogueEntryLReaction(readEntry1), 2);
+  EXPECT_EQ(dialogueEntryRReaction(readEntry1), 4);
+
+  ASSERT_EQ(numDialogueChoices(readDlg), 2);
+  auto readChoice1 = dialogueChoiceFromIndex(readDlg, 0);
+  auto readChoice2 = dialogueChoiceFromIndex(readDlg, 1);
+  dialogueChoiceContent(readChoice2, strBuf, bufSize);
+  EXPECT_STREQ(strBuf, choiceStr.c_str());
+  EXPECT_EQ(dialogueChoiceSrcEntry(readChoice1), readEntry1);
+  EXPECT_EQ(dialogueChoiceDstEntry(readChoice1), readEntry2);
+  EXPECT_EQ(dialogueChoiceDstEntry(readChoice2), nullptr);
+  EXPECT_EQ(dialogueEntryDialogueChoiceFromIndex(readEntry2, 0), readChoice2);
+  EXPECT_TRUE(dialogueChoiceGuidAssigned(readChoice1));
+  EXPECT_FALSE(dialogueChoiceGuidAssigned(readChoice2));
+  EXPECT_TRUE(guidsAreEqual(dialogueChoiceGuid(choice1), dialogueChoiceGuid(readChoice1)));
+  EXPECT_EQ(choiceFromGuid(mgr, dialogueChoiceGuid(choice1)), readChoice1);
+  EXPECT_EQ(choiceFromGuid(mgr, dialogueChoiceGuid(readChoice2)), nullptr);
+
+  // Choice refs listing another entry's choice, or one choice twice, are
+  // rejected rather than leaving the entries' choice lists out of sync.
+  std::ifstream in(dest, std::ios::binary);
+  std::string image((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  in.close();
+  floofy::binary::Header header;
+  std::memcpy(&header, image.data(), sizeof(header));
+  ASSERT_EQ(header.numChoiceRefs, 2);
+  const auto writeRefs = [&](uint32_t first, uint32_t second) {
+    std::string corrupt = image;
+    std::memcpy(&corrupt[header.choiceRefsOffset], &first, sizeof(first));
+    std::memcpy(&corrupt[header.choiceRefsOffset + sizeof(first)], &second, sizeof(second));
+    std::ofstream(dest, std::ios::binary | std::ios::trunc) << corrupt;
+  };
+  writeRefs(1, 1);
+  EXPECT_EQ(readDialoguesBinaryFromFile(dest.c_str(), dest.length()), nullptr);
+  writeRefs(1, 0);
+  EXPECT_EQ(readDialoguesBinaryFromFile(dest.c_str(), dest.length()), nullptr);
+  writeRefs(0, 1);
+  auto restored = readDialoguesBinaryFromFile(dest.c_str(), dest.length());
+  ASSERT_NE(restored, nullptr);
+  freeDialogueManager(restored);
+
+  freeDialogueManager(mgr);
+  freeDialogueManager(dlgMgr);
+}
+
+TEST(MultipleDialogues, shardedFileIO)
+{
+  namespace fs = std::filesystem;
+  const std::string dir = "test_shards";
+  fs::remove_all(dir);
+
+  auto dlgMgr = newDialogueManager();
+  std::string partName = "Participant";
+  std::string entryStr = "Entry";
+  std::vector<std::string> names = {"First", "Second dialogue", "Third/../dialogue"};
+  std::vector<HDialogueChoice *> choices;
+  for (const auto &name : names)
+  {
+    auto dlg = addNewDialogue(dlgMgr, name.c_str(), name.length());
+    auto part = addParticipant(dlg, partName.c_str(), partName.length());
+    auto entry1 = addDialogueEntry(dlg, part, entryStr.c_str(), entryStr.length());
+    auto entry2 = addDialogueEntry(dlg, part, name.c_str(), name.length());
+    choices.push_back(addDialogueChoiceWithDest(dlg, entry1, name.c_str(), name.length(), entry2));
+    assignDialogueChoiceGuid(choices.back());
+  }
+
+  ASSERT_TRUE(writeDialoguesSharded(dlgMgr, dir.c_str(), dir.length()));
+  size_t numFiles = std::distance(fs::directory_iterator(dir), fs::directory_iterator());
+  EXPECT_EQ(numFiles, names.size() + 1);
+
+  auto mgr = readDialoguesSharded(dir.c_str(), dir.length());
+  ASSERT_NE(mgr, nullptr);
+  ASSERT_EQ(numDialogues(mgr), names.size());
+
+  constexpr size_t bufSize = 1024;
+  char strBuf[bufSize];
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    auto dlg = dialogueFromIndex(mgr, i);
+    dialogueName(dlg, strBuf, bufSize);
+    EXPECT_STREQ(strBuf, names[i].c_str());
+    ASSERT_EQ(numDialogueEntries(dlg), 2);
+    dialogueEntryContent(dialogueEntryFromIndex(dlg, 1), strBuf, bufSize);
+    EXPECT_STREQ(strBuf, names[i].c_str());
+    ASSERT_EQ(numDialogueChoices(dlg), 1);
+    EXPECT_EQ(choiceFromGuid(mgr, dialogueChoiceGuid(choices[i])), dialogueChoiceFromIndex(dlg, 0));
+  }
+  freeDialogueManager(mgr);
+
+  // Shards of removed and renamed dialogues do not outlive the next save.
+  std::string renamed = "Renamed";
+  setDialogueName(dialogueFromIndex(dlgMgr, 1), renamed.data(), renamed.length());
+  auto first = dialogueFromName(dlgMgr, names[0].c_str(), names[0].length());
+  removeDialogue(dlgMgr, names[0].c_str(), names[0].length());
+  freeDialogue(first);
+  ASSERT_TRUE(writeDialoguesSharded(dlgMgr, dir.c_str(), dir.length()));
+  numFiles = std::distance(fs::directory_iterator(dir), fs::directory_iterator());
+  EXPECT_EQ(numFiles, 3);
+
+  mgr = readDialoguesSharded(dir.c_str(), dir.length());
+  ASSERT_NE(mgr, nullptr);
+  ASSERT_EQ(numDialogues(mgr), 2);
+  dialogueName(dialogueFromIndex(mgr, 0), strBuf, bufSize);
+  EXPECT_STREQ(strBuf, renamed.c_str());
+  dialogueName(dialogueFromIndex(mgr, 1), strBuf, bufSize);
+  EXPECT_STREQ(strBuf, names[2].c_str());
+
+  freeDialogueManager(mgr);
+  freeDialogueManager(dlgMgr);
+  fs::remove_all(dir);
+}
+
+TEST(MultipleDialogues, shardedIncrementalSave)
+{
+  namespace fs = std::filesystem;
+  const std::string dir = "test_incremental_shards";
+  fs::remove_all(dir);
+
+  auto dlgMgr = newDialogueManager();
+  std::string partName = "Participant";
+  std::vector<std::string> names = {"First", "Second", "Third"};
+  std::vector<HDialogueEntry *> entries;
+  std::vector<HDialogueChoice *> choices;
+  for (const auto &name : names)
+  {
+    auto dlg = addNewDialogue(dlgMgr, name.c_str(), name.length());
+    auto part = addParticipant(dlg, partName.c_str(), partName.length());
+    entries.push_back(addDialogueEntry(dlg, part, name.c_str(), name.length()));
+    choices.push_back(addDialogueChoice(dlg, entries.back(), name.c_str(), name.length()));
+  }
+
+  EXPECT_TRUE(dialogueManagerModified(dlgMgr));
+  ASSERT_TRUE(writeDialoguesShardedChanges(dlgMgr, dir.c_str(), dir.length()));
+  EXPECT_FALSE(dialogueManagerModified(dlgMgr));
+
+  // Files left on disk are whatever the last save wrote.
+  auto savedNames = [&dir]() {
+    std::vector<std::string> saved;
+    for (const auto &file : fs::directory_iterator(dir))
+    {
+      const auto path = file.path().string();
+      if (file.path().filename() == "manifest.json")
+      {
+        saved.push_back("manifest");
+        continue;
+      }
+      auto shard = readDialoguesFromFile(path.c_str(), path.length());
+      char name[64];
+      dialogueName(dialogueFromIndex(shard, 0), name, sizeof(name));
+      saved.push_back(name);
+      freeDialogueManager(shard);
+    }
+    std::sort(saved.begin(), saved.end());
+    return saved;
+  };
+  auto clearDirectory = [&dir]() {
+    for (const auto &file : fs::directory_iterator(dir))
+    {
+      fs::remove(file.path());
+    }
+  };
+  EXPECT_EQ(savedNames(), (std::vector<std::string>{"First", "Second", "Third", "manifest"}));
+
+  clearDirectory();
+  ASSERT_TRUE(writeDialoguesShardedChanges(dlgMgr, dir.c_str(), dir.length()));
+  EXPECT_TRUE(savedNames().empty());
+
+  std::string content = "Changed";
+  setDialogueEntryPosition(entries[0], 1.0, 2.0);
+  setDialogueChoiceContent(choices[2], content.data(), content.length());
+  EXPECT_TRUE(dialogueManagerModified(dlgMgr));
+  ASSERT_TRUE(writeDialoguesShardedChanges(dlgMgr, dir.c_str(), dir.length()));
+  EXPECT_FALSE(dialogueManagerModified(dlgMgr));
+  EXPECT_EQ(savedNames(), (std::vector<std::string>{"First", "Third", "manifest"}));
+
+  // Removing a dialogue only rewrites the manifest.
+  clearDirectory();
+  auto second = dialogueFromName(dlgMgr, names[1].c_str(), names[1].length());
+  removeDialogue(dlgMgr, names[1].c_str(), names[1].length());
+  freeDialogue(second);
+  EXPECT_TRUE(dialogueManagerModified(dlgMgr));
+  ASSERT_TRUE(writeDialoguesShardedChanges(dlgMgr, dir.c_str(), dir.length()));
+  EXPECT_EQ(savedNames(), (std::vector<std::string>{"manifest"}));
+
+  // Loading records the loaded revisions too.
+  ASSERT_TRUE(writeDialoguesSharded(dlgMgr, dir.c_str(), dir.length()));
+  auto mgr = readDialoguesSharded(dir.c_str(), dir.length());
+  ASSERT_NE(mgr, nullptr);
+  EXPECT_FALSE(dialogueManagerModified(mgr));
+  clearDirectory();
+  setDialogueEntryLReaction(dialogueEntryFromIndex(dialogueFromIndex(mgr, 1), 0), 2);
+  ASSERT_TRUE(writeDialoguesShardedChanges(mgr, dir.c_str(), dir.length()));
+  EXPECT_EQ(savedNames(), (std::vector<std::string>{"Third", "manifest"}));
+
+  freeDialogueManager(mgr);
+  freeDialogueManager(dlgMgr);
+  fs::remove_all(dir);
+}
+
+TEST(MultipleDialogues, dialogueImageViewsBinaryFile)
+{
+  auto dlgMgr = newDialogueManager();
+  std::string dlgName = "Dialogue 1";
+  std::string partName = "Participant 1";
+  std::string entry1Str = "Entry 1";
+  std::string entry2Str = "Entry 2";
+  std::string choiceStr = "Tell me more.";
+
+  auto dlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto part = addParticipant(dlg, partName.c_str(), partName.length());
+  auto entry1 = addDialogueEntry(dlg, part, entry1Str.c_str(), entry1Str.length());
+  setDialogueEntryLReaction(entry1, 3);
+  auto entry2 = addDialogueEntry(dlg, part, entry2Str.c_str(), entry2Str.length());
+  addDialogueChoiceWithDest(dlg, entry1, choiceStr.c_str(), choiceStr.length(), entry2);
+  addDialogueChoice(dlg, entry2, choiceStr.c_str(), choiceStr.length());
+
+  std::string dest = "test_image.dlgb";
+  ASSERT_TRUE(writeDialoguesBinary(dlgMgr, dest.c_str(), dest.length()));
+  freeDialogueManager(dlgMgr);
+
+  auto image = openDialogueImage(dest.c_str(), dest.length());
+  ASSERT_NE(image, nullptr);
+  ASSERT_EQ(dialogueImageNumDialogues(image), 1);
+  EXPECT_EQ(dialogueImageDialogueFromName(image, "Missing", 7), DIALOGUE_INVALID_INDEX);
+
+  auto dlgIndex = dialogueImageDialogueFromName(image, dlgName.c_str(), dlgName.length());
+  ASSERT_EQ(dlgIndex, 0);
+
+  _size_t length = 0;
+  auto name = dialogueImageDialogueName(image, dlgIndex, &length);
+  EXPECT_EQ(std::string(name, length), dlgName);
+  ASSERT_EQ(dialogueImageNumParticipants(image, dlgIndex), 1);
+  EXPECT_STREQ(dialogueImageParticipantName(image, dlgIndex, 0, nullptr), partName.c_str());
+
+  ASSERT_EQ(dialogueImageNumDialogueEntries(image, dlgIndex), 2);
+  auto content = dialogueImageEntryContent(image, dlgIndex, 1, &length);
+  EXPECT_EQ(std::string(content, length), entry2Str);
+  EXPECT_EQ(dialogueImageEntryActiveParticipant(image, dlgIndex, 0), 0);
+  EXPECT_EQ(dialogueImageEntryLReaction(image, dlgIndex, 0), 3);
+
+  ASSERT_EQ(dialogueImageNumDialogueChoices(image, dlgIndex), 2);
+  ASSERT_EQ(dialogueImageEntryNumDialogueChoices(image, dlgIndex, 0), 1);
+  auto choice = dialogueImageEntryDialogueChoiceFromIndex(image, dlgIndex, 0, 0);
+  EXPECT_EQ(choice, 0);
+  EXPECT_STREQ(dialogueImageChoiceContent(image, dlgIndex, choice, nullptr), choiceStr.c_str());
+  EXPECT_EQ(dialogueImageChoiceDstEntry(image, dlgIndex, choice), 1);
+  EXPECT_EQ(dialogueImageChoiceDstEntry(image, dlgIndex, 1), DIALOGUE_INVALID_INDEX);
+  EXPECT_EQ(dialogueImageEntryContent(image, dlgIndex, 2, &length), nullptr);
+
+  closeDialogueImage(image);
+}
+
+TEST(MultipleDialogues, dialogueLibraryLoadsOnDemand)
+{
+  auto dlgMgr = newDialogueManager();
+  std::string partName = "Participant";
+  std::vector<std::string> names = {"First", "Second", "Third"};
+  for (const auto &name : names)
+  {
+    auto dlg = addNewDialogue(dlgMgr, name.c_str(), name.length());
+    auto part = addParticipant(dlg, partName.c_str(), partName.length());
+    auto entry1 = addDialogueEntry(dlg, part, name.c_str(), name.length());
+    auto entry2 = addDialogueEntry(dlg, part, partName.c_str(), partName.length());
+    assignDialogueChoiceGuid(addDialogueChoiceWithDest(dlg, entry1, name.c_str(), name.length(), entry2));
+  }
+
+  std::string dest = "test_library.dlgb";
+  ASSERT_TRUE(writeDialoguesBinary(dlgMgr, dest.c_str(), dest.length()));
+  freeDialogueManager(dlgMgr);
+
+  auto library = openDialogueLibrary(dest.c_str(), dest.length(), 2);
+  ASSERT_NE(library, nullptr);
+  EXPECT_EQ(dialogueLibraryNumDialogues(library), names.size());
+  EXPECT_EQ(dialogueLibraryNumLoaded(library), 0);
+  EXPECT_EQ(dialogueLibraryDialogueFromName(library, "Missing", 7), nullptr);
+  EXPECT_EQ(dialogueLibraryDialogueFromIndex(library, names.size()), nullptr);
+
+  constexpr size_t bufSize = 64;
+  char strBuf[bufSize];
+  auto second = dialogueLibraryDialogueFromName(library, names[1].c_str(), names[1].length());
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(dialogueLibraryNumLoaded(library), 1);
+  dialogueName(second, strBuf, bufSize);
+  EXPECT_STREQ(strBuf, names[1].c_str());
+  ASSERT_EQ(numDialogueEntries(second), 2);
+  ASSERT_EQ(numDialogueChoices(second), 1);
+  auto choice = dialogueChoiceFromIndex(second, 0);
+  EXPECT_EQ(dialogueChoiceDstEntry(choice), dialogueEntryFromIndex(second, 1));
+  EXPECT_TRUE(guidIsValid(dialogueChoiceGuid(choice)));
+  EXPECT_EQ(dialogueLibraryDialogueFromIndex(library, 1), second);
+
+  // Loading a third dialogue evicts the least recently used one.
+  auto first = dialogueLibraryDialogueFromIndex(library, 0);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(dialogueLibraryDialogueFromIndex(library, 1), second);
+  auto third = dialogueLibraryDialogueFromIndex(library, 2);
+  ASSERT_NE(third, nullptr);
+  EXPECT_EQ(dialogueLibraryNumLoaded(library), 2);
+  EXPECT_EQ(dialogueLibraryDialogueFromIndex(library, 1), second);
+  dialogueName(dialogueLibraryDialogueFromIndex(library, 0), strBuf, bufSize);
+  EXPECT_STREQ(strBuf, names[0].c_str());
+  EXPECT_EQ(dialogueLibraryNumLoaded(library), 2);
+
+  closeDialogueLibrary(library);
+  EXPECT_EQ(openDialogueLibrary("missing.dlgb", 12, 0), nullptr);
+  std::filesystem::remove(dest);
+}
+
+TEST(MultipleDialogues, dialogueStoreMirrorsDialogue)
+{
+  auto dlgMgr = newDialogueManager();
+  std::string dlgName = "Dialogue 1";
+  std::string partName = "Participant 1";
+  std::string entry1Str = "Entry 1";
+  std::string entry2Str = "Entry 2";
+  std::string entry3Str = "Entry 3";
+  std::string choice1Str = "Go to two.";
+  std::string choice2Str = "Go to three.";
+
+  auto dlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto part = addParticipant(dlg, partName.c_str(), partName.length());
+  auto entry1 = addDialogueEntry(dlg, part, entry1Str.c_str(), entry1Str.length());
+  auto entry2 = addDialogueEntry(dlg, part, entry2Str.c_str(), entry2Str.length());
+  addDialogueEntry(dlg, part, entry3Str.c_str(), entry3Str.length());
+  addDialogueChoiceWithDest(dlg, entry1, choice1Str.c_str(), choice1Str.length(), entry2);
+  auto entry3 = dialogueEntryFromIndex(dlg, 2);
+  addDialogueChoiceWithDest(dlg, entry1, choice2Str.c_str(), choice2Str.length(), entry3);
+  addDialogueChoice(dlg, entry2, choice1Str.c_str(), choice1Str.length());
+
+  auto store = buildDialogueStore(dlg);
+  freeDialogueManager(dlgMgr);
+
+  ASSERT_NE(store, nullptr);
+  ASSERT_EQ(dialogueStoreNumParticipants(store), 1);
+  ASSERT_EQ(dialogueStoreNumDialogueEntries(store), 3);
+  ASSERT_EQ(dialogueStoreNumDialogueChoices(store), 3);
+
+  _size_t length = 0;
+  auto name = dialogueStoreParticipantName(store, 0, &length);
+  EXPECT_EQ(std::string(name, length), partName);
+  auto content = dialogueStoreEntryContent(store, 1, &length);
+  EXPECT_EQ(std::string(content, length), entry2Str);
+  content = dialogueStoreChoiceContent(store, 1, &length);
+  EXPECT_EQ(std::string(content, length), choice2Str);
+  EXPECT_EQ(dialogueStoreEntryContent(store, 3, &length), nullptr);
+  EXPECT_EQ(length, 0);
+
+  EXPECT_EQ(dialogueStoreEntryFromId(store, 2), 1);
+  EXPECT_EQ(dialogueStoreEntryFromId(store, 42), DIALOGUE_INVALID_INDEX);
+  EXPECT_EQ(dialogueStoreEntryActiveParticipant(store, 2), 0);
+
+  ASSERT_EQ(dialogueStoreEntryNumDialogueChoices(store, 0), 2);
+  EXPECT_EQ(dialogueStoreEntryDialogueChoiceFromIndex(store, 0, 1), 1);
+  EXPECT_EQ(dialogueStoreEntryDialogueChoiceFromIndex(store, 0, 2), DIALOGUE_INVALID_INDEX);
+  EXPECT_EQ(dialogueStoreChoiceDstEntry(store, 2), DIALOGUE_INVALID_INDEX);
+
+  _size_t next[2] = {};
+  ASSERT_EQ(dialogueStoreEntryNextEntries(store, 0, next, 2), 2);
+  EXPECT_EQ(next[0], 1);
+  EXPECT_EQ(next[1], 2);
+  EXPECT_EQ(dialogueStoreEntryNextEntries(store, 2, next, 2), 0);
+
+  freeDialogueStore(store);
+}
+
+TEST(MultipleDialogues, dialogueRunnerFollowsChoices)
+{
+  auto dlgMgr = newDialogueManager();
+  std::string dlgName = "Dialogue 1";
+  std::string partName = "Participant 1";
+  std::string entryStr = "Entry";
+  std::string choiceStr = "Choice";
+
+  auto dlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto part = addParticipant(dlg, partName.c_str(), partName.length());
+  auto entry1 = addDialogueEntry(dlg, part, entryStr.c_str(), entryStr.length());
+  auto entry2 = addDialogueEntry(dlg, part, entryStr.c_str(), entryStr.length());
+  auto entry3 = addDialogueEntry(dlg, part, entryStr.c_str(), entryStr.length());
+  addDialogueChoiceWithDest(dlg, entry1, choiceStr.c_str(), choiceStr.length(), entry2);
+  addDialogueChoiceWithDest(dlg, entry1, choiceStr.c_str(), choiceStr.length(), entry3);
+  addDialogueChoiceWithDest(dlg, entry3, choiceStr.c_str(), choiceStr.length(), entry1);
+  addDialogueChoice(dlg, entry2, choiceStr.c_str(), choiceStr.length());
+
+  auto store = buildDialogueStore(dlg);
+  freeDialogueManager(dlgMgr);
+
+  EXPECT_EQ(newDialogueRunner(store, 3), nullptr);
+  auto runner = newDialogueRunner(store, 0);
+  ASSERT_NE(runner, nullptr);
+  EXPECT_FALSE(dialogueRunnerFinished(runner));
+  EXPECT_EQ(dialogueRunnerCurrentEntry(runner), 0);
+  ASSERT_EQ(dialogueRunnerNumChoices(runner), 2);
+  EXPECT_EQ(dialogueRunnerChoiceFromIndex(runner, 1), 1);
+  EXPECT_EQ(dialogueRunnerChoiceFromIndex(runner, 2), DIALOGUE_INVALID_INDEX);
+
+  EXPECT_FALSE(dialogueRunnerSelect(runner, 2));
+  EXPECT_TRUE(dialogueRunnerSelect(runner, 1));
+  EXPECT_EQ(dialogueRunnerCurrentEntry(runner), 2);
+  EXPECT_TRUE(dialogueRunnerSelect(runner, 0));
+  EXPECT_EQ(dialogueRunnerCurrentEntry(runner), 0);
+  EXPECT_TRUE(dialogueRunnerSelect(runner, 0));
+  EXPECT_EQ(dialogueRunnerCurrentEntry(runner), 1);
+  EXPECT_TRUE(dialogueRunnerSelect(runner, 0));
+  EXPECT_TRUE(dialogueRunnerFinished(runner));
+  EXPECT_EQ(dialogueRunnerCurrentEntry(runner), DIALOGUE_INVALID_INDEX);
+  EXPECT_EQ(dialogueRunnerNumChoices(runner), 0);
+  EXPECT_FALSE(dialogueRunnerSelect(runner, 0));
+
+  dialogueRunnerReset(runner, 2);
+  EXPECT_EQ(dialogueRunnerCurrentEntry(runner), 2);
+
+  freeDialogueRunner(runner);
+  freeDialogueStore(store);
+}
+
+TEST(MultipleDialogues, dialogueSnapshotsStayConsistentWhileEdited)
+{
+  auto dlgMgr = newDialogueManager();
+  std::string dlgName = "Dialogue 1";
+  std::string partName = "Participant 1";
+  std::string entryStr = "Entry";
+  auto dlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto part = addParticipant(dlg, partName.c_str(), partName.length());
+  auto entry = addDialogueEntry(dlg, part, entryStr.c_str(), entryStr.length());
+
+  auto publisher = newDialoguePublisher();
+  EXPECT_EQ(acquireDialogueSnapshot(publisher), nullptr);
+  EXPECT_EQ(publishDialogueSnapshot(publisher, dlgMgr), 1);
+  auto first = acquireDialogueSnapshot(publisher);
+  ASSERT_NE(first, nullptr);
+
+  // Readers walk whatever snapshot is current while the manager is edited and
+  // republished, every snapshot must be complete on its own.
+  std::atomic<bool> done{false};
+  std::atomic<size_t> mismatches{0};
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < 3; ++t)
+  {
+    readers.emplace_back([&]() {
+      while (!done.load())
+      {
+        auto snapshot = acquireDialogueSnapshot(publisher);
+        auto store = dialogueSnapshotStoreFromName(snapshot, dlgName.c_str(), dlgName.length());
+        // A chain, choice i leads from entry i to entry i + 1.
+        const auto last = dialogueStoreNumDialogueEntries(store) - 1;
+        if (dialogueStoreNumDialogueChoices(store) != last || dialogueStoreEntryNumDialogueChoices(store, last) != 0 ||
+            (last > 0 && dialogueStoreChoiceDstEntry(store, last - 1) != last))
+        {
+          ++mismatches;
+        }
+        releaseDialogueSnapshot(snapshot);
+      }
+    });
+  }
+
+  for (size_t i = 0; i < 200; ++i)
+  {
+    auto next = addDialogueEntry(dlg, part, entryStr.c_str(), entryStr.length());
+    addDialogueChoiceWithDest(dlg, entry, entryStr.c_str(), entryStr.length(), next);
+    entry = next;
+    publishDialogueSnapshot(publisher, dlgMgr);
+  }
+  done = true;
+  for (auto &reader : readers)
+  {
+    reader.join();
+  }
+  EXPECT_EQ(mismatches.load(), 0);
+
+  // Snapshots held by a reader do not follow later publishes.
+  ASSERT_EQ(dialogueSnapshotNumDialogues(first), 1);
+  EXPECT_EQ(dialogueSnapshotStoreFromIndex(first, 1), nullptr);
+  EXPECT_EQ(dialogueStoreNumDialogueEntries(dialogueSnapshotStoreFromIndex(first, 0)), 1);
+  EXPECT_EQ(dialogueSnapshotStoreFromName(first, "Missing", 7), nullptr);
+  releaseDialogueSnapshot(first);
+
+  auto latest = acquireDialogueSnapshot(publisher);
+  EXPECT_EQ(dialogueStoreNumDialogueEntries(dialogueSnapshotStoreFromIndex(latest, 0)), 201);
+  releaseDialogueSnapshot(latest);
+
+  freeDialogueManager(dlgMgr);
+  freeDialoguePublisher(publisher);
+}
+
+TEST(MultipleDialogues, reloadUpdatesDialoguesInPlace)
+{
+  namespace fs = std::filesystem;
+  const std::string file = "test_reload.json";
+  const std::string dir = "test_reload_shards";
+  fs::remove_all(dir);
+
+  // The editor's copy, saved to the file the game reloads from.
+  auto editor = newDialogueManager();
+  std::string partName = "Participant";
+  std::vector<std::string> names = {"First", "Second"};
+  for (const auto &name : names)
+  {
+    auto dlg = addNewDialogue(editor, name.c_str(), name.length());
+    auto part = addParticipant(dlg, partName.c_str(), partName.length());
+    auto first = addDialogueEntry(dlg, part, name.c_str(), name.length());
+    auto second = addDialogueEntry(dlg, part, name.c_str(), name.length());
+    addDialogueChoiceWithDest(dlg, first, name.c_str(), name.length(), second);
+    addDialogueChoice(dlg, second, name.c_str(), name.length());
+  }
+  ASSERT_TRUE(writeDialogues(editor, file.c_str(), file.length()));
+
+  auto mgr = readDialoguesFromFile(file.c_str(), file.length());
+  ASSERT_NE(mgr, nullptr);
+  ASSERT_TRUE(writeDialoguesSharded(mgr, dir.c_str(), dir.length()));
+  auto first = dialogueFromName(mgr, "First", 5);
+  auto second = dialogueFromName(mgr, "Second", 6);
+  auto firstEntry = dialogueEntryFromIndex(first, 0);
+  auto secondEntry = dialogueEntryFromIndex(first, 1);
+  auto firstChoice = dialogueChoiceFromIndex(first, 0);
+  auto secondChoice = dialogueChoiceFromIndex(first, 1);
+
+  auto watcher = newDialogueFileWatcher(file.c_str(), file.length());
+  ASSERT_NE(watcher, nullptr);
+  EXPECT_FALSE(dialogueFileWatcherChanged(watcher));
+
+  // Reloading the file as it is changes nothing.
+  ASSERT_TRUE(writeDialogues(editor, file.c_str(), file.length()));
+  EXPECT_TRUE(dialogueFileWatcherChanged(watcher));
+  EXPECT_FALSE(dialogueFileWatcherChanged(watcher));
+  ASSERT_TRUE(reloadDialoguesFromFile(mgr, file.c_str(), file.length()));
+  EXPECT_FALSE(dialogueManagerModified(mgr));
+  EXPECT_EQ(dialogueFromName(mgr, "First", 5), first);
+  EXPECT_EQ(dialogueEntryFromIndex(first, 0), firstEntry);
+  EXPECT_EQ(dialogueChoiceFromIndex(first, 1), secondChoice);
+
+  // Edit the first dialogue, drop the second and add a third.
+  auto editFirst = dialogueFromName(editor, "First", 5);
+  std::string content = "Changed";
+  setDialogueEntryContent(dialogueEntryFromIndex(editFirst, 0), content.data(), content.length());
+  removeDialogueChoice(editFirst, dialogueChoiceFromIndex(editFirst, 1));
+  auto added = addDialogueEntry(editFirst, participantFromIndex(editFirst, 0), content.c_str(), content.length());
+  addDialogueChoiceWithDest(editFirst, dialogueEntryFromIndex(editFirst, 1), content.c_str(), content.length(), added);
+  auto editSecond = dialogueFromName(editor, "Second", 6);
+  removeDialogue(editor, "Second", 6);
+  freeDialogue(editSecond);
+  addNewDialogue(editor, "Third", 5);
+  ASSERT_TRUE(writeDialogues(editor, file.c_str(), file.length()));
+  EXPECT_TRUE(dialogueFileWatcherChanged(watcher));
+  ASSERT_TRUE(reloadDialoguesFromFile(mgr, file.c_str(), file.length()));
+  EXPECT_TRUE(dialogueManagerModified(mgr));
+
+  ASSERT_EQ(numDialogues(mgr), 2);
+  EXPECT_EQ(dialogueFromIndex(mgr, 0), first);
+  EXPECT_EQ(dialogueFromName(mgr, "Second", 6), nullptr);
+  EXPECT_NE(dialogueFromName(mgr, "Third", 5), nullptr);
+  ASSERT_EQ(numDialogueEntries(first), 3);
+  EXPECT_EQ(dialogueEntryFromIndex(first, 0), firstEntry);
+  EXPECT_EQ(dialogueEntryFromIndex(first, 1), secondEntry);
+  _size_t length = 0;
+  auto view = dialogueEntryContentView(firstEntry, &length);
+  EXPECT_EQ(std::string(view, length), content);
+  ASSERT_EQ(numDialogueChoices(first), 2);
+  EXPECT_EQ(dialogueChoiceFromIndex(first, 0), firstChoice);
+  EXPECT_EQ(dialogueChoiceDstEntry(firstChoice), secondEntry);
+  ASSERT_EQ(dialogueEntryNumDialogueChoices(secondEntry), 1);
+  auto newChoice = dialogueEntryDialogueChoiceFromIndex(secondEntry, 0);
+  EXPECT_NE(newChoice, secondChoice);
+  EXPECT_EQ(dialogueChoiceDstEntry(newChoice), dialogueEntryFromIndex(first, 2));
+
+  // Handles to what the reload removed stay readable.
+  view = dialogueChoiceContentView(secondChoice, &length);
+  EXPECT_EQ(std::string(view, length), names[0]);
+  EXPECT_EQ(numDialogueEntries(second), 2);
+
+  // Releasing frees the dropped dialogue and leaves the live ones alone.
+  releaseDialoguesRemovedByReload(mgr);
+  EXPECT_EQ(numDialogues(mgr), 2);
+  EXPECT_EQ(numDialogueEntries(first), 3);
+
+  // Unreadable files leave the manager alone.
+  const std::string missing = "missing_reload.json";
+  EXPECT_FALSE(reloadDialoguesFromFile(mgr, missing.c_str(), missing.length()));
+  EXPECT_EQ(numDialogues(mgr), 2);
+
+  freeDialogueFileWatcher(watcher);
+  freeDialogueManager(mgr);
+  freeDialogueManager(editor);
+  fs::remove(file);
+  fs::remove_all(dir);
+}
+
+TEST(MultipleDialogues, dialogueHistoryUndoesTransactions)
+{
+  auto dlgMgr = newDialogueManager();
+  std::string dlgName = "Dialogue";
+  std::string partName = "Participant";
+  std::string entryStr = "Entry";
+  auto dlg = addNewDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  auto part = addParticipant(dlg, partName.c_str(), partName.length());
+  std::vector<HDialogueEntry *> entries;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    entries.push_back(addDialogueEntry(dlg, part, entryStr.c_str(), entryStr.length()));
+    setDialogueEntryPosition(entries.back(), double(i), 0.0);
+  }
+  auto toRemoved = addDialogueChoiceWithDest(dlg, entries[0], entryStr.c_str(), entryStr.length(), entries[1]);
+  auto fromRemoved = addDialogueChoiceWithDest(dlg, entries[1], entryStr.c_str(), entryStr.length(), entries[2]);
+  auto selfLoop = addDialogueChoiceWithDest(dlg, entries[1], entryStr.c_str(), entryStr.length(), entries[1]);
+
+  auto history = newDialogueHistory(dlgMgr, 0);
+  ASSERT_NE(history, nullptr);
+  EXPECT_EQ(newDialogueHistory(dlgMgr, 0), nullptr);
+  EXPECT_FALSE(dialogueHistoryUndo(history));
+
+  // The size of one recorded position.
+  setDialogueEntryPosition(entries[0], 0.0, 0.0);
+  const auto changeBytes = dialogueHistoryBytes(history);
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+
+  // A drag of every entry undoes and redoes as one, holding a single change
+  // per entry however many steps it took.
+  dialogueHistoryBegin(history);
+  for (size_t step = 1; step <= 3; ++step)
+  {
+    for (auto entry : entries)
+    {
+      setDialogueEntryPosition(entry, dialogueEntryPositionX(entry), double(step));
+    }
+  }
+  dialogueHistoryCommit(history);
+  EXPECT_EQ(dialogueHistoryNumUndo(history), 1);
+  EXPECT_EQ(dialogueHistoryBytes(history), entries.size() * changeBytes);
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    EXPECT_EQ(dialogueEntryPositionX(entries[i]), double(i));
+    EXPECT_EQ(dialogueEntryPositionY(entries[i]), 0.0);
+  }
+  ASSERT_TRUE(dialogueHistoryRedo(history));
+  EXPECT_EQ(dialogueEntryPositionY(entries[3]), 3.0);
+  EXPECT_FALSE(dialogueHistoryRedo(history));
+
+  // Removing an entry takes its choices and the links to it, undo puts all
+  // of them back in their places.
+  removeDialogueEntryPtr(dlg, entries[1]);
+  ASSERT_EQ(numDialogueEntries(dlg), 3);
+  ASSERT_EQ(numDialogueChoices(dlg), 1);
+  EXPECT_EQ(dialogueChoiceDstEntry(toRemoved), nullptr);
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  EXPECT_EQ(numDialogueEntries(dlg), 4);
+  EXPECT_EQ(numDialogueChoices(dlg), 3);
+  EXPECT_EQ(dialogueChoiceDstEntry(toRemoved), entries[1]);
+  ASSERT_EQ(dialogueEntryNumDialogueChoices(entries[1]), 2);
+  EXPECT_EQ(dialogueEntryDialogueChoiceFromIndex(entries[1], 0), fromRemoved);
+  EXPECT_EQ(dialogueEntryDialogueChoiceFromIndex(entries[1], 1), selfLoop);
+  EXPECT_EQ(dialogueChoiceDstEntry(selfLoop), entries[1]);
+
+  // Undone changes are gone for good once something else changes.
+  EXPECT_EQ(dialogueHistoryNumRedo(history), 1);
+  std::string content = "Changed";
+  setDialogueChoiceContent(fromRemoved, content.data(), content.length());
+  EXPECT_EQ(dialogueHistoryNumRedo(history), 0);
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  _size_t length = 0;
+  auto view = dialogueChoiceContentView(fromRemoved, &length);
+  EXPECT_EQ(std::string(view, length), entryStr);
+
+  // Guids and participants follow undo, lookups included.
+  assignDialogueChoiceGuid(toRemoved);
+  std::string guidStr(36, '\0');
+  guidToString(dialogueChoiceGuid(toRemoved), &guidStr[0], guidStr.size());
+  auto guid = guidFromString(guidStr.c_str(), guidStr.size());
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  EXPECT_FALSE(dialogueChoiceGuidAssigned(toRemoved));
+  EXPECT_EQ(choiceFromGuid(dlgMgr, guid), nullptr);
+  ASSERT_TRUE(dialogueHistoryRedo(history));
+  EXPECT_EQ(choiceFromGuid(dlgMgr, guid), toRemoved);
+  freeGuid(guid);
+  removeParticipant(dlg, partName.c_str(), partName.length());
+  EXPECT_EQ(participantFromName(dlg, partName.c_str(), partName.length()), nullptr);
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  EXPECT_EQ(participantFromName(dlg, partName.c_str(), partName.length()), part);
+
+  // Over budget the oldest transactions go first.
+  const auto numUndo = dialogueHistoryNumUndo(history);
+  EXPECT_EQ(dialogueHistoryNumDropped(history), 0);
+  setDialogueHistoryBudget(history, 1);
+  EXPECT_EQ(dialogueHistoryNumUndo(history), 1);
+  EXPECT_LT(dialogueHistoryNumUndo(history), numUndo);
+  EXPECT_EQ(dialogueHistoryNumDropped(history), numUndo - 1);
+  // A new transaction replacing the oldest leaves the count of undoable ones
+  // as it was, only the dropped ones tell.
+  setDialogueChoiceContent(fromRemoved, content.data(), content.length());
+  EXPECT_EQ(dialogueHistoryNumUndo(history), 1);
+  EXPECT_EQ(dialogueHistoryNumDropped(history), numUndo);
+
+  // Removing a dialogue may free its nodes, so it clears the history.
+  auto removed = dialogueFromName(dlgMgr, dlgName.c_str(), dlgName.length());
+  removeDialogue(dlgMgr, dlgName.c_str(), dlgName.length());
+  EXPECT_EQ(dialogueHistoryNumUndo(history), 0);
+  freeDialogue(removed);
+
+  freeDialogueHistory(history);
+  freeDialogueManager(dlgMgr);
+}
+
+TEST_F(DialogueTestWithParticipants, BulkDataMatchesSingleQueries)
+{
+  std::string entry1Str = "Entry 1";
+  std::string entry2Str = "Entry 2";
+  std::string choiceStr = "Choice";
+  auto entry1 = addDialogueEntry(dlg, part1, entry1Str.c_str(), entry1Str.length());
+  auto entry2 = addDialogueEntry(dlg, part2, entry2Str.c_str(), entry2Str.length());
+  setDialogueEntryPosition(entry2, 4.0, -2.5);
+  setDialogueEntryRReaction(entry2, 2);
+  auto choice1 = addDialogueChoiceWithDest(dlg, entry1, choiceStr.c_str(), choiceStr.length(), entry2);
+  auto choice2 = addDialogueChoice(dlg, entry1, choiceStr.c_str(), choiceStr.length());
+
+  ParticipantData participants[3];
+  ASSERT_EQ(dialogueParticipantsData(dlg, participants, 3), 3);
+  EXPECT_EQ(participants[1].participant, part2);
+  EXPECT_EQ(std::string(participants[1].name, participants[1].nameLength), part2Name);
+
+  DialogueEntryData entries[1];
+  ASSERT_EQ(dialogueEntriesData(dlg, nullptr, 0), 2);
+  ASSERT_EQ(dialogueEntriesData(dlg, entries, 1), 2);
+  EXPECT_EQ(entries[0].entry, entry1);
+  EXPECT_EQ(entries[0].numChoices, 2);
+
+  DialogueEntryData allEntries[2];
+  ASSERT_EQ(dialogueEntriesData(dlg, allEntries, 2), 2);
+  EXPECT_EQ(allEntries[1].entry, entry2);
+  EXPECT_EQ(allEntries[1].activeParticipant, part2);
+  EXPECT_EQ(allEntries[1].participantId, participants[1].id);
+  EXPECT_EQ(std::string(allEntries[1].content, allEntries[1].contentLength), entry2Str);
+  EXPECT_EQ(allEntries[1].positionX, 4.0);
+  EXPECT_EQ(allEntries[1].positionY, -2.5);
+  EXPECT_EQ(allEntries[1].lReaction, 0);
+  EXPECT_EQ(allEntries[1].rReaction, 2);
+
+  DialogueChoiceData choices[2];
+  ASSERT_EQ(dialogueChoicesData(dlg, choices, 2), 2);
+  EXPECT_EQ(choices[0].choice, choice1);
+  EXPECT_EQ(choices[0].src, entry1);
+  EXPECT_EQ(choices[0].dst, entry2);
+  EXPECT_EQ(choices[0].dstId, allEntries[1].id);
+  EXPECT_EQ(choices[1].dst, nullptr);
+  EXPECT_EQ(choices[1].dstId, DIALOGUE_INVALID_INDEX);
+  EXPECT_EQ(choices[1].guidAssigned, 0);
+
+  HDialogueChoice *entryChoices[2] = {};
+  ASSERT_EQ(dialogueEntryChoices(entry1, entryChoices, 2), 2);
+  EXPECT_EQ(entryChoices[0], choice1);
+  EXPECT_EQ(entryChoices[1], choice2);
+}
+
+TEST_F(DialogueTestWithParticipants, BatchEditsApplyAsOneTransaction)
+{
+  auto otherDlg = addNewDialogue(dlgMgr, "Other", 5);
+  auto otherPart = addParticipant(otherDlg, "Other", 5);
+  auto otherEntry = addDialogueEntry(otherDlg, otherPart, "Other", 5);
+
+  auto history = newDialogueHistory(dlgMgr, 0);
+  std::string text = "Pasted";
+
+  // More records than the API converts at a time.
+  std::vector<DialogueEntryCreate> entryRecords;
+  for (size_t i = 0; i < 300; ++i)
+  {
+    entryRecords.push_back({part1, text.c_str(), text.length(), double(i), 1.0});
+  }
+  // An entry without one of the dialogue's participants could not be saved.
+  entryRecords.push_back({nullptr, text.c_str(), text.length(), 0.0, 0.0});
+  entryRecords.push_back({otherPart, text.c_str(), text.length(), 0.0, 0.0});
+  std::vector<HDialogueEntry *> entries(entryRecords.size());
+  addDialogueEntries(dlg, entryRecords.data(), entryRecords.size(), entries.data());
+  ASSERT_EQ(numDialogueEntries(dlg), 300);
+  EXPECT_EQ(entries[300], nullptr);
+  EXPECT_EQ(entries[301], nullptr);
+  EXPECT_EQ(dialogueEntryFromIndex(dlg, 2), entries[2]);
+  EXPECT_EQ(dialogueEntryFromIndex(dlg, 299), entries[299]);
+  EXPECT_EQ(dialogueEntryActiveParticipant(entries[1]), part1);
+  EXPECT_EQ(dialogueEntryPositionX(entries[2]), 2.0);
+
+  std::vector<DialogueChoiceCreate> choiceRecords = {
+    {entries[0], entries[1], text.c_str(), text.length()},
+    {nullptr, entries[1], text.c_str(), text.length()},
+    {entries[1], nullptr, text.c_str(), text.length()},
+    {otherEntry, entries[1], text.c_str(), text.length()},
+    {entries[1], otherEntry, text.c_str(), text.length()},
+  };
+  std::vector<HDialogueChoice *> choices(choiceRecords.size());
+  addDialogueChoices(dlg, choiceRecords.data(), choiceRecords.size(), choices.data());
+  EXPECT_EQ(numDialogueChoices(dlg), 2);
+  EXPECT_EQ(choices[1], nullptr);
+  EXPECT_EQ(choices[3], nullptr);
+  EXPECT_EQ(choices[4], nullptr);
+  EXPECT_EQ(dialogueEntryNumDialogueChoices(otherEntry), 0);
+  EXPECT_EQ(dialogueChoiceDstEntry(choices[0]), entries[1]);
+  EXPECT_EQ(dialogueHistoryNumUndo(history), 2);
+
+  std::vector<DialogueEntryData> entryData(300);
+  std::vector<DialogueChoiceData> choiceData(2);
+  dialogueEntriesData(dlg, entryData.data(), entryData.size());
+  dialogueChoicesData(dlg, choiceData.data(), choiceData.size());
+
+  std::vector<DialogueEntryMove> moves = {
+    {entryData[0].id, 10.0, 20.0},
+    {entryData[2].id, 30.0, 40.0},
+    {DIALOGUE_INVALID_INDEX - 1, 0.0, 0.0},
+  };
+  EXPECT_EQ(moveDialogueEntries(dlg, moves.data(), moves.size()), 2);
+  EXPECT_EQ(dialogueEntryPositionX(entries[0]), 10.0);
+  EXPECT_EQ(dialogueEntryPositionY(entries[2]), 40.0);
+
+  std::vector<DialogueChoiceRelink> relinks = {
+    {choiceData[0].id, DIALOGUE_INVALID_INDEX},
+    {choiceData[1].id, entryData[2].id},
+    {choiceData[1].id, DIALOGUE_INVALID_INDEX - 1},
+  };
+  EXPECT_EQ(relinkDialogueChoices(dlg, relinks.data(), relinks.size()), 2);
+  EXPECT_EQ(dialogueChoiceDstEntry(choices[0]), nullptr);
+  EXPECT_EQ(dialogueChoiceDstEntry(choices[2]), entries[2]);
+
+  // Each batch undoes in one step.
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  EXPECT_EQ(dialogueChoiceDstEntry(choices[0]), entries[1]);
+  EXPECT_EQ(dialogueChoiceDstEntry(choices[2]), nullptr);
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  EXPECT_EQ(dialogueEntryPositionX(entries[0]), 0.0);
+  EXPECT_EQ(dialogueEntryPositionY(entries[2]), 1.0);
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  EXPECT_EQ(numDialogueChoices(dlg), 0);
+  ASSERT_TRUE(dialogueHistoryUndo(history));
+  EXPECT_EQ(numDialogueEntries(dlg), 0);
+
+  freeDialogueHistory(history);
+}
+
+TEST_F(DialogueTestWithParticipants, AnalysisFindsGraphProblems)
+{
+  // 0 -> 1 <-> 2 -> 3, 0 also ends the conversation, 4 loops onto itself
+  // and neither 4 nor 5 can be reached.
+  std::string text = "Text";
+  std::vector<HDialogueEntry *> entries;
+  for (size_t i = 0; i < 6; ++i)
+  {
+    entries.push_back(addDialogueEntry(dlg, part1, text.c_str(), text.length()));
+  }
+  addDialogueChoiceWithDest(dlg, entries[0], text.c_str(), text.length(), entries[1]);
+  addDialogueChoice(dlg, entries[0], text.c_str(), text.length());
+  addDialogueChoiceWithDest(dlg, entries[1], text.c_str(), text.length(), entries[2]);
+  addDialogueChoiceWithDest(dlg, entries[2], text.c_str(), text.length(), entries[1]);
+  addDialogueChoiceWithDest(dlg, entries[2], text.c_str(), text.length(), entries[3]);
+  addDialogueChoiceWithDest(dlg, entries[4], text.c_str(), text.length(), entries[4]);
+
+  auto analysis = analyseDialogue(dlg, 0);
+  _size_t indices[8];
+  ASSERT_EQ(dialogueAnalysisUnreachableEntries(analysis, indices, 8), 2);
+  EXPECT_EQ(indices[0], 4);
+  EXPECT_EQ(indices[1], 5);
+  ASSERT_EQ(dialogueAnalysisDanglingChoices(analysis, indices, 8), 1);
+  EXPECT_EQ(indices[0], 1);
+  ASSERT_EQ(dialogueAnalysisDeadEnds(analysis, indices, 8), 2);
+  EXPECT_EQ(indices[0], 3);
+  EXPECT_EQ(indices[1], 5);
+
+  EXPECT_EQ(dialogueAnalysisNumComponents(analysis), 5);
+  EXPECT_EQ(dialogueAnalysisEntryComponent(analysis, 1), dialogueAnalysisEntryComponent(analysis, 2));
+  EXPECT_NE(dialogueAnalysisEntryComponent(analysis, 0), dialogueAnalysisEntryComponent(analysis, 1));
+  EXPECT_EQ(dialogueAnalysisEntryComponent(analysis, 6), DIALOGUE_INVALID_INDEX);
+  ASSERT_EQ(dialogueAnalysisCyclicComponents(analysis, indices, 8), 2);
+  std::vector<_size_t> cyclic(indices, indices + 2);
+  EXPECT_NE(std::find(cyclic.begin(), cyclic.end(), dialogueAnalysisEntryComponent(analysis, 1)), cyclic.end());
+  EXPECT_NE(std::find(cyclic.begin(), cyclic.end(), dialogueAnalysisEntryComponent(analysis, 4)), cyclic.end());
+
+  // The cycle counts once: 0 -> 1, then 2 -> 3.
+  EXPECT_EQ(dialogueAnalysisLongestPath(analysis), 2);
+  EXPECT_EQ(dialogueAnalysisLongestPathEnd(analysis), 3);
+  freeDialogueAnalysis(analysis);
+
+  analysis = analyseDialogue(dlg, 6);
+  EXPECT_EQ(dialogueAnalysisUnreachableEntries(analysis, nullptr, 0), 6);
+  EXPECT_EQ(dialogueAnalysisLongestPathEnd(analysis), DIALOGUE_INVALID_INDEX);
+  freeDialogueAnalysis(analysis);
+
+  // The whole manager, each dialogue from its first entry or from the
+  // given root. Too small a capacity only yields the count.
+  HDialogueAnalysis *analyses[1];
+  EXPECT_EQ(analyseDialogues(dlgMgr, nullptr, nullptr, 0), 1);
+  ASSERT_EQ(analyseDialogues(dlgMgr, nullptr, analyses, 1), 1);
+  EXPECT_EQ(dialogueAnalysisUnreachableEntries(analyses[0], nullptr, 0), 2);
+  EXPECT_EQ(dialogueAnalysisLongestPath(analyses[0]), 2);
+  freeDialogueAnalysis(analyses[0]);
+
+  const _size_t roots[] = {4};
+  ASSERT_EQ(analyseDialogues(dlgMgr, roots, analyses, 1), 1);
+  EXPECT_EQ(dialogueAnalysisUnreachableEntries(analyses[0], nullptr, 0), 5);
+  EXPECT_EQ(dialogueAnalysisLongestPathEnd(analyses[0]), 4);
+  freeDialogueAnalysis(analyses[0]);
+}
+
+TEST_F(DialogueTestWithParticipants, AnalysisKeepsOtherDialoguesOutOfTheGraph)
+{
+  // 0 -> 1, 1 leads into another dialogue and a choice of this dialogue
+  // leaves from the other dialogue's entry.
+  std::string text = "Text";
+  auto entry0 = addDialogueEntry(dlg, part1, text.c_str(), text.length());
+  auto entry1 = addDialogueEntry(dlg, part1, text.c_str(), text.length());
+  auto otherDlg = addNewDialogue(dlgMgr, "Other", 5);
+  auto otherPart = addParticipant(otherDlg, "Other", 5);
+  auto otherEntry = addDialogueEntry(otherDlg, otherPart, text.c_str(), text.length());
+  addDialogueChoiceWithDest(dlg, entry0, text.c_str(), text.length(), entry1);
+  addDialogueChoiceWithDest(dlg, entry1, text.c_str(), text.length(), otherEntry);
+  addDialogueChoiceWithDest(dlg, otherEntry, text.c_str(), text.length(), entry0);
+
+  auto analysis = analyseDialogue(dlg, 0);
+  _size_t indices[4];
+  ASSERT_EQ(dialogueAnalysisDanglingChoices(analysis, indices, 4), 1);
+  EXPECT_EQ(indices[0], 1);
+  EXPECT_EQ(dialogueAnalysisUnreachableEntries(analysis, nullptr, 0), 0);
+  EXPECT_EQ(dialogueAnalysisDeadEnds(analysis, nullptr, 0), 0);
+  EXPECT_EQ(dialogueAnalysisNumComponents(analysis), 2);
+  EXPECT_EQ(dialogueAnalysisCyclicComponents(analysis, nullptr, 0), 0);
+  EXPECT_EQ(dialogueAnalysisLongestPath(analysis), 1);
+  EXPECT_EQ(dialogueAnalysisLongestPathEnd(analysis), 1);
+  freeDialogueAnalysis(analysis);
+}
+
+TEST_F(DialogueTestWithParticipants, StringLengthsAndViewsMatchContents)
+{
+  std::string entryStr = "A longer entry than any guessed buffer would hold, \xC3\xA9t\xC3\xA9.";
+  std::string choiceStr = "Choice";
+  auto entry = addDialogueEntry(dlg, part1, entryStr.c_str(), entryStr.length());
+  auto choice = addDialogueChoice(dlg, entry, choiceStr.c_str(), choiceStr.length());
+
+  EXPECT_EQ(dialogueNameLength(dlg), dlgName.length());
+  EXPECT_EQ(participantNameLength(part1), part1Name.length());
+  EXPECT_EQ(dialogueEntryContentLength(entry), entryStr.length());
+  EXPECT_EQ(dialogueChoiceContentLength(choice), choiceStr.length());
+
+  _size_t length = 0;
+  auto view = dialogueNameView(dlg, &length);
+  EXPECT_EQ(std::string(view, length), dlgName);
+  view = participantNameView(part1, &length);
+  EXPECT_EQ(std::string(view, length), part1Name);
+  view = dialogueEntryContentView(entry, &length);
+  EXPECT_EQ(std::string(view, length), entryStr);
+  view = dialogueChoiceContentView(choice, &length);
+  EXPECT_EQ(std::string(view, length), choiceStr);
+
+  std::vector<char> buffer(dialogueEntryContentLength(entry) + 1);
+  dialogueEntryContent(entry, buffer.data(), static_cast<_size_t>(buffer.size()));
+  EXPECT_EQ(std::string(buffer.data()), entryStr);
 }
 
 TEST_F(DialogueTestWithParticipants, CanSetAndRetrieveEntryPositions)
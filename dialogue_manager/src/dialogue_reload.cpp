@@ -0,0 +1,349 @@
+#include "dialogue_manager.hpp"
+#include "dialogue_history.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //Node matching
+    // Source nodes are mapped to live ones through their _index, the
+    // position in the source dialogue's lists.
+
+    // Whether the node at position in the rebuilt list moved or is new.
+    template <typename NodePtr>
+    bool moved(const std::vector<NodePtr> &nodes, size_t position, NodePtr node)
+    {
+        return position >= nodes.size() || nodes[position] != node;
+    }
+
+    // Live node with the given ID, tried at the same position first since
+    // most nodes stay where they were.
+    template <typename NodePtr, typename Lookup>
+    NodePtr matchById(const std::vector<NodePtr> &nodes, size_t position, floofy::ID id, Lookup &&lookup)
+    {
+        return position < nodes.size() && nodes[position]->id == id ? nodes[position] : lookup(id);
+    }
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace
+
+namespace floofy
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueManager - Reloading
+
+    bool DialogueManager::reloadFromFile(const std::string &filePath)
+    {
+        std::unique_ptr<DialogueManager> source(readFromFile(filePath));
+        if (!source)
+        {
+            return false;
+        }
+
+        reload(*source);
+        return true;
+    }
+
+    bool DialogueManager::reloadContents(const std::string &contents)
+    {
+        std::unique_ptr<DialogueManager> source(readContents(contents));
+        if (!source)
+        {
+            return false;
+        }
+
+        reload(*source);
+        return true;
+    }
+
+    void DialogueManager::releaseReloadRemoved()
+    {
+        _reloadRemoved.clear();
+    }
+
+    void DialogueManager::reload(DialogueManager &source)
+    {
+        // Patched nodes are not recorded, so earlier changes no longer undo.
+        if (_history)
+        {
+            _history->clear();
+        }
+
+        std::vector<DialoguePtr> order;
+        order.reserve(source.dialogues.size());
+        std::unordered_set<DialoguePtr> kept;
+        const auto sourceDialogues = source.dialogues;
+        for (auto src : sourceDialogues)
+        {
+            auto live = dialogue(src->name);
+            if (live)
+            {
+                if (patchDialogue(*live, *src))
+                {
+                    live->markModified();
+                }
+            }
+            else
+            {
+                live = source.removeDialogue(src->name);
+                addDialogue(live);
+            }
+            order.push_back(live);
+            kept.insert(live);
+        }
+
+        const auto liveDialogues = dialogues;
+        for (auto live : liveDialogues)
+        {
+            if (kept.count(live) == 0)
+            {
+                _reloadRemoved.emplace_back(removeDialogue(live->name));
+            }
+        }
+
+        // Holds the same dialogues as the list by now, in the source's order.
+        dialogues = std::move(order);
+    }
+
+    // Matches source's nodes to live's and only writes fields that differ.
+    // The lists and lookup indexes are rebuilt only when something changed,
+    // so an unchanged dialogue costs a lookup per node. Returns whether
+    // anything changed.
+    bool DialogueManager::patchDialogue(Dialogue &live, const Dialogue &source)
+    {
+        bool changed = false;
+
+        //Participants
+        std::unordered_map<ParticipantPtr, ParticipantPtr> participantMap;
+        std::vector<ParticipantPtr> participants;
+        participants.reserve(source.participants.size());
+        for (auto src : source.participants)
+        {
+            auto part = matchById(live.participants, participants.size(), src->id, [&live](ID id) { return live.participant(id); });
+            if (!part)
+            {
+                part = live._participantPool.create(src->id, src->name);
+                changed = true;
+            }
+            else if (part->name != src->name)
+            {
+                part->name = src->name;
+                changed = true;
+            }
+            changed |= moved(live.participants, participants.size(), part);
+            participantMap.emplace(src, part);
+            participants.push_back(part);
+        }
+
+        //Entries
+        std::vector<DialogueEntryPtr> entries;
+        entries.reserve(source.entries.size());
+        for (auto src : source.entries)
+        {
+            auto participant = src->activeParticipant ? participantMap.at(src->activeParticipant) : nullptr;
+            auto entry = matchById(live.entries, entries.size(), src->id, [&live](ID id) { return live.dialogueEntry(id); });
+            if (!entry)
+            {
+                entry = live._entryPool.create(src->id, src->entry, participant);
+                entry->viewPosition = src->viewPosition;
+                entry->lReaction = src->lReaction;
+                entry->rReaction = src->rReaction;
+                changed = true;
+            }
+            else if (entry->entry != src->entry || entry->activeParticipant != participant ||
+                     entry->viewPosition.x != src->viewPosition.x || entry->viewPosition.y != src->viewPosition.y ||
+                     entry->lReaction != src->lReaction || entry->rReaction != src->rReaction)
+            {
+                entry->entry = src->entry;
+                entry->activeParticipant = participant;
+                entry->viewPosition = src->viewPosition;
+                entry->lReaction = src->lReaction;
+                entry->rReaction = src->rReaction;
+                changed = true;
+            }
+            changed |= moved(live.entries, entries.size(), entry);
+            entries.push_back(entry);
+        }
+
+        //Choices
+        // Matched by ID first. Source choices whose ID is unknown then take
+        // an unmatched live choice with the same assigned GUID, so a choice
+        // keeps its handle when only its ID was renumbered.
+        std::vector<DialogueChoicePtr> choices(source.choices.size(), nullptr);
+        bool unmatched = false;
+        for (size_t i = 0; i < source.choices.size(); ++i)
+        {
+            choices[i] = matchById(live.choices, i, source.choices[i]->id, [&live](ID id) { return live.choice(id); });
+            unmatched |= choices[i] == nullptr;
+        }
+        if (unmatched)
+        {
+            std::unordered_set<DialogueChoicePtr> claimed(choices.begin(), choices.end());
+            std::unordered_map<Guid, DialogueChoicePtr> byGuid;
+            for (auto choice : live.choices)
+            {
+                if (choice->guidAssigned && claimed.count(choice) == 0)
+                {
+                    byGuid.emplace(choice->guid, choice);
+                }
+            }
+            for (size_t i = 0; i < source.choices.size(); ++i)
+            {
+                auto src = source.choices[i];
+                auto find = src->guidAssigned && !choices[i] ? byGuid.find(src->guid) : byGuid.end();
+                if (find != byGuid.end())
+                {
+                    choices[i] = find->second;
+                    byGuid.erase(find);
+                }
+            }
+        }
+
+        auto manager = live._manager;
+        for (size_t i = 0; i < source.choices.size(); ++i)
+        {
+            auto src = source.choices[i];
+            auto srcEntry = entries[src->src->_index];
+            auto dst = src->dst ? entries[src->dst->_index] : nullptr;
+            auto &choice = choices[i];
+            if (!choice)
+            {
+                choice = live._choicePool.create(src->id, srcEntry, src->choice, dst);
+                choice->guid = src->guid;
+                choice->guidAssigned = src->guidAssigned;
+                changed = true;
+                continue;
+            }
+
+            if (choice->id != src->id || choice->choice != src->choice || choice->src != srcEntry || choice->dst != dst)
+            {
+                choice->id = src->id;
+                choice->choice = src->choice;
+                choice->src = srcEntry;
+                choice->dst = dst;
+                changed = true;
+            }
+            if (choice->guidAssigned != src->guidAssigned || (src->guidAssigned && choice->guid != src->guid))
+            {
+                if (manager)
+                {
+                    manager->unindexChoiceGuid(choice);
+                }
+                choice->guid = src->guid;
+                choice->guidAssigned = src->guidAssigned;
+                changed = true;
+            }
+        }
+
+        // A choice's position in its entry is what gets saved, its position
+        // in the dialogue's list is not, so only the former counts as a change.
+        for (auto src : source.entries)
+        {
+            auto entry = entries[src->_index];
+            changed |= entry->choices.size() != src->choices.size();
+            for (size_t i = 0; !changed && i < src->choices.size(); ++i)
+            {
+                changed = entry->choices[i] != choices[src->choices[i]->_index];
+            }
+        }
+        changed |= participants.size() != live.participants.size() || entries.size() != live.entries.size() ||
+                   choices.size() != live.choices.size();
+
+        if (!changed)
+        {
+            return false;
+        }
+
+        // Nodes left detached by this are the removed ones.
+        for (auto part : live.participants)
+        {
+            part->_dialogue = nullptr;
+        }
+        for (auto entry : live.entries)
+        {
+            entry->_dialogue = nullptr;
+        }
+        for (auto choice : live.choices)
+        {
+            choice->_dialogue = nullptr;
+        }
+
+        live._participantsByName.clear();
+        live._participantsById.clear();
+        for (auto part : participants)
+        {
+            part->_dialogue = &live;
+            live._participantsByName.emplace(part->name, part);
+            live._participantsById.emplace(part->id, part);
+            if (part->id >= live._nextParticipantId)
+                live._nextParticipantId = part->id + 1;
+        }
+
+        live._entriesById.clear();
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            auto entry = entries[i];
+            entry->_dialogue = &live;
+            entry->_index = i;
+            entry->choices.clear();
+            for (auto choice : source.entries[i]->choices)
+            {
+                entry->choices.push_back(choices[choice->_index]);
+            }
+            entry->_incoming.clear();
+            live._entriesById.emplace(entry->id, entry);
+            if (entry->id >= live._nextEntryId)
+                live._nextEntryId = entry->id + 1;
+        }
+
+        live._choicesById.clear();
+        for (size_t i = 0; i < choices.size(); ++i)
+        {
+            auto choice = choices[i];
+            choice->_dialogue = &live;
+            choice->_index = i;
+            if (choice->dst)
+            {
+                choice->dst->_incoming.push_back(choice);
+            }
+            live._choicesById.emplace(choice->id, choice);
+            if (choice->id >= live._nextDialogueChoiceId)
+                live._nextDialogueChoiceId = choice->id + 1;
+        }
+
+        for (auto entry : live.entries)
+        {
+            if (!entry->_dialogue)
+            {
+                entry->choices.clear();
+                entry->_incoming.clear();
+            }
+        }
+        // Removed GUIDs go first, a new choice may have taken one over.
+        if (manager)
+        {
+            for (auto choice : live.choices)
+            {
+                if (!choice->_dialogue)
+                {
+                    manager->unindexChoiceGuid(choice);
+                }
+            }
+            for (auto choice : choices)
+            {
+                manager->indexChoiceGuid(choice);
+            }
+        }
+
+        live.participants = std::move(participants);
+        live.entries = std::move(entries);
+        live.choices = std::move(choices);
+        return true;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "dialogue_store.hpp"
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueRunner
+  // Cursor walking a conversation over a DialogueStore. The store is the
+  // compiled, immutable choice table and can be shared by any number of
+  // runners, a runner itself is only the store and the current entry index.
+  // Every step is a couple of array reads, nothing is allocated. The store
+  // must outlive its runners.
+  class DialogueRunner
+  {
+  public:
+    DialogueRunner(const DialogueStore &store, uint32_t entry) : _store(&store)
+    {
+      reset(entry);
+    }
+
+    void reset(uint32_t entry)
+    {
+      _current = entry < _store->numEntries() ? entry : DialogueStore::NO_INDEX;
+    }
+
+    // Finished after selecting a choice without a destination or when reset
+    // to an invalid entry, an entry without choices simply offers none.
+    bool finished() const { return _current == DialogueStore::NO_INDEX; }
+    uint32_t current() const { return _current; }
+
+    DialogueStore::IndexRange choices() const
+    {
+      return finished() ? DialogueStore::IndexRange{} : _store->entryChoices(_current);
+    }
+
+    bool select(size_t index)
+    {
+      const auto available = choices();
+      if (index >= available.size())
+      {
+        return false;
+      }
+
+      _current = _store->choiceDst(available[index]);
+      return true;
+    }
+
+    const DialogueStore &store() const { return *_store; }
+
+  private:
+    const DialogueStore *_store;
+    uint32_t _current = DialogueStore::NO_INDEX;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
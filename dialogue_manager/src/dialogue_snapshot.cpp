@@ -0,0 +1,79 @@
+#include "dialogue_snapshot.hpp"
+#include "common/parallel.hpp"
+
+#include <utility>
+
+namespace floofy
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueSnapshot
+
+    DialogueSnapshot::DialogueSnapshot(const DialogueManager &mgr)
+    {
+        const auto numDialogues = mgr.numDialogues();
+        _stores.resize(numDialogues);
+        parallelFor(numDialogues, [this, &mgr](size_t i) {
+            _stores[i] = DialogueStore(*mgr.dialogue(i));
+        });
+
+        _indexByName.reserve(numDialogues);
+        for (size_t i = 0; i < numDialogues; ++i)
+        {
+            _indexByName.emplace(_stores[i].name(), i);
+        }
+    }
+
+    const DialogueStore *DialogueSnapshot::dialogue(std::string_view name) const
+    {
+        auto find = _indexByName.find(name);
+        return find == _indexByName.end() ? nullptr : &_stores[find->second];
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //DialoguePublisher
+
+    DialogueSnapshotPtr DialoguePublisher::publish(const DialogueManager &mgr)
+    {
+        auto snapshot = std::make_shared<const DialogueSnapshot>(mgr);
+        publish(snapshot);
+        return snapshot;
+    }
+
+    void DialoguePublisher::publish(DialogueSnapshotPtr snapshot)
+    {
+        // The replaced snapshot is released outside the lock, it may be the
+        // last reference.
+        std::unique_lock<std::mutex> lock(_mutex);
+        _current.swap(snapshot);
+        _version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        lock.unlock();
+    }
+
+    DialogueSnapshotPtr DialoguePublisher::current() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _current;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////////
+    //DialoguePublisher::Reader
+
+    const DialogueSnapshot *DialoguePublisher::Reader::snapshot()
+    {
+        if (_publisher->version() != _version)
+        {
+            // Released after the lock, it may be the last reference.
+            DialogueSnapshotPtr previous;
+            std::lock_guard<std::mutex> lock(_publisher->_mutex);
+            previous = std::exchange(_snapshot, _publisher->_current);
+            _version = _publisher->_version.load(std::memory_order_relaxed);
+        }
+        return _snapshot.get();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
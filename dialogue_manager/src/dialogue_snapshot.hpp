@@ -0,0 +1,99 @@
+#pragma once
+
+#include "dialogue_manager.hpp"
+#include "dialogue_store.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //Forward Decls
+  class DialogueSnapshot;
+  using DialogueSnapshotPtr = std::shared_ptr<const DialogueSnapshot>;
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueSnapshot
+  // Immutable DialogueStores of every dialogue of a manager, looked up by
+  // index or name. Nothing changes after construction, so any number of
+  // threads can read a snapshot without synchronisation.
+  class DialogueSnapshot
+  {
+  public:
+    // Compiles the dialogues in parallel. The manager must not change while
+    // this runs.
+    explicit DialogueSnapshot(const DialogueManager &mgr);
+
+    DialogueSnapshot(const DialogueSnapshot &) = delete;
+    DialogueSnapshot &operator=(const DialogueSnapshot &) = delete;
+
+    size_t numDialogues() const { return _stores.size(); }
+    const DialogueStore &dialogue(size_t index) const { return _stores[index]; }
+    const DialogueStore *dialogue(std::string_view name) const;
+
+  private:
+    std::vector<DialogueStore> _stores;
+    // Names point into the stores.
+    std::unordered_map<std::string_view, size_t> _indexByName;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //DialoguePublisher
+  // Hands the latest snapshot to reader threads while a writer keeps editing
+  // or reloading the manager. The writer publishes a new snapshot when it is
+  // done, readers keep the one they hold until they ask again, and a snapshot
+  // is freed once the last reader lets go of it.
+  //
+  // Publishing and picking up a new snapshot take a mutex. Between publishes
+  // a Reader only loads the version counter, so readers on many threads
+  // share no written memory and scale with the number of cores.
+  class DialoguePublisher
+  {
+  public:
+    class Reader;
+
+    // Builds a snapshot of the manager on the calling thread and publishes it.
+    DialogueSnapshotPtr publish(const DialogueManager &mgr);
+    void publish(DialogueSnapshotPtr snapshot);
+
+    // Null until the first publish.
+    DialogueSnapshotPtr current() const;
+    // Number of snapshots published so far.
+    uint64_t version() const { return _version.load(std::memory_order_acquire); }
+
+  private:
+    mutable std::mutex _mutex;
+    DialogueSnapshotPtr _current;
+    std::atomic<uint64_t> _version{0};
+  };
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //DialoguePublisher::Reader
+  // One per reader thread. Keeps the snapshot it last picked up alive and
+  // only goes back to the publisher once a newer one was published. The
+  // publisher must outlive its readers.
+  class DialoguePublisher::Reader
+  {
+  public:
+    explicit Reader(const DialoguePublisher &publisher) : _publisher(&publisher) {}
+
+    // The latest published snapshot, null before the first publish. Valid
+    // until the next call or until the reader is destroyed.
+    const DialogueSnapshot *snapshot();
+
+  private:
+    const DialoguePublisher *_publisher;
+    DialogueSnapshotPtr _snapshot;
+    uint64_t _version = 0;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
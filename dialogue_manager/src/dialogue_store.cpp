@@ -0,0 +1,147 @@
+#include "dialogue_store.hpp"
+
+namespace
+{
+    template <typename T>
+    uint32_t indexOf(const std::unordered_map<const T *, uint32_t> &indices, const T *node)
+    {
+        auto find = indices.find(node);
+        return find == indices.end() ? floofy::DialogueStore::NO_INDEX : find->second;
+    }
+
+    uint32_t lookup(const std::unordered_map<floofy::ID, uint32_t> &indices, floofy::ID id)
+    {
+        auto find = indices.find(id);
+        return find == indices.end() ? floofy::DialogueStore::NO_INDEX : find->second;
+    }
+
+    std::string_view text(const std::string &texts, const std::vector<uint32_t> &offsets, uint32_t index)
+    {
+        return std::string_view(texts).substr(offsets[index], offsets[index + 1] - offsets[index]);
+    }
+} // namespace
+
+namespace floofy
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueStore
+
+    DialogueStore::DialogueStore(const Dialogue &dialogue) : _name(dialogue.name)
+    {
+        const auto &participants = dialogue.participants;
+        const auto &entries = dialogue.entries;
+        const auto &choices = dialogue.choices;
+
+        std::unordered_map<const Participant *, uint32_t> participantIndices;
+        std::unordered_map<const DialogueEntry *, uint32_t> entryIndices;
+        std::unordered_map<const DialogueChoice *, uint32_t> choiceIndices;
+        participantIndices.reserve(participants.size());
+        entryIndices.reserve(entries.size());
+        choiceIndices.reserve(choices.size());
+
+        //Participants
+        _participantIds.reserve(participants.size());
+        _participantNameOffsets.reserve(participants.size() + 1);
+        _participantNameOffsets.push_back(0);
+        for (const auto &participant : participants)
+        {
+            participantIndices.emplace(participant, static_cast<uint32_t>(_participantIds.size()));
+            _participantIds.push_back(participant->id._id);
+            _participantNames += participant->name.view();
+            _participantNameOffsets.push_back(static_cast<uint32_t>(_participantNames.size()));
+        }
+
+        for (const auto &entry : entries)
+        {
+            entryIndices.emplace(entry, static_cast<uint32_t>(entryIndices.size()));
+        }
+
+        //Choices
+        _choiceIds.reserve(choices.size());
+        _choiceSrcs.reserve(choices.size());
+        _choiceDsts.reserve(choices.size());
+        _choiceTextOffsets.reserve(choices.size() + 1);
+        _choiceTextOffsets.push_back(0);
+        _choiceGuidAssigned.reserve(choices.size());
+        _choiceGuids.reserve(choices.size());
+        _choiceIndexById.reserve(choices.size());
+        for (const auto &choice : choices)
+        {
+            const auto index = static_cast<uint32_t>(_choiceIds.size());
+            choiceIndices.emplace(choice, index);
+            _choiceIndexById.emplace(choice->id, index);
+            _choiceIds.push_back(choice->id._id);
+            _choiceSrcs.push_back(indexOf(entryIndices, choice->src));
+            _choiceDsts.push_back(indexOf(entryIndices, choice->dst));
+            _choiceTexts += choice->choice.view();
+            _choiceTextOffsets.push_back(static_cast<uint32_t>(_choiceTexts.size()));
+            _choiceGuidAssigned.push_back(choice->guidAssigned ? 1 : 0);
+            _choiceGuids.push_back(choice->guid);
+        }
+
+        //Entries
+        _entryIds.reserve(entries.size());
+        _entryParticipants.reserve(entries.size());
+        _entryFirstChoice.reserve(entries.size() + 1);
+        _entryChoices.reserve(choices.size());
+        _entryTextOffsets.reserve(entries.size() + 1);
+        _entryTextOffsets.push_back(0);
+        _entryEditorData.reserve(entries.size());
+        _entryIndexById.reserve(entries.size());
+        for (const auto &entry : entries)
+        {
+            _entryIndexById.emplace(entry->id, static_cast<uint32_t>(_entryIds.size()));
+            _entryIds.push_back(entry->id._id);
+            _entryParticipants.push_back(indexOf(participantIndices, entry->activeParticipant));
+            _entryTexts += entry->entry.view();
+            _entryTextOffsets.push_back(static_cast<uint32_t>(_entryTexts.size()));
+            _entryEditorData.push_back({entry->viewPosition, entry->lReaction, entry->rReaction});
+
+            // Choices removed from the dialogue can still be listed by their
+            // source entry, those are left out.
+            _entryFirstChoice.push_back(static_cast<uint32_t>(_entryChoices.size()));
+            for (const auto &choice : entry->choices)
+            {
+                const auto index = indexOf(choiceIndices, choice);
+                if (index != NO_INDEX)
+                {
+                    _entryChoices.push_back(index);
+                }
+            }
+        }
+        _entryFirstChoice.push_back(static_cast<uint32_t>(_entryChoices.size()));
+    }
+
+    std::string_view DialogueStore::participantName(uint32_t participant) const
+    {
+        return text(_participantNames, _participantNameOffsets, participant);
+    }
+
+    uint32_t DialogueStore::entryIndex(ID id) const
+    {
+        return lookup(_entryIndexById, id);
+    }
+
+    std::string_view DialogueStore::entryText(uint32_t entry) const
+    {
+        return text(_entryTexts, _entryTextOffsets, entry);
+    }
+
+    DialogueStore::IndexRange DialogueStore::entryChoices(uint32_t entry) const
+    {
+        const uint32_t *choices = _entryChoices.data();
+        return IndexRange{choices + _entryFirstChoice[entry], choices + _entryFirstChoice[entry + 1]};
+    }
+
+    uint32_t DialogueStore::choiceIndex(ID id) const
+    {
+        return lookup(_choiceIndexById, id);
+    }
+
+    std::string_view DialogueStore::choiceText(uint32_t choice) const
+    {
+        return text(_choiceTexts, _choiceTextOffsets, choice);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
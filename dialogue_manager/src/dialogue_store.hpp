@@ -0,0 +1,99 @@
+#pragma once
+
+#include "dialogue_manager.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueStore
+  // Index based copy of a dialogue stored as parallel arrays. Participants,
+  // entries and choices are addressed by their index in the source dialogue
+  // and reference each other by index, so walking a conversation reads
+  // contiguous arrays instead of following node pointers. Data only the editor
+  // needs (view positions and reactions) is kept apart from the arrays used
+  // for traversal. The store is a snapshot and does not follow later edits.
+  class DialogueStore
+  {
+  public:
+    static constexpr uint32_t NO_INDEX = 0xFFFFFFFF;
+
+    struct IndexRange
+    {
+      const uint32_t *first = nullptr;
+      const uint32_t *last = nullptr;
+
+      const uint32_t *begin() const { return first; }
+      const uint32_t *end() const { return last; }
+      size_t size() const { return static_cast<size_t>(last - first); }
+      uint32_t operator[](size_t index) const { return first[index]; }
+    };
+
+    struct EntryEditorData
+    {
+      DialogueEntry::Vector2 viewPosition;
+      eReaction lReaction = eReaction::None;
+      eReaction rReaction = eReaction::None;
+    };
+
+    DialogueStore() = default;
+    explicit DialogueStore(const Dialogue &dialogue);
+
+    const std::string &name() const { return _name; }
+
+    size_t numParticipants() const { return _participantIds.size(); }
+    ID participantId(uint32_t participant) const { return ID{_participantIds[participant]}; }
+    std::string_view participantName(uint32_t participant) const;
+
+    size_t numEntries() const { return _entryIds.size(); }
+    uint32_t entryIndex(ID id) const;
+    ID entryId(uint32_t entry) const { return ID{_entryIds[entry]}; }
+    uint32_t entryParticipant(uint32_t entry) const { return _entryParticipants[entry]; }
+    std::string_view entryText(uint32_t entry) const;
+    IndexRange entryChoices(uint32_t entry) const;
+    const EntryEditorData &entryEditorData(uint32_t entry) const { return _entryEditorData[entry]; }
+
+    size_t numChoices() const { return _choiceIds.size(); }
+    uint32_t choiceIndex(ID id) const;
+    ID choiceId(uint32_t choice) const { return ID{_choiceIds[choice]}; }
+    uint32_t choiceSrc(uint32_t choice) const { return _choiceSrcs[choice]; }
+    uint32_t choiceDst(uint32_t choice) const { return _choiceDsts[choice]; }
+    std::string_view choiceText(uint32_t choice) const;
+    bool choiceGuidAssigned(uint32_t choice) const { return _choiceGuidAssigned[choice] != 0; }
+    const Guid &choiceGuid(uint32_t choice) const { return _choiceGuids[choice]; }
+
+  private:
+    std::string _name;
+
+    //Participants
+    std::vector<size_t> _participantIds;
+    std::vector<uint32_t> _participantNameOffsets;
+    std::string _participantNames;
+
+    //Entries, entry i's choices are _entryChoices[_entryFirstChoice[i], _entryFirstChoice[i + 1])
+    std::vector<size_t> _entryIds;
+    std::vector<uint32_t> _entryParticipants;
+    std::vector<uint32_t> _entryFirstChoice;
+    std::vector<uint32_t> _entryChoices;
+    std::vector<uint32_t> _entryTextOffsets;
+    std::string _entryTexts;
+    std::vector<EntryEditorData> _entryEditorData;
+    std::unordered_map<ID, uint32_t> _entryIndexById;
+
+    //Choices
+    std::vector<size_t> _choiceIds;
+    std::vector<uint32_t> _choiceSrcs;
+    std::vector<uint32_t> _choiceDsts;
+    std::vector<uint32_t> _choiceTextOffsets;
+    std::string _choiceTexts;
+    std::vector<uint8_t> _choiceGuidAssigned;
+    std::vector<Guid> _choiceGuids;
+    std::unordered_map<ID, uint32_t> _choiceIndexById;
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
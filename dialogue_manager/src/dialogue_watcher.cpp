@@ -0,0 +1,95 @@
+#include "dialogue_watcher.hpp"
+
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace floofy
+{
+    /////////////////////////////////////////////////////////////////////////////
+    //DialogueFileWatcher
+
+    DialogueFileWatcherPtr DialogueFileWatcher::open(const std::string &filePath)
+    {
+        DialogueFileWatcherPtr watcher(new DialogueFileWatcher);
+        watcher->_path = std::filesystem::absolute(filePath);
+
+#ifdef __linux__
+        watcher->_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watcher->_fd < 0)
+        {
+            return nullptr;
+        }
+
+        // Editors often save by writing a temporary file and renaming it over
+        // the original, which a watch on the file itself would not survive.
+        // Creation is not watched, a new file is reported once it has been
+        // written and closed rather than while it is still empty.
+        const auto directory = watcher->_path.parent_path();
+        if (inotify_add_watch(watcher->_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            return nullptr;
+        }
+#else
+        std::error_code ec;
+        if (!std::filesystem::is_directory(watcher->_path.parent_path(), ec))
+        {
+            return nullptr;
+        }
+        watcher->_writeTime = std::filesystem::last_write_time(watcher->_path, ec);
+        watcher->_size = std::filesystem::file_size(watcher->_path, ec);
+#endif
+
+        return watcher;
+    }
+
+    DialogueFileWatcher::~DialogueFileWatcher()
+    {
+#ifdef __linux__
+        if (_fd >= 0)
+        {
+            close(_fd);
+        }
+#endif
+    }
+
+    bool DialogueFileWatcher::changed()
+    {
+#ifdef __linux__
+        const auto fileName = _path.filename().native();
+        bool changed = false;
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(_fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto event = reinterpret_cast<const inotify_event *>(buffer + offset);
+                if (event->len != 0 && fileName == event->name)
+                {
+                    changed = true;
+                }
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+        return changed;
+#else
+        std::error_code ec;
+        const auto writeTime = std::filesystem::last_write_time(_path, ec);
+        const auto size = std::filesystem::file_size(_path, ec);
+        if (writeTime == _writeTime && size == _size)
+        {
+            return false;
+        }
+
+        _writeTime = writeTime;
+        _size = size;
+        return true;
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace floofy
+{
+  /////////////////////////////////////////////////////////////////////////////
+  //Forward Decls
+  class DialogueFileWatcher;
+  using DialogueFileWatcherPtr = std::unique_ptr<DialogueFileWatcher>;
+  /////////////////////////////////////////////////////////////////////////////
+
+  /////////////////////////////////////////////////////////////////////////////
+  //DialogueFileWatcher
+  // Tells whether a dialogue file was written since it was last asked, for
+  // hot-reloading it with DialogueManager::reloadFromFile. Polled from the
+  // thread owning the manager, nothing runs in the background.
+  //
+  // On Linux the file's directory is watched with inotify, so a poll is one
+  // non-blocking read and editors replacing the file through a rename are
+  // seen too. Elsewhere each poll compares the file's write time and size.
+  class DialogueFileWatcher
+  {
+  public:
+    // nullptr when the file's directory cannot be watched.
+    static DialogueFileWatcherPtr open(const std::string &filePath);
+
+    DialogueFileWatcher(const DialogueFileWatcher &) = delete;
+    DialogueFileWatcher &operator=(const DialogueFileWatcher &) = delete;
+    ~DialogueFileWatcher();
+
+    // Whether the file was written, created or replaced since the previous
+    // call or since the watcher was opened.
+    bool changed();
+
+  private:
+    DialogueFileWatcher() = default;
+
+    std::filesystem::path _path;
+#ifdef __linux__
+    int _fd = -1;
+#else
+    std::filesystem::file_time_type _writeTime;
+    std::uintmax_t _size = 0;
+#endif
+  };
+  /////////////////////////////////////////////////////////////////////////////
+} // namespace floofy